@@ -0,0 +1,791 @@
+// Loopback throughput benchmark for the native build.
+//
+// Runs the firmware (setup() + loop()) in-process against the mock camera,
+// then drives /stream and /jpg with many concurrent clients and reports fps,
+// latency percentiles and bytes/s per endpoint.
+//
+//   pio run -e native && .pio/build/native/program --streams 4 --jpg 2 --seconds 10
+//
+// Stream latency is capture -> fully received (X-Timestamp of the part, same
+// clock as esp_timer_get_time() in this process); RTSP latency is capture ->
+// last RTP packet of the frame; /jpg latency is the request round trip. With
+// --poll the /jpg clients send If-None-Match with the last ETag, like snapshot
+// pollers, and 304s are counted apart. --ws adds /ws/stream clients that grant
+// one credit per frame received; each opens with a LONG_MAX grant (32- and
+// 64-bit), which must clamp to WS_MAX_CREDITS (stats messages over it count as
+// errors; build with -fsanitize=undefined to catch a wrapping add).
+// --rtsp / --rtsp-tcp add RTSP clients
+// (RTP over UDP / interleaved) whose frames are rebuilt and decoded. The
+// firmware's RTSP_PORT is 8554 in the native env. MOCK_CAM_FPS / MOCK_CAM_DIR
+// select the camera source.
+//
+// --abr turns the rate controller on first and samples its state every
+// second; with --rate the stream clients are only throttled for the first
+// half, and the run fails unless the controller is stepping back up (or
+// holding the configured q/fs) at the end. --sndbuf B sets NOZZLE_SNDBUF,
+// which caps each TCP sendmsg like lwIP's ~5.7 KB send buffer, so no frame
+// ever goes out in one call.
+//
+//   program --json [--seconds S]
+// skips the firmware and exercises json_tok.h instead: a model-based fuzz
+// (random objects must read back member for member; random byte mutations
+// must fail cleanly with an in-range offset) and parse throughput against the
+// old String::indexOf() scan. Build with -fsanitize=address to catch overreads.
+//
+//   program --motion [--seconds S]
+// checks the motion metric pieces: motion_diff_swar() against the per-byte
+// reference on random thumbnails (must match exactly), both kernels' speed,
+// and the 1/8-scale DC decode (JPEGDEC) of frames from the mock encoder
+// against the known block means.
+#include <Arduino.h>
+#include "lwip/sockets.h"
+#include "json_tok.h"
+#include "motion_diff.h"
+#include "mock_jpeg.h"
+#include "rtp_jpeg.h"
+#include <JPEGDEC.h>
+#include <signal.h>
+#include <atomic>
+#include <random>
+#include <thread>
+#include <vector>
+
+void setup();
+void loop();
+
+namespace {
+
+struct Opts {
+  int         streams  = 4;
+  int         jpg      = 1;
+  int         seconds  = 10;
+  int         port     = 8089;
+  const char* query    = "";       // extra /stream query, e.g. "mode=live&fps=10"
+  int         rate_kBps = 0;       // per-stream receive cap (0 = read as fast as possible)
+  bool        poll     = false;    // /jpg clients revalidate with If-None-Match
+  int         ws       = 0;        // /ws/stream clients
+  int         rtsp     = 0;        // RTSP clients, RTP over UDP
+  int         rtsp_tcp = 0;        // RTSP clients, RTP interleaved on the RTSP connection
+  int         rtsp_port = 8554;
+  bool        json     = false;    // json_tok.h fuzz + throughput instead of HTTP
+  bool        motion   = false;    // motion kernels + DC decode instead of HTTP
+  bool        abr      = false;    // enable ABR, throttle only the first half, expect recovery
+  int         sndbuf   = 0;        // lwIP-like TCP send buffer in the shim (0 = host kernel)
+};
+
+struct Stats {
+  std::vector<uint32_t> lat_us;
+  uint64_t              bytes  = 0;
+  uint32_t              frames = 0;
+  uint32_t              errors = 0;
+  uint32_t              not_modified = 0;   // /jpg 304s
+  uint32_t              lost = 0;           // RTP sequence gaps
+};
+
+std::atomic<bool> g_stop{false};
+std::atomic<bool> g_unthrottle{false};
+
+int dial(int port){
+  int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+  sockaddr_in a = {}; a.sin_family = AF_INET; a.sin_port = htons(port);
+  a.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  if (::connect(fd, (sockaddr*)&a, sizeof(a)) < 0){ ::close(fd); return -1; }
+  timeval tv = { 2, 0 };
+  setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+  return fd;
+}
+
+// Minimal buffered reader over a blocking socket.
+struct Reader {
+  explicit Reader(int f) : fd(f) {}
+  int    fd;
+  char   buf[16384];
+  size_t pos = 0, end = 0;
+  bool fill(){
+    if (pos == end){ pos = end = 0; }
+    ssize_t n = ::recv(fd, buf + end, sizeof(buf) - end, 0);
+    if (n <= 0) return false;
+    end += n; return true;
+  }
+  bool line(std::string& out){
+    out.clear();
+    for (;;){
+      while (pos < end){
+        char c = buf[pos++];
+        if (c == '\n'){ if (!out.empty() && out.back() == '\r') out.pop_back(); return true; }
+        out += c;
+      }
+      if (!fill()) return false;
+    }
+  }
+  bool read(void* out, size_t n){
+    uint8_t* o = (uint8_t*)out;
+    while (n){
+      if (pos == end && !fill()) return false;
+      size_t k = std::min(n, end - pos);
+      memcpy(o, buf + pos, k); pos += k; o += k; n -= k;
+    }
+    return true;
+  }
+  bool skip(size_t n, uint64_t& counted){
+    while (n){
+      if (pos == end && !fill()) return false;
+      size_t k = std::min(n, end - pos);
+      pos += k; n -= k; counted += k;
+    }
+    return true;
+  }
+};
+
+int64_t header_ts_us(const std::string& v){
+  double t = atof(v.c_str());
+  return (int64_t)(t * 1e6);
+}
+
+void stream_client(const Opts& o, Stats& st){
+  int fd = dial(o.port);
+  if (fd < 0){ st.errors++; return; }
+  if (o.rate_kBps && !o.abr){                                 // a tiny window stays tiny after --abr unthrottles
+    int rcv = 4096; setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &rcv, sizeof(rcv));
+  }
+  char req[256];
+  int n = snprintf(req, sizeof(req), "GET /stream%s%s HTTP/1.1\r\nHost: bench\r\n\r\n", *o.query ? "?" : "", o.query);
+  ::send(fd, req, n, MSG_NOSIGNAL);
+
+  Reader r(fd);
+  std::string l;
+  if (!r.line(l) || l.find(" 200 ") == std::string::npos){ st.errors++; ::close(fd); return; }
+  while (r.line(l) && !l.empty()){}                         // response headers
+
+  int64_t t_start = esp_timer_get_time();
+  while (!g_stop){
+    size_t len = 0; int64_t ts = 0;
+    while (r.line(l)){
+      if (l.empty()){ if (len) break; else continue; }      // blank line ends the part headers
+      if (!strncasecmp(l.c_str(), "Content-Length:", 15)) len = strtoul(l.c_str() + 15, nullptr, 10);
+      else if (!strncasecmp(l.c_str(), "X-Timestamp:", 12)) ts = header_ts_us(l.substr(12));
+    }
+    if (!len){ st.errors++; break; }
+    if (!r.skip(len, st.bytes)){ st.errors++; break; }
+    int64_t now = esp_timer_get_time();
+    st.frames++;
+    if (ts) st.lat_us.push_back((uint32_t)(now - ts));
+    if (o.rate_kBps && !g_unthrottle){                       // emulate a slow link
+      int64_t due = t_start + (int64_t)(st.bytes * 1000 / o.rate_kBps);
+      if (due > now) std::this_thread::sleep_for(std::chrono::microseconds(due - now));
+    }
+  }
+  ::close(fd);
+}
+
+void jpg_client(const Opts& o, Stats& st){
+  std::string etag;
+  while (!g_stop){
+    int64_t t0 = esp_timer_get_time();
+    int fd = dial(o.port);
+    if (fd < 0){ st.errors++; delay(10); continue; }
+    char req[128];
+    int n = snprintf(req, sizeof(req), "GET /jpg HTTP/1.1\r\nHost: bench\r\n%s%s%s\r\n",
+                     etag.empty() ? "" : "If-None-Match: ", etag.c_str(), etag.empty() ? "" : "\r\n");
+    ::send(fd, req, n, MSG_NOSIGNAL);
+    Reader r(fd);
+    std::string l; size_t len = 0;
+    bool ok  = r.line(l) && (l.find(" 200 ") != std::string::npos || l.find(" 304 ") != std::string::npos);
+    bool nm  = ok && l.find(" 304 ") != std::string::npos;
+    while (ok && r.line(l) && !l.empty()){
+      if (!strncasecmp(l.c_str(), "Content-Length:", 15)) len = strtoul(l.c_str() + 15, nullptr, 10);
+      else if (o.poll && !strncasecmp(l.c_str(), "ETag:", 5)) etag = l.substr(l.find('"'));
+    }
+    ok = ok && (nm || (len && r.skip(len, st.bytes)));
+    ::close(fd);
+    if (!ok){ st.errors++; continue; }
+    if (nm) st.not_modified++; else st.frames++;
+    st.lat_us.push_back((uint32_t)(esp_timer_get_time() - t0));
+  }
+}
+
+// ---- /ws/stream ----
+// A short masked text message, as a browser sends it.
+void ws_text(int fd, const char* msg){
+  size_t  n = strlen(msg);
+  uint8_t b[2 + 4 + 125] = { 0x81, (uint8_t)(0x80 | n), 0x12, 0x34, 0x56, 0x78 };
+  for (size_t i = 0; i < n; i++) b[6 + i] = msg[i] ^ b[2 + (i & 3)];
+  ::send(fd, b, 6 + n, MSG_NOSIGNAL);
+}
+
+void ws_client(const Opts& o, Stats& st){
+  int fd = dial(o.port);
+  if (fd < 0){ st.errors++; return; }
+  char req[256];
+  int n = snprintf(req, sizeof(req), "GET /ws/stream?credits=2 HTTP/1.1\r\nHost: bench\r\nUpgrade: websocket\r\n"
+                   "Connection: Upgrade\r\nSec-WebSocket-Key: dGhlIHNhbXBsZSBub25jZQ==\r\nSec-WebSocket-Version: 13\r\n\r\n");
+  ::send(fd, req, n, MSG_NOSIGNAL);
+  Reader r(fd);
+  std::string l;
+  if (!r.line(l) || l.find(" 101 ") == std::string::npos){ st.errors++; ::close(fd); return; }
+  while (r.line(l) && !l.empty()){}
+  ws_text(fd, "{\"credit\":2147483647}");                      // LONG_MAX on the device: must clamp, not wrap
+  ws_text(fd, "{\"credit\":9223372036854775807}");             // same on the host
+
+  while (!g_stop){
+    uint8_t h[8];
+    if (!r.read(h, 2)){ st.errors++; break; }
+    uint8_t  op  = h[0] & 0x0F;
+    uint64_t len = h[1] & 0x7F;
+    if (len == 126){ if (!r.read(h, 2)){ st.errors++; break; } len = (uint64_t)h[0] << 8 | h[1]; }
+    else if (len == 127){ if (!r.read(h, 8)){ st.errors++; break; } len = 0; for (int i = 0; i < 8; i++) len = len << 8 | h[i]; }
+    if (op == 0x2){                                          // seq u32, ts_us u64, w, h; then the JPEG
+      uint8_t pre[16];
+      if (len < 16 || !r.read(pre, 16) || !r.skip(len - 16, st.bytes)){ st.errors++; break; }
+      uint64_t ts = 0;
+      for (int i = 0; i < 8; i++) ts |= (uint64_t)pre[4 + i] << (8 * i);
+      st.frames++;
+      st.lat_us.push_back((uint32_t)(esp_timer_get_time() - (int64_t)ts));
+      ws_text(fd, "{\"credit\":1}");
+    } else {
+      std::string t(len, '\0');
+      if (!r.read(&t[0], len)){ st.errors++; break; }
+      size_t c = t.find("\"credits\":");
+      if (t.find("\"type\":\"stats\"") != std::string::npos && c != std::string::npos &&
+          atoi(t.c_str() + c + 10) > 8) st.errors++;                // WS_MAX_CREDITS
+    }
+  }
+  ::close(fd);
+}
+
+// One request, whole response body (the shim closes after each request).
+std::string http(int port, const char* method, const char* path, const char* body){
+  int fd = dial(port);
+  if (fd < 0) return "";
+  char req[512];
+  int n = snprintf(req, sizeof(req), "%s %s HTTP/1.1\r\nHost: bench\r\nContent-Type: application/json\r\n"
+                   "Content-Length: %zu\r\n\r\n%s", method, path, strlen(body), body);
+  ::send(fd, req, n, MSG_NOSIGNAL);
+  std::string r; char b[2048]; ssize_t k;
+  while ((k = ::recv(fd, b, sizeof(b), 0)) > 0) r.append(b, k);
+  ::close(fd);
+  size_t h = r.find("\r\n\r\n");
+  return h == std::string::npos ? "" : r.substr(h + 4);
+}
+
+// "state", "fs", "q" of the "rate" object in /api/settings.
+struct AbrState {
+  std::string state, fs; int q = -1;
+  int rung() const {                                          // higher = better picture
+    static const char* FS[] = { "QQVGA", "QVGA", "VGA", "SVGA", "XGA", "SXGA", "UXGA" };
+    int i = 0; while (i < 7 && fs != FS[i]) i++;
+    return i * 64 + (63 - q);
+  }
+};
+AbrState abr_sample(int port){
+  AbrState a;
+  std::string j = http(port, "GET", "/api/settings", "");
+  size_t r = j.find("\"rate\":{");
+  if (r == std::string::npos) return a;
+  auto str = [&](const char* k){
+    size_t p = j.find(k, r); if (p == std::string::npos) return std::string();
+    p += strlen(k); return j.substr(p, j.find('"', p) - p);
+  };
+  a.state = str("\"state\":\""); a.fs = str("\"fs\":\"");
+  size_t q = j.find("\"q\":", r);
+  if (q != std::string::npos) a.q = atoi(j.c_str() + q + 4);
+  return a;
+}
+
+// ---- RTSP (RTP/JPEG) ----
+// A minimal RTSP client: OPTIONS, DESCRIBE, SETUP (UDP or interleaved TCP),
+// PLAY, TEARDOWN. Fragments are reassembled per RTP timestamp; each complete
+// frame gets its JPEG headers rebuilt as in RFC 2435 appendix A (tables from
+// the packet, standard Huffman tables) and is decoded at 1/8 scale, so every
+// counted frame is a valid image of the announced size. Latency is capture ->
+// last packet, mapped through the RTP-Info rtptime of the PLAY reply.
+struct RtpRx {
+  bool                 open = false, broken = false;
+  uint32_t             ts = 0, next = 0;
+  uint8_t              type = 0, w8 = 0, h8 = 0;
+  uint16_t             dri = 0;
+  uint8_t              q[128];
+  std::vector<uint8_t> scan;
+  int32_t              last_seq = -1;
+  uint32_t             lost = 0;
+};
+
+std::vector<uint8_t> rtp_jpeg_rebuild(const RtpRx& r){
+  using namespace mock_jpeg;
+  std::vector<uint8_t> o;
+  auto u8  = [&](int v){ o.push_back((uint8_t)v); };
+  auto u16 = [&](int v){ u8(v >> 8); u8(v & 0xFF); };
+  int w = r.w8 * 8, h = r.h8 * 8;
+  u16(0xFFD8);
+  u16(0xFFDB); u16(2 + 65 * 2);
+  u8(0); o.insert(o.end(), r.q, r.q + 64);
+  u8(1); o.insert(o.end(), r.q + 64, r.q + 128);
+  if (r.dri){ u16(0xFFDD); u16(4); u16(r.dri); }
+  u16(0xFFC0); u16(17); u8(8); u16(h); u16(w); u8(3);
+  u8(1); u8((r.type & 63) == 0 ? 0x21 : 0x22); u8(0);  u8(2); u8(0x11); u8(1);  u8(3); u8(0x11); u8(1);
+  auto dht = [&](int cls_id, const uint8_t* bits, const uint8_t* vals){
+    int n = 0; for (int i = 0; i < 16; i++) n += bits[i];
+    u16(0xFFC4); u16(2 + 1 + 16 + n); u8(cls_id);
+    o.insert(o.end(), bits, bits + 16); o.insert(o.end(), vals, vals + n);
+  };
+  dht(0x00, kDcLumBits, kDcVals); dht(0x10, kAcLumBits, kAcLumVals);
+  dht(0x01, kDcChrBits, kDcVals); dht(0x11, kAcChrBits, kAcChrVals);
+  u16(0xFFDA); u16(12); u8(3); u8(1); u8(0x00); u8(2); u8(0x11); u8(3); u8(0x11); u8(0); u8(63); u8(0);
+  o.insert(o.end(), r.scan.begin(), r.scan.end());
+  u16(0xFFD9);
+  return o;
+}
+
+int rtsp_draw(JPEGDRAW*){ return 1; }
+
+// One RTP packet; true when it completed a frame that decoded.
+bool rtp_rx_packet(RtpRx& r, const uint8_t* p, size_t n, Stats& st){
+  if (n < RTP_HDR + 8 || (p[0] & 0xC0) != 0x80 || (p[1] & 0x7F) != RTP_JPEG_PT){ st.errors++; return false; }
+  uint16_t seq = p[2] << 8 | p[3];
+  uint32_t ts  = (uint32_t)p[4] << 24 | p[5] << 16 | p[6] << 8 | p[7];
+  bool     mark = p[1] & 0x80;
+  if (r.last_seq >= 0 && seq != (uint16_t)(r.last_seq + 1)) r.lost += (uint16_t)(seq - r.last_seq - 1);
+  r.last_seq = seq;
+  const uint8_t* j = p + RTP_HDR;
+  uint32_t off = j[1] << 16 | j[2] << 8 | j[3];
+  size_t   hl  = RTP_HDR + 8;
+  if (!r.open || ts != r.ts){                                 // new frame; an unfinished one is lost
+    r.open = true; r.broken = false; r.ts = ts; r.next = 0; r.scan.clear();
+  }
+  r.type = j[4]; r.w8 = j[6]; r.h8 = j[7];
+  if (r.type >= 64){ r.dri = p[hl] << 8 | p[hl + 1]; hl += 4; } else r.dri = 0;
+  if (off == 0 && j[5] >= 128){
+    if (n < hl + 4 + 128 || p[hl + 3] != 128){ r.broken = true; return false; }
+    memcpy(r.q, p + hl + 4, 128);
+    hl += 4 + 128;
+  }
+  if (off != r.next) r.broken = true;
+  r.scan.insert(r.scan.end(), p + hl, p + n);
+  r.next = off + (uint32_t)(n - hl);
+  if (!mark) return false;
+  r.open = false;
+  if (r.broken) return false;
+  std::vector<uint8_t> jpg = rtp_jpeg_rebuild(r);
+  JPEGDEC dec;
+  bool ok = dec.openRAM(jpg.data(), (int)jpg.size(), rtsp_draw);
+  dec.setPixelType(EIGHT_BIT_GRAYSCALE);
+  ok = ok && dec.getWidth() == r.w8 * 8 && dec.decode(0, 0, JPEG_SCALE_EIGHTH);
+  if (!ok){ st.errors++; return false; }
+  st.bytes += jpg.size();
+  return true;
+}
+
+// Request + response head (and body); the value of `want` header if asked.
+bool rtsp_do(int fd, Reader& r, int& cseq, const char* method, const std::string& url, const std::string& extra,
+             std::string* body, const char* want = nullptr, std::string* val = nullptr){
+  char req[512];
+  int n = snprintf(req, sizeof(req), "%s %s RTSP/1.0\r\nCSeq: %d\r\nUser-Agent: nozzlecam-bench\r\n%s\r\n",
+                   method, url.c_str(), ++cseq, extra.c_str());
+  ::send(fd, req, n, MSG_NOSIGNAL);
+  std::string l;
+  uint64_t skipped = 0;
+  for (;;){                                                   // interleaved packets still in flight
+    if (r.pos == r.end && !r.fill()) return false;
+    if (r.buf[r.pos] != '$') break;
+    uint8_t h[4];
+    for (int i = 0; i < 4; i++){ if (r.pos == r.end && !r.fill()) return false; h[i] = (uint8_t)r.buf[r.pos++]; }
+    if (!r.skip(h[2] << 8 | h[3], skipped)) return false;
+  }
+  if (!r.line(l) || l.find(" 200 ") == std::string::npos){ fprintf(stderr, "rtsp %s: %s\n", method, l.c_str()); return false; }
+  size_t len = 0;
+  while (r.line(l) && !l.empty()){
+    if (!strncasecmp(l.c_str(), "Content-Length:", 15)) len = strtoul(l.c_str() + 15, nullptr, 10);
+    if (want && !strncasecmp(l.c_str(), want, strlen(want)) && l[strlen(want)] == ':') *val = l.substr(strlen(want) + 1);
+  }
+  std::string b(len, '\0');
+  for (size_t i = 0; i < len; i++){
+    if (r.pos == r.end && !r.fill()) return false;
+    b[i] = r.buf[r.pos++];
+  }
+  if (body) *body = b;
+  return true;
+}
+
+void rtsp_client(const Opts& o, Stats& st, bool tcp){
+  int fd = dial(o.rtsp_port);
+  if (fd < 0){ st.errors++; return; }
+  Reader r(fd);
+  int cseq = 0;
+  std::string url = "rtsp://127.0.0.1:" + std::to_string(o.rtsp_port) + "/", sdp, sess, info;
+  int udp = -1;
+  bool ok = rtsp_do(fd, r, cseq, "OPTIONS", url, "", nullptr) &&
+            rtsp_do(fd, r, cseq, "DESCRIBE", url, "Accept: application/sdp\r\n", &sdp);
+  if (ok && sdp.find("JPEG/90000") == std::string::npos){ fprintf(stderr, "rtsp: SDP without JPEG/90000\n"); ok = false; }
+  std::string transport = "RTP/AVP/TCP;unicast;interleaved=0-1";
+  if (ok && !tcp){
+    udp = ::socket(AF_INET, SOCK_DGRAM, 0);
+    sockaddr_in a = {}; a.sin_family = AF_INET; a.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t al = sizeof(a);
+    int rcv = 4 << 20; setsockopt(udp, SOL_SOCKET, SO_RCVBUF, &rcv, sizeof(rcv));
+    timeval tv = { 0, 200000 }; setsockopt(udp, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    ::bind(udp, (sockaddr*)&a, sizeof(a)); getsockname(udp, (sockaddr*)&a, &al);
+    int p = ntohs(a.sin_port);
+    transport = "RTP/AVP;unicast;client_port=" + std::to_string(p) + "-" + std::to_string(p + 1);
+  }
+  ok = ok && rtsp_do(fd, r, cseq, "SETUP", url + "track1", "Transport: " + transport + "\r\n", nullptr, "Session", &sess);
+  sess = sess.substr(sess.find_first_not_of(' '), sess.find(';') - sess.find_first_not_of(' '));
+  ok = ok && rtsp_do(fd, r, cseq, "PLAY", url, "Session: " + sess + "\r\nRange: npt=0.000-\r\n", nullptr, "RTP-Info", &info);
+  if (!ok){ st.errors++; if (udp >= 0) ::close(udp); ::close(fd); return; }
+  int64_t  t_play = esp_timer_get_time();
+  size_t   rt = info.find("rtptime=");
+  uint32_t rtptime = rt == std::string::npos ? 0 : (uint32_t)strtoul(info.c_str() + rt + 8, nullptr, 10);
+
+  RtpRx rx;
+  std::vector<uint8_t> pkt(65536);
+  while (!g_stop){
+    size_t n = 0;
+    if (tcp){
+      uint8_t h[4];
+      bool got = true;
+      for (int i = 0; i < 4 && got; i++){ if (r.pos == r.end && !r.fill()) got = false; else h[i] = (uint8_t)r.buf[r.pos++]; }
+      if (!got || h[0] != '$'){ st.errors++; break; }
+      n = h[2] << 8 | h[3];
+      for (size_t i = 0; i < n && got; i++){ if (r.pos == r.end && !r.fill()) got = false; else pkt[i] = (uint8_t)r.buf[r.pos++]; }
+      if (!got){ st.errors++; break; }
+      if (h[1] != 0) continue;                                // RTCP channel
+    } else {
+      ssize_t k = ::recv(udp, pkt.data(), pkt.size(), 0);
+      if (k <= 0) continue;
+      n = (size_t)k;
+    }
+    if (!rtp_rx_packet(rx, pkt.data(), n, st)) continue;
+    st.frames++;
+    int64_t cap = t_play + (int64_t)(int32_t)(rx.ts - rtptime) * 100 / 9;
+    st.lat_us.push_back((uint32_t)std::max<int64_t>(0, esp_timer_get_time() - cap));
+  }
+  st.lost += rx.lost;
+  rtsp_do(fd, r, cseq, "TEARDOWN", url, "Session: " + sess + "\r\n", nullptr);
+  if (udp >= 0) ::close(udp);
+  ::close(fd);
+}
+
+uint32_t pct(std::vector<uint32_t>& v, double p){
+  if (v.empty()) return 0;
+  size_t i = (size_t)(p * (v.size() - 1) + 0.5);
+  std::nth_element(v.begin(), v.begin() + i, v.end());
+  return v[i];
+}
+
+void report(const char* name, std::vector<Stats>& per, double secs){
+  if (per.empty()) return;
+  Stats all;
+  double fps_min = 1e9, fps_max = 0;
+  for (auto& s : per){
+    all.bytes += s.bytes; all.frames += s.frames; all.errors += s.errors; all.not_modified += s.not_modified; all.lost += s.lost;
+    all.lat_us.insert(all.lat_us.end(), s.lat_us.begin(), s.lat_us.end());
+    double f = s.frames / secs;
+    fps_min = std::min(fps_min, f); fps_max = std::max(fps_max, f);
+  }
+  printf("%-8s clients=%-3zu fps/client avg=%.1f min=%.1f max=%.1f  total=%.1f fps  %.1f kB/s  errors=%u\n",
+         name, per.size(), all.frames / secs / per.size(), fps_min, fps_max, all.frames / secs,
+         all.bytes / secs / 1024.0, (unsigned)all.errors);
+  printf("         latency ms p50=%.1f p90=%.1f p99=%.1f max=%.1f (n=%zu)\n",
+         pct(all.lat_us, 0.50) / 1000.0, pct(all.lat_us, 0.90) / 1000.0,
+         pct(all.lat_us, 0.99) / 1000.0, pct(all.lat_us, 1.0) / 1000.0, all.lat_us.size());
+  if (all.lost) printf("         RTP packets lost: %u\n", (unsigned)all.lost);
+  if (all.not_modified) printf("         304 not modified: %u (%.1f/s)\n", (unsigned)all.not_modified, all.not_modified / secs);
+}
+
+void usage(){
+  printf("bench [--streams N] [--jpg N] [--seconds S] [--port P] [--query 'mode=live&fps=10'] [--rate kB/s] [--poll]\n"
+         "      [--ws N]   (/ws/stream clients, one credit per frame)\n"
+         "      [--rtsp N] [--rtsp-tcp N] [--rtsp-port P]   (RTP/JPEG clients, UDP / interleaved)\n"
+         "      [--abr] [--sndbuf B]   (rate controller on, --rate for the first half only; must step back up)\n"
+         "bench --json [--seconds S]   (json_tok.h fuzz + throughput, no firmware)\n"
+         "bench --motion [--seconds S] (motion kernels: SWAR vs reference, DC decode)\n"
+         "env: MOCK_CAM_FPS (default 25), MOCK_CAM_DIR (replay *.jpg)\n");
+}
+
+// ---- json_tok.h ----
+struct Member { std::string key; JsonVal::Type type; long i; std::string s; };
+
+// Random flat object with random whitespace; `want` gets what a reader must see.
+std::string json_random(std::mt19937& rng, std::vector<Member>& want){
+  static const char* WS[] = { "", " ", "\n", "\t ", "\r\n  " };
+  auto ws = [&]{ return std::string(WS[rng() % 5]); };
+  auto rstr = [&](size_t max){
+    static const char* PARTS[] = { "a", "Z", "_", "7", " ", "\\\"", "\\\\", "\\n", "\\u00e9", "\\/", "\xc3\xa9" };
+    std::string s; size_t n = rng() % (max + 1);
+    for (size_t k = 0; k < n; k++) s += PARTS[rng() % 11];
+    return s;
+  };
+  want.clear();
+  std::string o = ws() + "{";
+  int n = rng() % 24;
+  for (int k = 0; k < n; k++){
+    Member m; m.key = rstr(12); m.i = 0;
+    o += (k ? "," : "") + ws() + "\"" + m.key + "\"" + ws() + ":" + ws();
+    switch (rng() % 5){
+      case 0: { m.type = JsonVal::NUM; m.i = (long)(int32_t)rng() >> (rng() % 31); o += std::to_string(m.i); break; }
+      case 1: { m.type = JsonVal::STR; m.s = rstr(20); o += "\"" + m.s + "\""; break; }
+      case 2: { m.type = JsonVal::BOOL; m.i = rng() & 1; o += m.i ? "true" : "false"; break; }
+      case 3: { m.type = JsonVal::NUL; o += "null"; break; }
+      default:{ m.type = JsonVal::NUM; m.i = LONG_MIN; o += "-1.5e" + std::to_string(rng() % 9); break; }   // non-integer
+    }
+    o += ws();
+    want.push_back(m);
+  }
+  return o + "}" + ws();
+}
+
+int json_main(int seconds){
+  std::mt19937 rng(12345);
+  std::vector<Member> want;
+  uint64_t cases = 0, mutated = 0, accepted = 0, bad = 0;
+  int64_t  t_end = esp_timer_get_time() + (int64_t)seconds * 500000;     // half the time: fuzz
+  while (esp_timer_get_time() < t_end){
+    std::string txt = json_random(rng, want);
+    // 1) valid input reads back member for member
+    size_t got = 0; bool same = true;
+    JsonErr err = {};
+    bool ok = json_object_each(txt.data(), txt.size(), [&](const char* k, size_t kl, const JsonVal& v) -> const char* {
+      if (got >= want.size()){ same = false; return "extra"; }
+      const Member& m = want[got++];
+      if (m.key != std::string(k, kl) || m.type != v.type) same = false;
+      else if (m.type == JsonVal::NUM && m.i != LONG_MIN && (!v.is_int || v.i != m.i)) same = false;
+      else if (m.type == JsonVal::NUM && m.i == LONG_MIN && v.is_int) same = false;
+      else if (m.type == JsonVal::STR && m.s != std::string(v.s, v.len)) same = false;
+      else if (m.type == JsonVal::BOOL && m.i != v.i) same = false;
+      return nullptr;
+    }, &err);
+    if (!ok || !same || got != want.size()){
+      if (bad++ < 5) printf("MISMATCH (%s at %zu): %s\n", ok ? "content" : err.msg, err.pos, txt.c_str());
+    }
+    cases++;
+
+    // 2) mutations: never read past the end, errors point inside the input
+    for (int r = 0; r < 4; r++){
+      std::string m = txt;
+      int edits = 1 + rng() % 3;
+      for (int e = 0; e < edits && !m.empty(); e++){
+        size_t at = rng() % m.size();
+        switch (rng() % 4){
+          case 0: m[at] = (char)rng(); break;
+          case 1: m.erase(at, 1); break;
+          case 2: m.insert(at, 1, "{}[]\":,\\0-e. "[rng() % 14]); break;
+          default: m.resize(at); break;
+        }
+      }
+      std::vector<char> heap(m.begin(), m.end());                   // exact size: ASan sees an overread
+      JsonErr me = {};
+      size_t members = 0;
+      bool mok = json_object_each(heap.data(), heap.size(), [&](const char*, size_t, const JsonVal&) -> const char* { members++; return nullptr; }, &me);
+      if (mok) accepted++;
+      else if (me.pos > heap.size() || !me.msg){ if (bad++ < 5) printf("BAD ERROR pos=%zu len=%zu\n", me.pos, heap.size()); }
+      mutated++;
+    }
+  }
+  printf("json fuzz: %llu generated (read back exactly), %llu mutated (%llu still valid), failures=%llu\n",
+         (unsigned long long)cases, (unsigned long long)mutated, (unsigned long long)accepted, (unsigned long long)bad);
+
+  // Throughput on a full settings body: tokenizer vs the old indexOf/substring scan.
+  static const char BODY[] =
+    "{\"fs\":\"SVGA\",\"q\":12,\"rot\":0,\"bri\":1,\"con\":0,\"sat\":0,\"ae\":1,\"awb\":1,\"aec\":1,"
+    "\"agc\":1,\"abr\":0,\"abr_fps\":15,\"abr_qmax\":30,\"abr_fsmin\":\"QVGA\",\"tft_pv\":0,"
+    "\"tft_fps\":4,\"clip_kb\":2048,\"clip_fps\":10}";
+  static const char* KEYS[] = { "fs","q","rot","bri","con","sat","ae","awb","aec","agc","abr","abr_fps",
+                                "abr_qmax","abr_fsmin","tft_pv","tft_fps","clip_kb","clip_fps" };
+  const size_t len = sizeof(BODY) - 1;
+  volatile long sink = 0;
+  uint64_t n_tok = 0, n_old = 0;
+  int64_t  t0 = esp_timer_get_time(), span = (int64_t)seconds * 250000;
+  while (esp_timer_get_time() - t0 < span){
+    for (int k = 0; k < 1000; k++){
+      json_object_each(BODY, len, [&](const char*, size_t kl, const JsonVal& v) -> const char* { sink += v.i + (long)kl; return nullptr; }, nullptr);
+    }
+    n_tok += 1000;
+  }
+  double us_tok = (esp_timer_get_time() - t0) / (double)n_tok;
+  String body(BODY);
+  t0 = esp_timer_get_time();
+  while (esp_timer_get_time() - t0 < span){
+    for (int k = 0; k < 100; k++){
+      for (const char* key : KEYS){                              // what handleApiPost() used to do per key
+        int p = body.indexOf(String("\"") + key + "\"");
+        if (p < 0) continue;
+        p = body.indexOf(':', p);
+        int e = body.indexOf(',', p + 1); if (e < 0) e = body.indexOf('}', p + 1);
+        sink += body.substring(p + 1, e).toInt();
+      }
+    }
+    n_old += 100;
+  }
+  double us_old = (esp_timer_get_time() - t0) / (double)n_old;
+  printf("json parse (%zu-byte body, 18 members): tokenizer %.2f us/body (%.1f MB/s), String scan %.2f us/body (%.1fx)\n",
+         len, us_tok, len / us_tok, us_old, us_old / us_tok);
+  fflush(stdout);
+  return bad ? 1 : 0;
+}
+
+// ---- motion metric ----
+std::vector<uint8_t> g_thumb;
+int g_tw = 0, g_th = 0;
+
+int thumb_draw(JPEGDRAW* d){
+  const uint8_t* px = (const uint8_t*)d->pPixels;
+  for (int y = 0; y < d->iHeight && d->y + y < g_th; y++)
+    for (int x = 0; x < d->iWidth && d->x + x < g_tw; x++)
+      g_thumb[(size_t)(d->y + y) * g_tw + d->x + x] = px[(size_t)y * d->iWidth + x];
+  return 1;
+}
+
+int motion_main(int seconds){
+  std::mt19937 rng(777);
+  uint64_t cases = 0, bad = 0;
+  int64_t  t_end = esp_timer_get_time() + (int64_t)seconds * 400000;
+  while (esp_timer_get_time() < t_end){
+    size_t n = (rng() % 2048) * 4;
+    std::vector<uint32_t> a(n / 4 + 1), b(n / 4 + 1);
+    int mode = rng() % 3;                                       // random / near-equal / extreme values
+    for (size_t i = 0; i < a.size(); i++){
+      a[i] = rng();
+      b[i] = mode == 0 ? rng() : mode == 1 ? a[i] ^ (rng() & 0x07070707) : (rng() & 0x01010101) * 0xFF;
+    }
+    uint8_t noise = rng() % 128;
+    MotionDiff r = motion_diff_ref((uint8_t*)a.data(), (uint8_t*)b.data(), n, noise);
+    MotionDiff w = motion_diff_swar((uint8_t*)a.data(), (uint8_t*)b.data(), n, noise);
+    if (r.sad != w.sad || r.changed != w.changed){
+      if (bad++ < 5) printf("MISMATCH n=%zu noise=%u: ref %u/%u swar %u/%u\n", n, noise, r.sad, r.changed, w.sad, w.changed);
+    }
+    cases++;
+  }
+  printf("motion kernels: %llu random pairs, SWAR == reference, failures=%llu\n",
+         (unsigned long long)cases, (unsigned long long)bad);
+
+  // Kernel speed on SVGA and UXGA thumbnails.
+  for (int px : { 100 * 75, 200 * 150 }){
+    std::vector<uint32_t> a(px / 4), b(px / 4);
+    for (size_t i = 0; i < a.size(); i++){ a[i] = rng(); b[i] = a[i] ^ (rng() & 0x0F0F0F0F); }
+    volatile uint32_t sink = 0;
+    double us[2];
+    for (int k = 0; k < 2; k++){
+      int64_t t0 = esp_timer_get_time(); uint32_t reps = 0;
+      while (esp_timer_get_time() - t0 < (int64_t)seconds * 100000){
+        for (int j = 0; j < 100; j++){
+          MotionDiff d = k ? motion_diff_swar((uint8_t*)a.data(), (uint8_t*)b.data(), px, 12)
+                           : motion_diff_ref((uint8_t*)a.data(), (uint8_t*)b.data(), px, 12);
+          sink += d.sad;
+          b[j % b.size()]++;                                    // keep the compiler honest
+        }
+        reps += 100;
+      }
+      us[k] = (esp_timer_get_time() - t0) / (double)reps;
+    }
+    printf("motion diff %5d px: reference %.2f us, SWAR %.2f us (%.1fx)\n", px, us[0], us[1], us[0] / us[1]);
+  }
+
+  // DC decode: random 8x8-block-constant luma through the mock encoder; the
+  // 1/8 thumbnail must give back each block's value (within quantisation).
+  int worst = 0;
+  for (int t = 0; t < 6; t++){
+    int w = t & 1 ? 800 : 320, h = t & 1 ? 600 : 240;
+    std::vector<uint8_t> rgb((size_t)w * h * 3), want((size_t)(w / 8) * (h / 8));
+    for (auto& v : want) v = 16 + rng() % 224;
+    for (int y = 0; y < h; y++) for (int x = 0; x < w; x++){
+      uint8_t v = want[(size_t)(y / 8) * (w / 8) + x / 8];
+      uint8_t* p = &rgb[((size_t)y * w + x) * 3]; p[0] = p[1] = p[2] = v;
+    }
+    std::vector<uint8_t> jpg = mock_jpeg::Encoder(60 + t * 5).encode(rgb.data(), w, h);
+    g_tw = w / 8; g_th = h / 8; g_thumb.assign((size_t)g_tw * g_th, 0);
+    JPEGDEC dec;
+    int64_t t0 = esp_timer_get_time();
+    bool ok = dec.openRAM(jpg.data(), (int)jpg.size(), thumb_draw);
+    dec.setPixelType(EIGHT_BIT_GRAYSCALE);
+    ok = ok && dec.decode(0, 0, JPEG_SCALE_EIGHTH);
+    int64_t t1 = esp_timer_get_time();
+    int err = 0;
+    for (size_t i = 0; i < want.size(); i++) err = std::max(err, abs((int)g_thumb[i] - (int)want[i]));
+    worst = std::max(worst, ok ? err : 255);
+    if (t < 2) printf("dc decode %dx%d (%zu bytes): %s, %.2f ms, max error %d\n", w, h, jpg.size(), ok ? "ok" : "FAILED", (t1 - t0) / 1000.0, err);
+  }
+  if (worst > 8){ printf("dc decode max error %d > 8\n", worst); bad++; }
+  fflush(stdout);
+  return bad ? 1 : 0;
+}
+
+} // namespace
+
+int main(int argc, char** argv){
+  Opts o;
+  for (int i = 1; i < argc; i++){
+    const char* a = argv[i];
+    const char* v = i + 1 < argc ? argv[i + 1] : nullptr;
+    if      (!strcmp(a, "--streams") && v){ o.streams = atoi(v); i++; }
+    else if (!strcmp(a, "--jpg")     && v){ o.jpg = atoi(v); i++; }
+    else if (!strcmp(a, "--seconds") && v){ o.seconds = atoi(v); i++; }
+    else if (!strcmp(a, "--port")    && v){ o.port = atoi(v); i++; }
+    else if (!strcmp(a, "--query")   && v){ o.query = v; i++; }
+    else if (!strcmp(a, "--rate")    && v){ o.rate_kBps = atoi(v); i++; }
+    else if (!strcmp(a, "--poll"))         { o.poll = true; }
+    else if (!strcmp(a, "--ws")       && v){ o.ws = atoi(v); i++; }
+    else if (!strcmp(a, "--rtsp")     && v){ o.rtsp = atoi(v); i++; }
+    else if (!strcmp(a, "--rtsp-tcp") && v){ o.rtsp_tcp = atoi(v); i++; }
+    else if (!strcmp(a, "--rtsp-port") && v){ o.rtsp_port = atoi(v); i++; }
+    else if (!strcmp(a, "--json"))         { o.json = true; }
+    else if (!strcmp(a, "--motion"))       { o.motion = true; }
+    else if (!strcmp(a, "--abr"))          { o.abr = true; }
+    else if (!strcmp(a, "--sndbuf")   && v){ o.sndbuf = atoi(v); i++; }
+    else { usage(); return a[2] == 'h' ? 0 : 2; }
+  }
+  if (o.json) return json_main(o.seconds);
+  if (o.motion) return motion_main(o.seconds);
+  signal(SIGPIPE, SIG_IGN);
+  char port[8]; snprintf(port, sizeof(port), "%d", o.port);
+  setenv("NOZZLE_HTTP_PORT", port, 0);
+  o.port = atoi(getenv("NOZZLE_HTTP_PORT"));
+  if (o.sndbuf){ char b[16]; snprintf(b, sizeof(b), "%d", o.sndbuf); setenv("NOZZLE_SNDBUF", b, 1); }
+
+  std::thread([]{ setup(); for (;;) loop(); }).detach();
+  for (int i = 0; i < 100; i++){                             // wait for the listener
+    int fd = dial(o.port);
+    if (fd >= 0){ ::close(fd); break; }
+    delay(50);
+  }
+  delay(500);                                                // first frames into the ring
+  AbrState top;
+  if (o.abr){
+    http(o.port, "POST", "/api/settings", "{\"abr\":1}");
+    top = abr_sample(o.port);
+  }
+
+  std::vector<Stats> ss(o.streams), js(o.jpg), ws(o.ws), ru(o.rtsp), rt(o.rtsp_tcp);
+  std::vector<std::thread> th;
+  for (auto& s : ss) th.emplace_back(stream_client, std::cref(o), std::ref(s));
+  for (auto& s : js) th.emplace_back(jpg_client, std::cref(o), std::ref(s));
+  for (auto& s : ws) th.emplace_back(ws_client, std::cref(o), std::ref(s));
+  for (auto& s : ru) th.emplace_back(rtsp_client, std::cref(o), std::ref(s), false);
+  for (auto& s : rt) th.emplace_back(rtsp_client, std::cref(o), std::ref(s), true);
+  int64_t t0 = esp_timer_get_time();
+  AbrState a;
+  int worst = INT32_MAX;
+  for (int k = 1; k <= o.seconds; k++){
+    std::this_thread::sleep_for(std::chrono::seconds(1));
+    if (o.rate_kBps && k == o.seconds / 2) g_unthrottle = true;
+    if (!o.abr) continue;
+    a = abr_sample(o.port);
+    worst = std::min(worst, a.rung());
+    printf("abr t=%2ds %-5s fs=%-5s q=%d%s\n", k, a.state.c_str(), a.fs.c_str(), a.q,
+           o.rate_kBps && k == o.seconds / 2 ? "   (throttle off)" : "");
+  }
+  g_stop = true;
+  for (auto& t : th) t.join();
+  double secs = (esp_timer_get_time() - t0) / 1e6;
+
+  printf("\nnative bench: %.1f s, camera %s fps, /stream?%s\n", secs,
+         getenv("MOCK_CAM_FPS") ? getenv("MOCK_CAM_FPS") : "25", o.query);
+  report("/stream", ss, secs);
+  report("/jpg", js, secs);
+  report("ws", ws, secs);
+  report("rtsp", ru, secs);
+  report("rtsp/tcp", rt, secs);
+  bool recovered = !o.abr || ((a.state == "up" || a.state == "hold") && (a.rung() > worst || a.rung() == top.rung()));
+  if (o.abr) printf("abr: %s (configured fs=%s q=%d, final %s fs=%s q=%d)\n", recovered ? "recovering" : "FAILED to recover",
+                    top.fs.c_str(), top.q, a.state.c_str(), a.fs.c_str(), a.q);
+  fflush(stdout);
+  _exit(recovered ? 0 : 1);                                    // firmware tasks never return
+}
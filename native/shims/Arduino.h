@@ -0,0 +1,173 @@
+#pragma once
+// Host stand-in for the Arduino-ESP32 core API used by the firmware.
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <stdarg.h>
+#include <math.h>
+#include <algorithm>
+#include <string>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "esp_heap_caps.h"
+#include "esp_timer.h"
+
+#define PROGMEM
+#define PGM_P               const char*
+#define F(s)                (s)
+#define strlen_P            strlen
+#define memcpy_P            memcpy
+#define strncmp_P           strncmp
+#define pgm_read_byte(p)    (*(const uint8_t*)(p))
+#define IRAM_ATTR
+#define EXT_RAM_ATTR
+
+#define HIGH          1
+#define LOW           0
+#define INPUT         0x01
+#define OUTPUT        0x03
+#define INPUT_PULLUP  0x05
+
+typedef uint8_t byte;
+using std::min;
+using std::max;
+
+inline unsigned long millis(){ return native_rt::millis_since_start(); }
+inline unsigned long micros(){ return (unsigned long)native_rt::micros_since_start(); }
+inline void delay(uint32_t ms){ native_rt::sleep_ms(ms); }
+inline void delayMicroseconds(uint32_t us){ std::this_thread::sleep_for(std::chrono::microseconds(us)); }
+inline void yield(){ std::this_thread::yield(); }
+
+// GPIO: the SCCB lines idle high (pull-ups), everything else is a no-op.
+inline void pinMode(uint8_t, uint8_t){}
+inline void digitalWrite(uint8_t, uint8_t){}
+inline int  digitalRead(uint8_t){ return HIGH; }
+
+inline bool  psramFound(){ return true; }
+inline void* ps_malloc(size_t n){ return malloc(n); }
+inline void* ps_calloc(size_t n, size_t m){ return calloc(n, m); }
+
+// -------------------- String --------------------
+class String {
+public:
+  String() {}
+  String(const char* s) : s_(s ? s : "") {}
+  String(const std::string& s) : s_(s) {}
+  explicit String(char c) : s_(1, c) {}
+  String(int v)           : s_(std::to_string(v)) {}
+  String(unsigned v)      : s_(std::to_string(v)) {}
+  String(long v)          : s_(std::to_string(v)) {}
+  String(unsigned long v) : s_(std::to_string(v)) {}
+  String(long long v)     : s_(std::to_string(v)) {}
+  String(unsigned long long v) : s_(std::to_string(v)) {}
+  String(double v, unsigned decimals = 2){ char b[48]; snprintf(b, sizeof(b), "%.*f", (int)decimals, v); s_ = b; }
+
+  const char*  c_str()   const { return s_.c_str(); }
+  unsigned     length()  const { return (unsigned)s_.size(); }
+  bool         isEmpty() const { return s_.empty(); }
+  void         reserve(size_t n){ s_.reserve(n); }
+  char         charAt(unsigned i) const { return i < s_.size() ? s_[i] : 0; }
+  char         operator[](unsigned i) const { return charAt(i); }
+  char&        operator[](unsigned i){ return s_[i]; }
+  explicit operator bool() const { return true; }
+
+  bool concat(const String& o){ s_ += o.s_; return true; }
+  bool concat(const char* o){ if (o) s_ += o; return true; }
+  bool concat(const char* o, unsigned n){ if (o) s_.append(o, n); return true; }
+  bool concat(char c){ s_ += c; return true; }
+  String& operator+=(const String& o){ s_ += o.s_; return *this; }
+  String& operator+=(const char* o){ if (o) s_ += o; return *this; }
+  String& operator+=(char c){ s_ += c; return *this; }
+  String& operator+=(int v){ s_ += std::to_string(v); return *this; }
+  String& operator+=(unsigned v){ s_ += std::to_string(v); return *this; }
+  String& operator+=(long v){ s_ += std::to_string(v); return *this; }
+  String& operator+=(unsigned long v){ s_ += std::to_string(v); return *this; }
+
+  friend String operator+(const String& a, const String& b){ String r(a); r += b; return r; }
+  friend String operator+(const String& a, const char* b){ String r(a); r += b; return r; }
+  friend String operator+(const char* a, const String& b){ String r(a); r += b; return r; }
+  friend String operator+(const String& a, char b){ String r(a); r += b; return r; }
+  friend String operator+(const String& a, int b){ String r(a); r += b; return r; }
+  friend String operator+(const String& a, unsigned b){ String r(a); r += b; return r; }
+  friend String operator+(const String& a, long b){ String r(a); r += b; return r; }
+  friend String operator+(const String& a, unsigned long b){ String r(a); r += b; return r; }
+
+  bool operator==(const String& o) const { return s_ == o.s_; }
+  bool operator==(const char* o)   const { return s_ == (o ? o : ""); }
+  bool operator!=(const String& o) const { return !(*this == o); }
+  bool operator!=(const char* o)   const { return !(*this == o); }
+  bool operator<(const String& o)  const { return s_ < o.s_; }
+  bool equals(const String& o) const { return s_ == o.s_; }
+  bool equalsIgnoreCase(const String& o) const { return strcasecmp(s_.c_str(), o.s_.c_str()) == 0; }
+  bool startsWith(const String& p) const { return s_.compare(0, p.s_.size(), p.s_) == 0; }
+  bool endsWith(const String& p) const {
+    return s_.size() >= p.s_.size() && s_.compare(s_.size()-p.s_.size(), p.s_.size(), p.s_) == 0;
+  }
+
+  int indexOf(char c, unsigned from = 0) const { auto p = s_.find(c, from); return p == std::string::npos ? -1 : (int)p; }
+  int indexOf(const String& t, unsigned from = 0) const { auto p = s_.find(t.s_, from); return p == std::string::npos ? -1 : (int)p; }
+  int indexOf(const char* t, unsigned from = 0) const { auto p = s_.find(t, from); return p == std::string::npos ? -1 : (int)p; }
+  int lastIndexOf(char c) const { auto p = s_.rfind(c); return p == std::string::npos ? -1 : (int)p; }
+  String substring(unsigned from) const { return from >= s_.size() ? String() : String(s_.substr(from)); }
+  String substring(unsigned from, unsigned to) const {
+    if (from > to) std::swap(from, to);
+    if (from >= s_.size()) return String();
+    return String(s_.substr(from, std::min<size_t>(to, s_.size()) - from));
+  }
+  void remove(unsigned idx){ if (idx < s_.size()) s_.erase(idx); }
+  void remove(unsigned idx, unsigned n){ if (idx < s_.size()) s_.erase(idx, n); }
+  void replace(const String& a, const String& b){
+    if (a.s_.empty()) return;
+    for (size_t p = 0; (p = s_.find(a.s_, p)) != std::string::npos; p += b.s_.size()) s_.replace(p, a.s_.size(), b.s_);
+  }
+  void trim(){
+    size_t b = s_.find_first_not_of(" \t\r\n"), e = s_.find_last_not_of(" \t\r\n");
+    s_ = (b == std::string::npos) ? std::string() : s_.substr(b, e - b + 1);
+  }
+  void toLowerCase(){ for (auto& c : s_) c = (char)tolower((unsigned char)c); }
+  void toUpperCase(){ for (auto& c : s_) c = (char)toupper((unsigned char)c); }
+  long   toInt()   const { return strtol(s_.c_str(), nullptr, 10); }
+  float  toFloat() const { return strtof(s_.c_str(), nullptr); }
+
+private:
+  std::string s_;
+};
+
+// -------------------- IPAddress --------------------
+class IPAddress {
+public:
+  IPAddress(uint8_t a=0, uint8_t b=0, uint8_t c=0, uint8_t d=0){ o_[0]=a; o_[1]=b; o_[2]=c; o_[3]=d; }
+  explicit IPAddress(uint32_t be){ memcpy(o_, &be, 4); }
+  uint8_t operator[](int i) const { return o_[i]; }
+  operator uint32_t() const { uint32_t v; memcpy(&v, o_, 4); return v; }
+  String toString() const { char b[16]; snprintf(b, sizeof(b), "%u.%u.%u.%u", o_[0], o_[1], o_[2], o_[3]); return String(b); }
+private:
+  uint8_t o_[4];
+};
+
+// -------------------- Serial --------------------
+class HostSerial {
+public:
+  void begin(unsigned long){}
+  operator bool() const { return true; }
+  int printf(const char* fmt, ...) __attribute__((format(printf, 2, 3))){
+    va_list ap; va_start(ap, fmt); int n = vfprintf(stdout, fmt, ap); va_end(ap); fflush(stdout); return n;
+  }
+  size_t print(const char* s){ return (size_t)fputs(s, stdout); }
+  size_t print(const String& s){ return print(s.c_str()); }
+  size_t print(const IPAddress& ip){ return print(ip.toString()); }
+  size_t print(char c){ return (size_t)fputc(c, stdout); }
+  size_t print(int v){ return (size_t)fprintf(stdout, "%d", v); }
+  size_t print(unsigned v){ return (size_t)fprintf(stdout, "%u", v); }
+  size_t print(long v){ return (size_t)fprintf(stdout, "%ld", v); }
+  size_t print(unsigned long v){ return (size_t)fprintf(stdout, "%lu", v); }
+  size_t print(double v){ return (size_t)fprintf(stdout, "%.2f", v); }
+  template <typename T> size_t println(const T& v){ size_t n = print(v); n += println(); return n; }
+  size_t println(){ fputs("\n", stdout); fflush(stdout); return 1; }
+  size_t write(const uint8_t* b, size_t n){ return fwrite(b, 1, n, stdout); }
+};
+inline HostSerial Serial;
@@ -0,0 +1,10 @@
+#pragma once
+#include <Arduino.h>
+
+// Captive DNS is meaningless on the host; keep the API so loop() stays identical.
+class DNSServer {
+public:
+  bool start(uint16_t, const String&, const IPAddress&){ return true; }
+  void processNextRequest(){}
+  void stop(){}
+};
@@ -0,0 +1,170 @@
+#pragma once
+// Host stand-in for bitbank2/JPEGDEC, just enough for the motion metric:
+// baseline Huffman JPEGs decoded at JPEG_SCALE_EIGHTH into EIGHT_BIT_GRAYSCALE,
+// i.e. one pixel per luma block from its DC coefficient (AC codes are skipped,
+// never dequantised). Other scales / pixel types fail the decode.
+#include <stdint.h>
+#include <string.h>
+#include <vector>
+
+#define JPEG_SCALE_HALF     2
+#define JPEG_SCALE_QUARTER  4
+#define JPEG_SCALE_EIGHTH   8
+#define RGB565_LITTLE_ENDIAN 0
+#define RGB565_BIG_ENDIAN    1
+#define EIGHT_BIT_GRAYSCALE  2
+
+struct JPEGDRAW {
+  int       x, y;
+  int       iWidth, iHeight;
+  int       iBpp;
+  uint16_t* pPixels;
+  void*     pUser;
+};
+typedef int (JPEG_DRAW_CALLBACK)(JPEGDRAW* pDraw);
+
+class JPEGDEC {
+public:
+  int  openRAM(uint8_t* p, int n, JPEG_DRAW_CALLBACK* cb){ p_ = p; n_ = n; cb_ = cb; return parse_(); }
+  void close(){ p_ = nullptr; }
+  void setPixelType(int t){ type_ = t; }
+  void setUserPointer(void* u){ user_ = u; }
+  int  getWidth() const { return w_; }
+  int  getHeight() const { return h_; }
+
+  int decode(int x, int y, int options){
+    if (!p_ || type_ != EIGHT_BIT_GRAYSCALE || !(options & JPEG_SCALE_EIGHTH)) return 0;
+    int hmax = 1, vmax = 1;
+    for (int c = 0; c < nc_; c++){ hmax = comp_[c].h > hmax ? comp_[c].h : hmax; vmax = comp_[c].v > vmax ? comp_[c].v : vmax; }
+    int mcux = (w_ + 8 * hmax - 1) / (8 * hmax), mcuy = (h_ + 8 * vmax - 1) / (8 * vmax);
+    int ow = mcux * hmax, oh = vmax;                        // one MCU row of output pixels
+    std::vector<uint8_t> row((size_t)ow * oh);
+    pos_ = sos_; acc_ = 0; bits_ = 0;
+    int pred[4] = {}, left = restart_;
+    for (int my = 0; my < mcuy; my++){
+      for (int mx = 0; mx < mcux; mx++){
+        if (restart_ && !left--){ if (!restart_marker_()) return 0; memset(pred, 0, sizeof(pred)); left = restart_ - 1; }
+        for (int c = 0; c < nc_; c++){
+          const Comp& k = comp_[c];
+          for (int by = 0; by < k.v; by++) for (int bx = 0; bx < k.h; bx++){
+            int s = huff_(dc_[k.td]);
+            if (s < 0) return 0;
+            pred[c] += s ? extend_(get_(s), s) : 0;
+            for (int i = 1; i < 64; ){                       // skip the AC coefficients
+              int rs = huff_(ac_[k.ta]);
+              if (rs < 0) return 0;
+              if (!rs) break;
+              get_(rs & 15); i += (rs >> 4) + 1;
+            }
+            if (c == 0){
+              int v = 128 + pred[0] * q_[k.tq] / 8;
+              row[(size_t)by * ow + mx * hmax + bx] = (uint8_t)(v < 0 ? 0 : v > 255 ? 255 : v);
+            }
+          }
+        }
+      }
+      JPEGDRAW d = { x, y + my * oh, ow, oh, 8, (uint16_t*)row.data(), user_ };
+      if (!cb_(&d)) return 0;
+    }
+    return 1;
+  }
+
+private:
+  struct Huff { uint16_t maxcode[18]; int16_t valptr[17]; uint16_t mincode[17]; uint8_t vals[256]; bool ok; };
+  struct Comp { int id, h, v, tq, td, ta; };
+
+  int parse_(){
+    w_ = h_ = nc_ = 0; restart_ = 0; sos_ = 0;
+    for (auto& t : dc_) t.ok = false;
+    for (auto& t : ac_) t.ok = false;
+    if (n_ < 4 || p_[0] != 0xFF || p_[1] != 0xD8) return 0;
+    int i = 2;
+    while (i + 4 <= n_){
+      if (p_[i] != 0xFF) return 0;
+      int m = p_[i + 1], len = p_[i + 2] << 8 | p_[i + 3];
+      const uint8_t* s = p_ + i + 4;
+      if (i + 2 + len > n_) return 0;
+      if (m == 0xDB){
+        for (int o = 0; o + 65 <= len - 2; o += 65){ if (s[o] >> 4) return 0; q_[s[o] & 3] = s[o + 1]; }
+      } else if (m == 0xC0 || m == 0xC1){
+        h_ = s[1] << 8 | s[2]; w_ = s[3] << 8 | s[4]; nc_ = s[5];
+        if (nc_ < 1 || nc_ > 4) return 0;
+        for (int c = 0; c < nc_; c++) comp_[c] = { s[6 + 3*c], s[7 + 3*c] >> 4, s[7 + 3*c] & 15, s[8 + 3*c] & 3, 0, 0 };
+      } else if (m == 0xC4){
+        for (int o = 0; o < len - 2; ){
+          Huff& t = (s[o] >> 4) ? ac_[s[o] & 3] : dc_[s[o] & 3];
+          int total = 0, code = 0, k = 0;
+          for (int l = 0; l < 16; l++) total += s[o + 1 + l];
+          if (total > 256) return 0;
+          memcpy(t.vals, s + o + 17, total);
+          for (int l = 1; l <= 16; l++){
+            int cnt = s[o + l];
+            t.valptr[l] = (int16_t)k; t.mincode[l] = (uint16_t)code;
+            code += cnt; k += cnt;
+            t.maxcode[l] = cnt ? (uint16_t)(code - 1) : 0xFFFF;
+            code <<= 1;
+          }
+          t.ok = true;
+          o += 17 + total;
+        }
+      } else if (m == 0xDD){
+        restart_ = s[0] << 8 | s[1];
+      } else if (m == 0xDA){
+        if (s[0] != nc_) return 0;                        // interleaved scans only
+        for (int c = 0; c < nc_; c++){ comp_[c].td = s[2 + 2*c] >> 4; comp_[c].ta = s[2 + 2*c] & 15; }
+        sos_ = i + 2 + len;
+        return w_ > 0 && h_ > 0;
+      } else if (m == 0xC2 || m == 0xC3 || (m >= 0xC5 && m <= 0xCF && m != 0xC8 && m != 0xCC)){
+        return 0;                                         // progressive / lossless / arithmetic
+      }
+      i += 2 + len;
+    }
+    return 0;
+  }
+
+  // Entropy-coded bits, with FF00 unstuffing; a marker reads as zero bits.
+  int bit_(){
+    if (!bits_){
+      uint8_t b = 0;
+      if (pos_ < n_){
+        b = p_[pos_];
+        if (b == 0xFF){
+          if (pos_ + 1 < n_ && p_[pos_ + 1] == 0x00) pos_ += 2;
+          else b = 0;                                     // marker: leave it for restart_marker_()
+        } else pos_++;
+      }
+      acc_ = b; bits_ = 8;
+    }
+    return (acc_ >> --bits_) & 1;
+  }
+  int get_(int n){ int v = 0; while (n--) v = v << 1 | bit_(); return v; }
+  static int extend_(int v, int s){ return v < (1 << (s - 1)) ? v - (1 << s) + 1 : v; }
+  int huff_(const Huff& t){
+    if (!t.ok) return -1;
+    int code = 0;
+    for (int l = 1; l <= 16; l++){
+      code = code << 1 | bit_();
+      if (t.maxcode[l] != 0xFFFF && code <= t.maxcode[l]) return t.vals[t.valptr[l] + code - t.mincode[l]];
+    }
+    return -1;
+  }
+  bool restart_marker_(){
+    bits_ = 0;
+    while (pos_ + 1 < n_ && !(p_[pos_] == 0xFF && p_[pos_ + 1] >= 0xD0 && p_[pos_ + 1] <= 0xD7)) pos_++;
+    if (pos_ + 1 >= n_) return false;
+    pos_ += 2;
+    return true;
+  }
+
+  uint8_t*            p_ = nullptr;
+  int                 n_ = 0, pos_ = 0, sos_ = 0;
+  JPEG_DRAW_CALLBACK* cb_ = nullptr;
+  void*               user_ = nullptr;
+  int                 type_ = RGB565_LITTLE_ENDIAN;
+  int                 w_ = 0, h_ = 0, nc_ = 0, restart_ = 0;
+  Comp                comp_[4] = {};
+  Huff                dc_[4], ac_[4];
+  uint8_t             q_[4] = { 1, 1, 1, 1 };
+  uint32_t            acc_ = 0;
+  int                 bits_ = 0;
+};
@@ -0,0 +1,108 @@
+#pragma once
+#include <Arduino.h>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// In-memory NVS: namespaces survive Preferences::end() for the life of the process.
+// With NOZZLE_NVS_FILE set they are also loaded from / written through to that
+// file, so settings survive a restart of the native build.
+class Preferences {
+public:
+  bool begin(const char* ns, bool readOnly = false){ ns_ = ns; ro_ = readOnly; return true; }
+  void end(){}
+  bool clear(){ std::lock_guard<std::mutex> lk(mu()); store()[ns_].clear(); flush(); return true; }
+  bool remove(const char* k){ std::lock_guard<std::mutex> lk(mu()); bool r = store()[ns_].erase(k) > 0; flush(); return r; }
+  bool isKey(const char* k){ std::lock_guard<std::mutex> lk(mu()); return store()[ns_].count(k) > 0; }
+
+  size_t putChar  (const char* k, int8_t v)   { return put(k, &v, sizeof(v)); }
+  size_t putUChar (const char* k, uint8_t v)  { return put(k, &v, sizeof(v)); }
+  size_t putShort (const char* k, int16_t v)  { return put(k, &v, sizeof(v)); }
+  size_t putUShort(const char* k, uint16_t v) { return put(k, &v, sizeof(v)); }
+  size_t putInt   (const char* k, int32_t v)  { return put(k, &v, sizeof(v)); }
+  size_t putUInt  (const char* k, uint32_t v) { return put(k, &v, sizeof(v)); }
+  size_t putBool  (const char* k, bool v)     { uint8_t b = v; return put(k, &b, 1); }
+  size_t putBytes (const char* k, const void* v, size_t n){ return put(k, v, n); }
+  size_t putString(const char* k, const String& v){ return put(k, v.c_str(), v.length() + 1); }
+
+  int8_t   getChar  (const char* k, int8_t d = 0)   { return get(k, d); }
+  uint8_t  getUChar (const char* k, uint8_t d = 0)  { return get(k, d); }
+  int16_t  getShort (const char* k, int16_t d = 0)  { return get(k, d); }
+  uint16_t getUShort(const char* k, uint16_t d = 0) { return get(k, d); }
+  int32_t  getInt   (const char* k, int32_t d = 0)  { return get(k, d); }
+  uint32_t getUInt  (const char* k, uint32_t d = 0) { return get(k, d); }
+  bool     getBool  (const char* k, bool d = false) { return get<uint8_t>(k, d) != 0; }
+  String   getString(const char* k, const String& d = String()){
+    std::lock_guard<std::mutex> lk(mu());
+    auto& m = store()[ns_]; auto it = m.find(k);
+    return it == m.end() ? d : String((const char*)it->second.data());
+  }
+  size_t getBytesLength(const char* k){
+    std::lock_guard<std::mutex> lk(mu());
+    auto& m = store()[ns_]; auto it = m.find(k);
+    return it == m.end() ? 0 : it->second.size();
+  }
+  size_t getBytes(const char* k, void* out, size_t n){
+    std::lock_guard<std::mutex> lk(mu());
+    auto& m = store()[ns_]; auto it = m.find(k);
+    if (it == m.end() || it->second.size() > n) return 0;
+    memcpy(out, it->second.data(), it->second.size());
+    return it->second.size();
+  }
+
+private:
+  typedef std::map<std::string, std::vector<uint8_t>> Ns;
+  static std::map<std::string, Ns>& store(){ static std::map<std::string, Ns> s = load(); return s; }
+  static std::mutex& mu(){ static std::mutex m; return m; }
+
+  // File format: repeated [u16 ns len][ns][u16 key len][key][u32 value len][value].
+  static std::map<std::string, Ns> load(){
+    std::map<std::string, Ns> s;
+    const char* path = getenv("NOZZLE_NVS_FILE");
+    FILE* f = path ? fopen(path, "rb") : nullptr;
+    if (!f) return s;
+    auto str = [&](std::string& out)->bool{
+      uint16_t n; if (fread(&n, 2, 1, f) != 1) return false;
+      out.resize(n); return !n || fread(&out[0], 1, n, f) == n;
+    };
+    std::string ns, k;
+    while (str(ns) && str(k)){
+      uint32_t n; if (fread(&n, 4, 1, f) != 1) break;
+      std::vector<uint8_t> v(n);
+      if (n && fread(v.data(), 1, n, f) != n) break;
+      s[ns][k] = std::move(v);
+    }
+    fclose(f);
+    return s;
+  }
+  static void flush(){
+    const char* path = getenv("NOZZLE_NVS_FILE");
+    FILE* f = path ? fopen(path, "wb") : nullptr;
+    if (!f) return;
+    for (auto& ns : store()) for (auto& kv : ns.second){
+      uint16_t a = ns.first.size(), b = kv.first.size(); uint32_t n = kv.second.size();
+      fwrite(&a, 2, 1, f); fwrite(ns.first.data(), 1, a, f);
+      fwrite(&b, 2, 1, f); fwrite(kv.first.data(), 1, b, f);
+      fwrite(&n, 4, 1, f); fwrite(kv.second.data(), 1, n, f);
+    }
+    fclose(f);
+  }
+
+  size_t put(const char* k, const void* v, size_t n){
+    if (ro_) return 0;
+    std::lock_guard<std::mutex> lk(mu());
+    store()[ns_][k].assign((const uint8_t*)v, (const uint8_t*)v + n);
+    flush();
+    return n;
+  }
+  template <typename T> T get(const char* k, T d){
+    std::lock_guard<std::mutex> lk(mu());
+    auto& m = store()[ns_]; auto it = m.find(k);
+    if (it == m.end() || it->second.size() != sizeof(T)) return d;
+    T v; memcpy(&v, it->second.data(), sizeof(T)); return v;
+  }
+
+  std::string ns_;
+  bool        ro_ = false;
+};
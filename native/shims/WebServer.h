@@ -0,0 +1,192 @@
+#pragma once
+// Host stand-in for the ESP32 WebServer: same handler API and the same
+// one-request-per-handleClient() behaviour, over a real listening socket.
+// The bound port is the constructor port unless NOZZLE_HTTP_PORT overrides it.
+#include <Arduino.h>
+#include <WiFi.h>
+#include <functional>
+#include <vector>
+
+typedef enum { HTTP_ANY, HTTP_GET, HTTP_HEAD, HTTP_POST, HTTP_PUT, HTTP_PATCH, HTTP_DELETE, HTTP_OPTIONS } HTTPMethod;
+enum HTTPClientStatus { HC_NONE, HC_WAIT_READ, HC_WAIT_CLOSE };
+
+#define CONTENT_LENGTH_UNKNOWN ((size_t) -1)
+#define CONTENT_LENGTH_NOT_SET ((size_t) -2)
+
+class WebServer {
+public:
+  typedef std::function<void(void)> THandlerFunction;
+
+  explicit WebServer(int port = 80) : port_(port) {}
+  virtual ~WebServer(){ if (lfd_ >= 0) ::close(lfd_); }
+
+  void begin(){
+    if (const char* p = getenv("NOZZLE_HTTP_PORT")) port_ = atoi(p);   // read late: globals are built before main()
+    lfd_ = ::socket(AF_INET, SOCK_STREAM, 0);
+    int one = 1; setsockopt(lfd_, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    sockaddr_in a = {}; a.sin_family = AF_INET; a.sin_port = htons(port_); a.sin_addr.s_addr = htonl(INADDR_ANY);
+    if (::bind(lfd_, (sockaddr*)&a, sizeof(a)) < 0 || ::listen(lfd_, 32) < 0){
+      fprintf(stderr, "WebServer: cannot listen on port %d\n", port_); exit(1);
+    }
+    fcntl(lfd_, F_SETFL, fcntl(lfd_, F_GETFL, 0) | O_NONBLOCK);
+  }
+  int port() const { return port_; }
+
+  void on(const String& uri, THandlerFunction fn){ on(uri, HTTP_ANY, fn); }
+  void on(const String& uri, HTTPMethod m, THandlerFunction fn){ routes_.push_back({uri, m, fn}); }
+  void onNotFound(THandlerFunction fn){ notFound_ = fn; }
+  void collectHeaders(const char* keys[], size_t n){ (void)keys; (void)n; }   // host keeps all headers
+
+  void handleClient(){
+    int fd = ::accept(lfd_, nullptr, nullptr);
+    if (fd < 0){ delay(1); return; }
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+    int sndbuf = 16 * 1024;                      // lwIP's TCP_SND_BUF is small; keep backpressure realistic
+    setsockopt(fd, SOL_SOCKET, SO_SNDBUF, &sndbuf, sizeof(sndbuf));
+    _currentClient = WiFiClient(fd);
+    _currentStatus = HC_WAIT_READ;
+    if (parse_()) dispatch_();
+    _currentClient = WiFiClient();
+    _currentStatus = HC_NONE;
+  }
+
+  // ---- request ----
+  String     uri() const { return uri_; }
+  HTTPMethod method() const { return method_; }
+  WiFiClient client(){ return _currentClient; }
+  String arg(const String& name) const {
+    for (auto& a : args_) if (a.first == name) return a.second;
+    return String();
+  }
+  String arg(int i) const { return i < (int)args_.size() ? args_[i].second : String(); }
+  String argName(int i) const { return i < (int)args_.size() ? args_[i].first : String(); }
+  int    args() const { return (int)args_.size(); }
+  bool   hasArg(const String& name) const { for (auto& a : args_) if (a.first == name) return true; return false; }
+  String header(const String& name) const {
+    for (auto& h : hdrs_) if (h.first.equalsIgnoreCase(name)) return h.second;
+    return String();
+  }
+  bool   hasHeader(const String& name) const { for (auto& h : hdrs_) if (h.first.equalsIgnoreCase(name)) return true; return false; }
+
+  // ---- response ----
+  void setContentLength(size_t n){ contentLength_ = n; }
+  void sendHeader(const String& k, const String& v, bool first = false){
+    String line = k + ": " + v + "\r\n";
+    if (first) respHeaders_ = line + respHeaders_; else respHeaders_ += line;
+  }
+  void send(int code, const char* type = nullptr, const String& body = String()){
+    sendHead_(code, type, body.length());
+    if (body.length()) sendContent(body);
+  }
+  void send(int code, const String& type, const String& body){ send(code, type.c_str(), body); }
+  void send(int code, const char* type, const char* body){ send(code, type, String(body)); }
+  void send_P(int code, PGM_P type, PGM_P body){ send(code, type, String(body)); }
+  void send_P(int code, PGM_P type, PGM_P body, size_t n){
+    sendHead_(code, type, n); sendContent(body, n);
+  }
+  void sendContent(const String& s){ sendContent(s.c_str(), s.length()); }
+  void sendContent(const char* b, size_t n){
+    if (chunked_){
+      char h[16]; int hl = snprintf(h, sizeof(h), "%zx\r\n", n);
+      _currentClient.write((const uint8_t*)h, hl);
+      if (n) _currentClient.write((const uint8_t*)b, n);
+      _currentClient.write((const uint8_t*)"\r\n", 2);
+      if (!n) chunked_ = false;
+    } else if (n){
+      _currentClient.write((const uint8_t*)b, n);
+    }
+  }
+  void sendContent_P(PGM_P b){ sendContent(b, strlen(b)); }
+  void sendContent_P(PGM_P b, size_t n){ sendContent(b, n); }
+
+protected:
+  WiFiClient       _currentClient;
+  HTTPClientStatus _currentStatus = HC_NONE;
+
+private:
+  struct Route { String uri; HTTPMethod m; THandlerFunction fn; };
+
+  static String urldecode_(const String& s){
+    String r; const char* p = s.c_str();
+    for (; *p; p++){
+      if (*p == '+') r += ' ';
+      else if (*p == '%' && p[1] && p[2]){ char h[3] = { p[1], p[2], 0 }; r += (char)strtol(h, nullptr, 16); p += 2; }
+      else r += *p;
+    }
+    return r;
+  }
+  void parseArgs_(const String& q){
+    unsigned i = 0;
+    while (i < q.length()){
+      int amp = q.indexOf('&', i); if (amp < 0) amp = q.length();
+      String kv = q.substring(i, amp);
+      int eq = kv.indexOf('=');
+      if (kv.length()) args_.push_back({ urldecode_(eq < 0 ? kv : kv.substring(0, eq)), eq < 0 ? String() : urldecode_(kv.substring(eq + 1)) });
+      i = amp + 1;
+    }
+  }
+  bool parse_(){
+    args_.clear(); hdrs_.clear(); respHeaders_ = String();
+    contentLength_ = CONTENT_LENGTH_NOT_SET; chunked_ = false;
+    _currentClient.setTimeout(2);
+    String line = _currentClient.readStringUntil('\n'); line.trim();
+    int s1 = line.indexOf(' '), s2 = line.indexOf(' ', s1 + 1);
+    if (s1 < 0 || s2 < 0) return false;
+    String m = line.substring(0, s1), u = line.substring(s1 + 1, s2);
+    method_ = m == "GET" ? HTTP_GET : m == "POST" ? HTTP_POST : m == "HEAD" ? HTTP_HEAD :
+              m == "PUT" ? HTTP_PUT : m == "DELETE" ? HTTP_DELETE : m == "OPTIONS" ? HTTP_OPTIONS : HTTP_PATCH;
+    int qm = u.indexOf('?');
+    uri_ = qm < 0 ? u : u.substring(0, qm);
+    if (qm >= 0) parseArgs_(u.substring(qm + 1));
+    size_t clen = 0; String ctype;
+    for (;;){
+      String h = _currentClient.readStringUntil('\n'); h.trim();
+      if (!h.length()) break;
+      int c = h.indexOf(':'); if (c < 0) continue;
+      String k = h.substring(0, c), v = h.substring(c + 1); v.trim();
+      if (k.equalsIgnoreCase("Content-Length")) clen = v.toInt();
+      if (k.equalsIgnoreCase("Content-Type")) ctype = v;
+      hdrs_.push_back({ k, v });
+    }
+    if (clen){
+      std::string body(clen, '\0');
+      size_t got = _currentClient.readBytes((uint8_t*)&body[0], clen);
+      body.resize(got);
+      if (ctype.startsWith("application/x-www-form-urlencoded")) parseArgs_(String(body));
+      else args_.push_back({ "plain", String(body) });
+    }
+    return true;
+  }
+  void dispatch_(){
+    for (auto& r : routes_){
+      if (r.uri != uri_) continue;
+      if (r.m != HTTP_ANY && r.m != method_) continue;
+      r.fn();
+      if (chunked_) sendContent("", 0);
+      return;
+    }
+    if (notFound_) notFound_(); else send(404, "text/plain", "Not found");
+  }
+  void sendHead_(int code, const char* type, size_t bodyLen){
+    size_t len = contentLength_ == CONTENT_LENGTH_NOT_SET ? bodyLen : contentLength_;
+    String h = String("HTTP/1.1 ") + code + (code < 300 ? " OK" : code < 400 ? " Redirect" : " Error") + "\r\n";
+    if (type && *type) h += String("Content-Type: ") + type + "\r\n";
+    if (len == CONTENT_LENGTH_UNKNOWN){ h += "Transfer-Encoding: chunked\r\n"; chunked_ = true; }
+    else h += String("Content-Length: ") + (unsigned long)len + "\r\n";
+    h += respHeaders_;
+    h += "Connection: close\r\n\r\n";
+    _currentClient.write((const uint8_t*)h.c_str(), h.length());
+    respHeaders_ = String();
+  }
+
+  int                                   port_;
+  int                                   lfd_ = -1;
+  std::vector<Route>                    routes_;
+  THandlerFunction                      notFound_;
+  String                                uri_;
+  HTTPMethod                            method_ = HTTP_GET;
+  std::vector<std::pair<String,String>> args_, hdrs_;
+  String                                respHeaders_;
+  size_t                                contentLength_ = CONTENT_LENGTH_NOT_SET;
+  bool                                  chunked_ = false;
+};
@@ -0,0 +1,123 @@
+#pragma once
+// Host stand-in for WiFi.h: SoftAP calls are no-ops, WiFiClient wraps a real
+// loopback TCP socket with the same shared-handle semantics as the ESP32 core
+// (copies share the socket; it closes when the last copy goes away).
+#include <Arduino.h>
+#include <memory>
+#include "lwip/sockets.h"
+
+typedef enum { WIFI_OFF = 0, WIFI_STA, WIFI_AP, WIFI_AP_STA } wifi_mode_t;
+#define WIFI_MODE_AP WIFI_AP
+
+struct native_sock {
+  int fd;
+  explicit native_sock(int f) : fd(f) {}
+  ~native_sock(){ if (fd >= 0) ::close(fd); }
+};
+
+class WiFiClient {
+public:
+  WiFiClient() {}
+  explicit WiFiClient(int fd) : h_(std::make_shared<native_sock>(fd)) {
+    int one = 1; setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+  }
+
+  int  fd() const { return h_ ? h_->fd : -1; }
+  explicit operator bool() const { return connected(); }
+  bool operator==(const WiFiClient& o) const { return h_ == o.h_; }
+
+  uint8_t connected() const {
+    if (!h_) return 0;
+    char c;
+    ssize_t n = ::recv(h_->fd, &c, 1, MSG_PEEK | MSG_DONTWAIT);
+    if (n > 0) return 1;
+    if (n == 0) return 0;
+    return (errno == EAGAIN || errno == EWOULDBLOCK) ? 1 : 0;
+  }
+  int available(){
+    if (!h_) return 0;
+    int n = 0; if (ioctl(h_->fd, FIONREAD, &n) < 0) return 0; return n;
+  }
+  int read(){
+    uint8_t c; return read(&c, 1) == 1 ? c : -1;
+  }
+  int read(uint8_t* b, size_t n){
+    if (!h_) return -1;
+    ssize_t r = ::recv(h_->fd, b, n, MSG_DONTWAIT);
+    return r < 0 ? -1 : (int)r;
+  }
+  size_t readBytes(uint8_t* b, size_t n){
+    size_t got = 0; unsigned long t0 = millis();
+    while (got < n && millis() - t0 < timeout_ms_){
+      int r = read(b + got, n - got);
+      if (r > 0) got += r; else if (r == 0 || !connected()) break; else delay(1);
+    }
+    return got;
+  }
+  size_t readBytes(char* b, size_t n){ return readBytes((uint8_t*)b, n); }
+  String readStringUntil(char term){
+    String s; int c;
+    unsigned long t0 = millis();
+    while (millis() - t0 < timeout_ms_){
+      if ((c = read()) < 0){ if (!connected()) break; delay(1); continue; }
+      if (c == term) break;
+      s += (char)c;
+    }
+    return s;
+  }
+
+  size_t write(const uint8_t* b, size_t n){
+    if (!h_) return 0;
+    size_t sent = 0; unsigned long t0 = millis();
+    while (sent < n){
+      ssize_t r = ::send(h_->fd, b + sent, n - sent, MSG_NOSIGNAL);
+      if (r > 0){ sent += r; continue; }
+      if (r < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)){
+        if (millis() - t0 > timeout_ms_) break;
+        pollfd p = { h_->fd, POLLOUT, 0 }; ::poll(&p, 1, 10); continue;
+      }
+      break;
+    }
+    return sent;
+  }
+  size_t write(const char* b, size_t n){ return write((const uint8_t*)b, n); }
+  size_t write(uint8_t c){ return write(&c, 1); }
+  size_t print(const char* s){ return write((const uint8_t*)s, strlen(s)); }
+  size_t print(const String& s){ return write((const uint8_t*)s.c_str(), s.length()); }
+  size_t println(const char* s){ return print(s) + print("\r\n"); }
+  size_t printf(const char* fmt, ...) __attribute__((format(printf, 2, 3))){
+    char b[512]; va_list ap; va_start(ap, fmt); int n = vsnprintf(b, sizeof(b), fmt, ap); va_end(ap);
+    return n > 0 ? write((const uint8_t*)b, std::min<size_t>(n, sizeof(b) - 1)) : 0;
+  }
+  void flush(){}
+  void stop(){ h_.reset(); }
+  void setTimeout(uint32_t seconds){ timeout_ms_ = seconds * 1000; }
+  int  setNoDelay(bool on){ int v = on; return h_ ? setsockopt(h_->fd, IPPROTO_TCP, TCP_NODELAY, &v, sizeof(v)) : -1; }
+
+  IPAddress remoteIP() const {
+    sockaddr_in a = {}; socklen_t l = sizeof(a);
+    if (!h_ || getpeername(h_->fd, (sockaddr*)&a, &l) < 0) return IPAddress();
+    return IPAddress((uint32_t)a.sin_addr.s_addr);
+  }
+  uint16_t remotePort() const {
+    sockaddr_in a = {}; socklen_t l = sizeof(a);
+    if (!h_ || getpeername(h_->fd, (sockaddr*)&a, &l) < 0) return 0;
+    return ntohs(a.sin_port);
+  }
+
+private:
+  std::shared_ptr<native_sock> h_;
+  unsigned long                timeout_ms_ = 3000;
+};
+
+class WiFiClass {
+public:
+  bool      mode(wifi_mode_t){ return true; }
+  bool      softAP(const char*, const char* = nullptr, int = 1, int = 0, int = 4){ return true; }
+  bool      softAPConfig(IPAddress, IPAddress, IPAddress){ return true; }
+  IPAddress softAPIP(){ return IPAddress(127, 0, 0, 1); }
+  uint8_t   softAPgetStationNum(){ return 1; }
+  bool      setSleep(bool){ return true; }
+  bool      setTxPower(int){ return true; }
+};
+inline WiFiClass WiFi;
@@ -0,0 +1,303 @@
+#pragma once
+// Mock esp32-camera driver. Frames are paced at MOCK_CAM_FPS (default 25) at a
+// 24 MHz XCLK, proportionally slower at lower clocks, and are either a recorded
+// JPEG sequence replayed from MOCK_CAM_DIR (sorted *.jpg) or a synthetic moving
+// test pattern encoded once per (framesize, quality). With one frame buffer the
+// next readout starts at the VSYNC after the buffer is taken, as on the real
+// driver.
+// MOCK_CAM_XCLK_MAX (Hz) makes init fail above that clock, like a weak board.
+// MOCK_CAM_STALL_AFTER=N stalls the sensor N frames after each init: fb_get
+// returns NULL after 1 s (the real driver gives up after 4 s) until the next
+// init, or MOCK_CAM_STALL_REINITS inits later. MOCK_CAM_STALL_SCCB=1 also
+// makes register reads and those inits fail while stalled (SCCB bus stuck).
+#include <Arduino.h>
+#include <dirent.h>
+#include <sys/time.h>
+#include <algorithm>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+#include "esp_err.h"
+#include "mock_jpeg.h"
+
+typedef enum {
+  PIXFORMAT_RGB565, PIXFORMAT_YUV422, PIXFORMAT_YUV420, PIXFORMAT_GRAYSCALE, PIXFORMAT_JPEG,
+  PIXFORMAT_RGB888, PIXFORMAT_RAW, PIXFORMAT_RGB444, PIXFORMAT_RGB555,
+} pixformat_t;
+
+typedef enum {
+  FRAMESIZE_96X96, FRAMESIZE_QQVGA, FRAMESIZE_QCIF, FRAMESIZE_HQVGA, FRAMESIZE_240X240,
+  FRAMESIZE_QVGA, FRAMESIZE_CIF, FRAMESIZE_HVGA, FRAMESIZE_VGA, FRAMESIZE_SVGA, FRAMESIZE_XGA,
+  FRAMESIZE_HD, FRAMESIZE_SXGA, FRAMESIZE_UXGA, FRAMESIZE_INVALID
+} framesize_t;
+
+typedef struct { uint16_t width; uint16_t height; } resolution_info_t;
+static const resolution_info_t resolution[FRAMESIZE_INVALID] = {
+  {96,96}, {160,120}, {176,144}, {240,176}, {240,240}, {320,240}, {400,296}, {480,320},
+  {640,480}, {800,600}, {1024,768}, {1280,720}, {1280,1024}, {1600,1200},
+};
+
+typedef enum { CAMERA_GRAB_WHEN_EMPTY, CAMERA_GRAB_LATEST } camera_grab_mode_t;
+typedef enum { CAMERA_FB_IN_PSRAM, CAMERA_FB_IN_DRAM } camera_fb_location_t;
+typedef enum { LEDC_CHANNEL_0 } ledc_channel_t;
+typedef enum { LEDC_TIMER_0 } ledc_timer_t;
+
+typedef struct {
+  int pin_pwdn, pin_reset, pin_xclk;
+  int pin_sccb_sda, pin_sccb_scl;
+  int pin_d7, pin_d6, pin_d5, pin_d4, pin_d3, pin_d2, pin_d1, pin_d0;
+  int pin_vsync, pin_href, pin_pclk;
+  int xclk_freq_hz;
+  ledc_timer_t ledc_timer;
+  ledc_channel_t ledc_channel;
+  pixformat_t pixel_format;
+  framesize_t frame_size;
+  int jpeg_quality;
+  size_t fb_count;
+  camera_fb_location_t fb_location;
+  camera_grab_mode_t grab_mode;
+  int sccb_i2c_port;
+} camera_config_t;
+
+typedef struct {
+  uint8_t*       buf;
+  size_t         len;
+  size_t         width;
+  size_t         height;
+  pixformat_t    format;
+  struct timeval timestamp;
+} camera_fb_t;
+
+typedef struct { uint8_t MIDH; uint8_t MIDL; uint16_t PID; uint8_t VER; } sensor_id_t;
+typedef struct {
+  framesize_t framesize; int scale, binning; uint8_t quality;
+  int8_t brightness, contrast, saturation, sharpness, denoise, special_effect, wb_mode;
+  uint8_t awb, awb_gain, aec, aec2; int8_t ae_level; uint16_t aec_value; uint8_t agc, agc_gain, gainceiling;
+  uint8_t bpc, wpc, raw_gma, lenc, hmirror, vflip, dcw, colorbar;
+} camera_status_t;
+
+typedef struct _sensor sensor_t;
+struct _sensor {
+  sensor_id_t     id;
+  uint8_t         slv_addr;
+  pixformat_t     pixformat;
+  camera_status_t status;
+  int  (*set_framesize)     (sensor_t*, framesize_t);
+  int  (*set_quality)       (sensor_t*, int);
+  int  (*set_brightness)    (sensor_t*, int);
+  int  (*set_contrast)      (sensor_t*, int);
+  int  (*set_saturation)    (sensor_t*, int);
+  int  (*set_ae_level)      (sensor_t*, int);
+  int  (*set_whitebal)      (sensor_t*, int);
+  int  (*set_exposure_ctrl) (sensor_t*, int);
+  int  (*set_gain_ctrl)     (sensor_t*, int);
+  int  (*set_vflip)         (sensor_t*, int);
+  int  (*set_hmirror)       (sensor_t*, int);
+  int  (*get_reg)           (sensor_t*, int reg, int mask);
+  int  (*set_reg)           (sensor_t*, int reg, int mask, int value);
+  int  (*set_xclk)          (sensor_t*, int timer, int xclk_mhz);
+};
+
+#define OV2640_PID 0x26
+
+namespace mock_cam {
+
+struct State {
+  std::mutex                 m;
+  std::condition_variable    cv;
+  bool                       up = false;
+  camera_config_t            cfg = {};
+  sensor_t                   sensor = {};
+  std::vector<camera_fb_t>   fbs;
+  std::vector<bool>          busy;
+  int64_t                    next_us = 0;
+  int64_t                    t_init = 0;             // VSYNC grid origin
+  uint32_t                   frame_no = 0;
+  uint32_t                   since_init = 0;         // frames since the last init
+  bool                       stalled = false;
+  int                        stall_inits = 0;        // inits the stall still survives
+  int                        stale = 0;              // frames still read out at stale_fs after a switch
+  framesize_t                stale_fs = FRAMESIZE_INVALID;
+  std::map<std::pair<int,int>, std::vector<std::vector<uint8_t>>> synth;   // (fs, q) -> frame loop
+  std::vector<std::vector<uint8_t>> recorded;
+};
+inline State& st(){ static State s; return s; }
+
+inline int fps(){ const char* e = getenv("MOCK_CAM_FPS"); int v = e ? atoi(e) : 25; return v > 0 ? v : 25; }
+inline int env_int(const char* k){ const char* e = getenv(k); return e ? atoi(e) : 0; }
+inline int xclk_max(){ return env_int("MOCK_CAM_XCLK_MAX"); }
+
+inline void loadRecorded(State& s){
+  const char* dir = getenv("MOCK_CAM_DIR");
+  if (!dir || !s.recorded.empty()) return;
+  std::vector<std::string> names;
+  if (DIR* d = opendir(dir)){
+    while (dirent* e = readdir(d)){
+      std::string n = e->d_name;
+      if (n.size() > 4 && (n.substr(n.size() - 4) == ".jpg" || n.substr(n.size() - 5) == ".jpeg")) names.push_back(n);
+    }
+    closedir(d);
+  }
+  std::sort(names.begin(), names.end());
+  for (auto& n : names){
+    FILE* f = fopen((std::string(dir) + "/" + n).c_str(), "rb"); if (!f) continue;
+    std::vector<uint8_t> b; uint8_t tmp[4096]; size_t r;
+    while ((r = fread(tmp, 1, sizeof(tmp), f)) > 0) b.insert(b.end(), tmp, tmp + r);
+    fclose(f);
+    s.recorded.push_back(std::move(b));
+  }
+}
+
+// 16-frame loop: gradient background, a block sweeping across, a nozzle-ish bar.
+// Frames are encoded on first use so a quality/framesize change costs one
+// encode per frame period instead of a burst of sixteen.
+static const int kSynthFrames = 16;
+inline const std::vector<uint8_t>& synth(State& s, framesize_t fs, int q, uint32_t n){
+  auto& seq = s.synth[std::make_pair((int)fs, q)];
+  if (seq.empty()) seq.resize(kSynthFrames);
+  int f = (int)(n % kSynthFrames);
+  if (!seq[f].empty()) return seq[f];
+  int w = resolution[fs].width, h = resolution[fs].height;
+  // Heap, not the caller's stack: the real fb_get encodes nothing, and the
+  // ~3 KB of tables would inflate stack high-water marks of capture callers.
+  std::unique_ptr<mock_jpeg::Encoder> enc(new mock_jpeg::Encoder(std::max(5, 100 - q * 2)));
+  std::vector<uint8_t> rgb((size_t)w * h * 3);
+  int bx = (w - w / 6) * f / (kSynthFrames - 1), by = h / 3;
+  for (int y = 0; y < h; y++) for (int x = 0; x < w; x++){
+    uint8_t* p = &rgb[((size_t)y * w + x) * 3];
+    p[0] = (uint8_t)(x * 255 / w); p[1] = (uint8_t)(y * 255 / h); p[2] = 96;
+    if (x >= bx && x < bx + w / 6 && y >= by && y < by + h / 4){ p[0] = 240; p[1] = 200; p[2] = 40; }
+    if (x > w / 2 - 8 && x < w / 2 + 8 && y < h / 3){ p[0] = p[1] = p[2] = 30; }
+  }
+  return seq[f] = enc->encode(rgb.data(), w, h);
+}
+
+// Like the real sensor, the frame already being read out keeps the old size.
+inline int s_framesize(sensor_t* s, framesize_t f){
+  if (f >= FRAMESIZE_INVALID) return -1;
+  if (f != s->status.framesize){ st().stale_fs = s->status.framesize; st().stale = 1; }
+  s->status.framesize = f;
+  return 0;
+}
+inline int s_quality(sensor_t* s, int q){ s->status.quality = (uint8_t)q; return 0; }
+inline int s_generic(sensor_t*, int){ return 0; }
+inline int s_vflip(sensor_t* s, int v){ s->status.vflip = (uint8_t)v; return 0; }
+inline int s_hmirror(sensor_t* s, int v){ s->status.hmirror = (uint8_t)v; return 0; }
+inline int s_get_reg(sensor_t*, int, int mask){
+  return st().stalled && env_int("MOCK_CAM_STALL_SCCB") ? -1 : 0x26 & mask;
+}
+inline int s_set_reg(sensor_t*, int, int, int){ return 0; }
+inline int s_set_xclk(sensor_t*, int, int){ return 0; }
+
+} // namespace mock_cam
+
+inline esp_err_t esp_camera_init(const camera_config_t* c){
+  auto& s = mock_cam::st();
+  std::lock_guard<std::mutex> lk(s.m);
+  if (mock_cam::xclk_max() && c->xclk_freq_hz > mock_cam::xclk_max()) return ESP_FAIL;
+  if (s.stalled && s.stall_inits <= 0) s.stalled = false;
+  else if (s.stalled){
+    s.stall_inits--;
+    if (mock_cam::env_int("MOCK_CAM_STALL_SCCB")) return ESP_ERR_NOT_FOUND;   // no sensor on the bus
+  }
+  s.cfg = *c;
+  s.sensor = {};
+  s.sensor.id.PID = OV2640_PID;
+  s.sensor.pixformat = c->pixel_format;
+  s.sensor.status.framesize = c->frame_size;
+  s.sensor.status.quality = (uint8_t)c->jpeg_quality;
+  s.sensor.set_framesize = mock_cam::s_framesize;   s.sensor.set_quality = mock_cam::s_quality;
+  s.sensor.set_brightness = mock_cam::s_generic;    s.sensor.set_contrast = mock_cam::s_generic;
+  s.sensor.set_saturation = mock_cam::s_generic;    s.sensor.set_ae_level = mock_cam::s_generic;
+  s.sensor.set_whitebal = mock_cam::s_generic;      s.sensor.set_exposure_ctrl = mock_cam::s_generic;
+  s.sensor.set_gain_ctrl = mock_cam::s_generic;     s.sensor.set_vflip = mock_cam::s_vflip;
+  s.sensor.set_hmirror = mock_cam::s_hmirror;       s.sensor.get_reg = mock_cam::s_get_reg;
+  s.sensor.set_reg = mock_cam::s_set_reg;           s.sensor.set_xclk = mock_cam::s_set_xclk;
+  size_t n = c->fb_count ? c->fb_count : 1;
+  s.fbs.assign(n, camera_fb_t{});
+  s.busy.assign(n, false);
+  s.next_us = s.t_init = esp_timer_get_time();
+  s.since_init = 0;
+  mock_cam::loadRecorded(s);
+  s.up = true;
+  return ESP_OK;
+}
+
+inline esp_err_t esp_camera_deinit(){
+  auto& s = mock_cam::st();
+  std::lock_guard<std::mutex> lk(s.m);
+  for (auto& fb : s.fbs) free(fb.buf);
+  s.fbs.clear(); s.busy.clear();
+  s.up = false;
+  s.cv.notify_all();
+  return ESP_OK;
+}
+
+inline sensor_t* esp_camera_sensor_get(){
+  auto& s = mock_cam::st();
+  return s.up ? &s.sensor : nullptr;
+}
+
+inline camera_fb_t* esp_camera_fb_get(){
+  auto& s = mock_cam::st();
+  std::unique_lock<std::mutex> lk(s.m);
+  if (!s.up) return nullptr;
+  int idx = -1;
+  bool ok = s.cv.wait_for(lk, std::chrono::seconds(4), [&]{
+    if (!s.up) return true;
+    for (size_t i = 0; i < s.busy.size(); i++) if (!s.busy[i]){ idx = (int)i; return true; }
+    return false;
+  });
+  if (!ok || !s.up || idx < 0) return nullptr;
+  int stall_after = mock_cam::env_int("MOCK_CAM_STALL_AFTER");
+  if (stall_after && !s.stalled && s.since_init >= (uint32_t)stall_after){
+    s.stalled = true; s.stall_inits = mock_cam::env_int("MOCK_CAM_STALL_REINITS");
+  }
+  if (s.stalled){
+    lk.unlock();
+    std::this_thread::sleep_for(std::chrono::seconds(1));
+    return nullptr;
+  }
+  s.since_init++;
+  s.busy[idx] = true;
+
+  int xclk = s.cfg.xclk_freq_hz > 0 ? s.cfg.xclk_freq_hz : 24000000;
+  int64_t period = 1000000LL * 24000000 / ((int64_t)mock_cam::fps() * xclk);
+  int64_t now = esp_timer_get_time();
+  if (s.next_us < now - period) s.next_us = now;        // a slow consumer does not earn a burst
+  if (s.fbs.size() == 1){                               // readout waits for the next VSYNC
+    int64_t vsync = now + (period - (now - s.t_init) % period) % period;
+    s.next_us = std::max(s.next_us, vsync + period);
+  }
+  int64_t wait = s.next_us - now;
+  s.next_us += period;
+  lk.unlock();
+  if (wait > 0) std::this_thread::sleep_for(std::chrono::microseconds(wait));
+  lk.lock();
+
+  const std::vector<uint8_t>* src;
+  if (!s.recorded.empty()) src = &s.recorded[s.frame_no % s.recorded.size()];
+  else {
+    framesize_t fs = s.sensor.status.framesize;
+    if (s.stale > 0){ s.stale--; fs = s.stale_fs; }
+    src = &mock_cam::synth(s, fs, s.sensor.status.quality, s.frame_no);
+  }
+  s.frame_no++;
+  camera_fb_t& fb = s.fbs[idx];
+  fb.buf = (uint8_t*)realloc(fb.buf, src->size());
+  memcpy(fb.buf, src->data(), src->size());
+  fb.len = src->size();
+  fb.width = resolution[s.sensor.status.framesize].width;
+  fb.height = resolution[s.sensor.status.framesize].height;
+  fb.format = PIXFORMAT_JPEG;
+  gettimeofday(&fb.timestamp, nullptr);
+  return &fb;
+}
+
+inline void esp_camera_fb_return(camera_fb_t* fb){
+  auto& s = mock_cam::st();
+  { std::lock_guard<std::mutex> lk(s.m);
+    for (size_t i = 0; i < s.fbs.size(); i++) if (&s.fbs[i] == fb) s.busy[i] = false; }
+  s.cv.notify_all();
+}
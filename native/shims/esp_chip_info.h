@@ -0,0 +1,7 @@
+#pragma once
+#include <stdint.h>
+
+typedef enum { CHIP_ESP32 = 1, CHIP_ESP32S3 = 9 } esp_chip_model_t;
+typedef struct { esp_chip_model_t model; uint32_t features; uint16_t revision; uint8_t cores; } esp_chip_info_t;
+
+inline void esp_chip_info(esp_chip_info_t* i){ i->model = CHIP_ESP32S3; i->features = 0; i->revision = 0; i->cores = 2; }
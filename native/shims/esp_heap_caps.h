@@ -0,0 +1,22 @@
+#pragma once
+#include <stdint.h>
+#include <stdlib.h>
+
+#define MALLOC_CAP_EXEC       (1<<0)
+#define MALLOC_CAP_32BIT      (1<<1)
+#define MALLOC_CAP_8BIT       (1<<2)
+#define MALLOC_CAP_DMA        (1<<3)
+#define MALLOC_CAP_SPIRAM     (1<<10)
+#define MALLOC_CAP_INTERNAL   (1<<11)
+#define MALLOC_CAP_DEFAULT    (1<<12)
+
+// Budgets mirror the T-Camera Plus S3 (8 MB PSRAM, ~300 kB free internal) so the
+// reported numbers look familiar; allocations themselves come from the host heap.
+inline void*  heap_caps_malloc(size_t n, uint32_t){ return malloc(n); }
+inline void*  heap_caps_calloc(size_t n, size_t m, uint32_t){ return calloc(n, m); }
+inline void*  heap_caps_realloc(void* p, size_t n, uint32_t){ return realloc(p, n); }
+inline void   heap_caps_free(void* p){ free(p); }
+inline size_t heap_caps_get_free_size(uint32_t caps){ return (caps & MALLOC_CAP_SPIRAM) ? 8u*1024*1024 : 300u*1024; }
+inline size_t heap_caps_get_minimum_free_size(uint32_t caps){ return heap_caps_get_free_size(caps); }
+inline size_t heap_caps_get_largest_free_block(uint32_t caps){ return heap_caps_get_free_size(caps); }
+inline size_t heap_caps_get_total_size(uint32_t caps){ return (caps & MALLOC_CAP_SPIRAM) ? 8u*1024*1024 : 400u*1024; }
@@ -0,0 +1,12 @@
+#pragma once
+#include <stdlib.h>
+#include <random>
+#include "esp_err.h"
+#include "esp_heap_caps.h"
+
+typedef enum { ESP_RST_UNKNOWN, ESP_RST_POWERON, ESP_RST_SW, ESP_RST_PANIC, ESP_RST_BROWNOUT } esp_reset_reason_t;
+
+inline void     esp_restart(){ exit(0); }
+inline uint32_t esp_get_free_heap_size(){ return (uint32_t)heap_caps_get_free_size(MALLOC_CAP_8BIT); }
+inline uint32_t esp_random(){ static std::random_device rd; return rd(); }
+inline esp_reset_reason_t esp_reset_reason(){ return ESP_RST_POWERON; }
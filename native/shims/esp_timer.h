@@ -0,0 +1,5 @@
+#pragma once
+#include <stdint.h>
+#include "freertos/FreeRTOS.h"
+
+inline int64_t esp_timer_get_time(){ return native_rt::micros_since_start(); }
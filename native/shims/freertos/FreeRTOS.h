@@ -0,0 +1,54 @@
+#pragma once
+// Host stand-in for the FreeRTOS subset the firmware uses (tasks on std::thread,
+// task notifications, mutex/counting semaphores, portMUX critical sections).
+#include <stdint.h>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <pthread.h>
+
+typedef uint32_t     TickType_t;
+typedef int          BaseType_t;
+typedef unsigned     UBaseType_t;
+typedef void (*TaskFunction_t)(void*);
+
+#define pdTRUE              1
+#define pdFALSE             0
+#define pdPASS              1
+#define pdFAIL              0
+#define portMAX_DELAY       0xffffffffu
+#define portTICK_PERIOD_MS  1
+#define configTICK_RATE_HZ  1000
+#define pdMS_TO_TICKS(ms)   ((TickType_t)(ms))
+#define tskIDLE_PRIORITY    0
+#define tskNO_AFFINITY      (-1)
+#define PRO_CPU_NUM         0
+#define APP_CPU_NUM         1
+#define configMAX_PRIORITIES 25
+
+namespace native_rt {
+inline uint32_t millis_since_start(){
+  static const auto t0 = std::chrono::steady_clock::now();
+  return (uint32_t)std::chrono::duration_cast<std::chrono::milliseconds>(
+    std::chrono::steady_clock::now() - t0).count();
+}
+inline int64_t micros_since_start(){
+  static const auto t0 = std::chrono::steady_clock::now();
+  return (int64_t)std::chrono::duration_cast<std::chrono::microseconds>(
+    std::chrono::steady_clock::now() - t0).count();
+}
+inline void sleep_ms(uint32_t ms){ std::this_thread::sleep_for(std::chrono::milliseconds(ms)); }
+} // namespace native_rt
+
+// -------------------- critical sections --------------------
+struct portMUX_TYPE { std::recursive_mutex m; };
+#define portMUX_INITIALIZER_UNLOCKED {}
+#define portENTER_CRITICAL(mux)      ((mux)->m.lock())
+#define portEXIT_CRITICAL(mux)       ((mux)->m.unlock())
+#define portENTER_CRITICAL_ISR(mux)  portENTER_CRITICAL(mux)
+#define portEXIT_CRITICAL_ISR(mux)   portEXIT_CRITICAL(mux)
+#define taskENTER_CRITICAL(mux)      portENTER_CRITICAL(mux)
+#define taskEXIT_CRITICAL(mux)       portEXIT_CRITICAL(mux)
+
+inline BaseType_t xPortGetCoreID();
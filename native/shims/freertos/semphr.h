@@ -0,0 +1,31 @@
+#pragma once
+#include "FreeRTOS.h"
+
+struct native_sem {
+  std::mutex              m;
+  std::condition_variable cv;
+  uint32_t                count;
+  uint32_t                max;
+};
+typedef native_sem* SemaphoreHandle_t;
+
+inline SemaphoreHandle_t xSemaphoreCreateCounting(uint32_t max, uint32_t init){
+  native_sem* s = new native_sem(); s->count = init; s->max = max; return s;
+}
+inline SemaphoreHandle_t xSemaphoreCreateMutex(){ return xSemaphoreCreateCounting(1, 1); }
+inline SemaphoreHandle_t xSemaphoreCreateBinary(){ return xSemaphoreCreateCounting(1, 0); }
+inline void vSemaphoreDelete(SemaphoreHandle_t s){ delete s; }
+
+inline BaseType_t xSemaphoreTake(SemaphoreHandle_t s, TickType_t ticks){
+  std::unique_lock<std::mutex> lk(s->m);
+  auto ready = [s]{ return s->count > 0; };
+  if (ticks == portMAX_DELAY) s->cv.wait(lk, ready);
+  else if (!s->cv.wait_for(lk, std::chrono::milliseconds(ticks), ready)) return pdFALSE;
+  s->count--;
+  return pdTRUE;
+}
+inline BaseType_t xSemaphoreGive(SemaphoreHandle_t s){
+  { std::lock_guard<std::mutex> lk(s->m); if (s->count >= s->max) return pdFALSE; s->count++; }
+  s->cv.notify_one();
+  return pdTRUE;
+}
@@ -0,0 +1,83 @@
+#pragma once
+#include "FreeRTOS.h"
+#include <string>
+
+struct native_task {
+  std::string             name;
+  TaskFunction_t          fn;
+  void*                   arg;
+  int                     core;
+  std::mutex              m;
+  std::condition_variable cv;
+  uint32_t                notify = 0;
+  uint32_t                stack = 0;                  // requested depth, bytes
+  const uint8_t*          stack_lo = nullptr;         // lowest painted byte
+};
+typedef native_task* TaskHandle_t;
+
+namespace native_rt {
+inline native_task*& current_task(){ static thread_local native_task* t = nullptr; return t; }
+inline native_task* self(){
+  native_task*& t = current_task();
+  if (!t){ t = new native_task(); t->name = "main"; t->core = 1; }
+  return t;
+}
+// Paint the task's requested depth below this frame with FreeRTOS's fill byte;
+// the task body then runs over it, so uxTaskGetStackHighWaterMark() can count
+// what is left. Host frames are larger than Xtensa ones: the figure errs low.
+__attribute__((noinline)) inline void paint_stack(native_task* t){
+  volatile uint8_t b[t->stack];
+  for (uint32_t i = 0; i < t->stack; i++) b[i] = 0xA5;
+  t->stack_lo = (const uint8_t*)b;
+}
+} // namespace native_rt
+
+inline BaseType_t xTaskCreatePinnedToCore(TaskFunction_t fn, const char* name, uint32_t stack,
+                                          void* arg, UBaseType_t /*prio*/, TaskHandle_t* out, BaseType_t core){
+  native_task* t = new native_task();
+  t->name = name ? name : ""; t->fn = fn; t->arg = arg; t->core = core < 0 ? 0 : core; t->stack = stack;
+  if (out) *out = t;
+  std::thread([t]{ native_rt::current_task() = t; native_rt::paint_stack(t); t->fn(t->arg); }).detach();
+  return pdPASS;
+}
+inline BaseType_t xTaskCreate(TaskFunction_t fn, const char* name, uint32_t stack, void* arg,
+                              UBaseType_t prio, TaskHandle_t* out){
+  return xTaskCreatePinnedToCore(fn, name, stack, arg, prio, out, tskNO_AFFINITY);
+}
+// Only self-deletion is used by the firmware; the handle leaks by design (tiny).
+inline void vTaskDelete(TaskHandle_t t){ if (!t || t == native_rt::self()) pthread_exit(nullptr); }
+inline TaskHandle_t xTaskGetCurrentTaskHandle(){ return native_rt::self(); }
+inline void vTaskDelay(TickType_t ticks){ native_rt::sleep_ms(ticks); }
+inline TickType_t xTaskGetTickCount(){ return native_rt::millis_since_start(); }
+inline void vTaskDelayUntil(TickType_t* last, TickType_t inc){
+  TickType_t now = xTaskGetTickCount(), next = *last + inc;
+  if ((int32_t)(next - now) > 0) native_rt::sleep_ms(next - now);
+  *last = next;
+}
+inline BaseType_t xTaskDelayUntil(TickType_t* last, TickType_t inc){ vTaskDelayUntil(last, inc); return pdTRUE; }
+inline UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t t){
+  if (!t) t = native_rt::self();
+  UBaseType_t n = 0;
+  if (t->stack_lo) while (n < t->stack && t->stack_lo[n] == 0xA5) n++;
+  return n;
+}
+inline BaseType_t xPortGetCoreID(){ return native_rt::self()->core; }
+inline void vTaskSuspendAll(){}
+inline BaseType_t xTaskResumeAll(){ return pdTRUE; }
+
+inline uint32_t ulTaskNotifyTake(BaseType_t clear, TickType_t ticks){
+  native_task* t = native_rt::self();
+  std::unique_lock<std::mutex> lk(t->m);
+  auto ready = [t]{ return t->notify != 0; };
+  if (ticks == portMAX_DELAY) t->cv.wait(lk, ready);
+  else t->cv.wait_for(lk, std::chrono::milliseconds(ticks), ready);
+  uint32_t v = t->notify;
+  if (v) t->notify = clear ? 0 : v - 1;
+  return v;
+}
+inline BaseType_t xTaskNotifyGive(TaskHandle_t t){
+  if (!t) return pdFAIL;
+  { std::lock_guard<std::mutex> lk(t->m); t->notify++; }
+  t->cv.notify_all();
+  return pdPASS;
+}
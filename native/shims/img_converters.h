@@ -0,0 +1,5 @@
+#pragma once
+#include "esp_camera.h"
+
+// The mock sensor only produces JPEG, so the conversion path is never taken.
+inline bool frame2jpg(camera_fb_t*, uint8_t, uint8_t** out, size_t* len){ *out = nullptr; *len = 0; return false; }
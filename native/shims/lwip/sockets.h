@@ -0,0 +1,38 @@
+#pragma once
+// lwIP exposes the BSD socket API under the POSIX names; the host has the real thing.
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/select.h>
+#include <sys/uio.h>
+#include <sys/ioctl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <errno.h>
+#include <linux/sockios.h>
+#include <stdlib.h>
+
+// NOZZLE_SNDBUF=B makes a TCP sendmsg take at most B bytes minus what is still
+// queued (unsent or unacked), like lwIP's tcp_sndbuf(). The host kernel would
+// otherwise swallow a whole JPEG into an empty queue in one call.
+inline ssize_t nozzle_sendmsg(int fd, const struct msghdr* m, int flags){
+  static const long cap = getenv("NOZZLE_SNDBUF") ? atol(getenv("NOZZLE_SNDBUF")) : 0;
+  int type = 0; socklen_t tl = sizeof(type);
+  if (!cap || m->msg_name || getsockopt(fd, SOL_SOCKET, SO_TYPE, &type, &tl) || type != SOCK_STREAM)
+    return ::sendmsg(fd, m, flags);
+  int queued = 0; ioctl(fd, SIOCOUTQ, &queued);
+  long room = cap - queued;
+  if (room <= 0){ errno = EAGAIN; return -1; }
+  struct iovec v[64]; struct msghdr c = *m; size_t k = 0;
+  for (; k < m->msg_iovlen && k < 64 && room > 0; k++){
+    v[k] = m->msg_iov[k];
+    if ((long)v[k].iov_len > room) v[k].iov_len = room;
+    room -= v[k].iov_len;
+  }
+  c.msg_iov = v; c.msg_iovlen = k;
+  return ::sendmsg(fd, &c, flags);
+}
+#define sendmsg nozzle_sendmsg
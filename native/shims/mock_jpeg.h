@@ -0,0 +1,173 @@
+#pragma once
+// Minimal baseline JPEG encoder (YCbCr 4:2:2, standard Huffman tables) used by
+// the mock camera to synthesise frames shaped like the OV2640's output.
+#include <stdint.h>
+#include <math.h>
+#include <string.h>
+#include <vector>
+
+namespace mock_jpeg {
+
+static const uint8_t kZigzag[64] = {
+   0, 1, 8,16, 9, 2, 3,10,17,24,32,25,18,11, 4, 5,12,19,26,33,40,48,41,34,27,20,13, 6, 7,14,21,28,
+  35,42,49,56,57,50,43,36,29,22,15,23,30,37,44,51,58,59,52,45,38,31,39,46,53,60,61,54,47,55,62,63 };
+
+static const uint8_t kStdLumQ[64] = {
+  16,11,10,16,24,40,51,61, 12,12,14,19,26,58,60,55, 14,13,16,24,40,57,69,56, 14,17,22,29,51,87,80,62,
+  18,22,37,56,68,109,103,77, 24,35,55,64,81,104,113,92, 49,64,78,87,103,121,120,101, 72,92,95,98,112,100,103,99 };
+static const uint8_t kStdChrQ[64] = {
+  17,18,24,47,99,99,99,99, 18,21,26,66,99,99,99,99, 24,26,56,99,99,99,99,99, 47,66,99,99,99,99,99,99,
+  99,99,99,99,99,99,99,99, 99,99,99,99,99,99,99,99, 99,99,99,99,99,99,99,99, 99,99,99,99,99,99,99,99 };
+
+static const uint8_t kDcLumBits[16] = {0,1,5,1,1,1,1,1,1,0,0,0,0,0,0,0};
+static const uint8_t kDcChrBits[16] = {0,3,1,1,1,1,1,1,1,1,1,0,0,0,0,0};
+static const uint8_t kDcVals[12]    = {0,1,2,3,4,5,6,7,8,9,10,11};
+static const uint8_t kAcLumBits[16] = {0,2,1,3,3,2,4,3,5,5,4,4,0,0,1,0x7d};
+static const uint8_t kAcLumVals[162] = {
+  0x01,0x02,0x03,0x00,0x04,0x11,0x05,0x12,0x21,0x31,0x41,0x06,0x13,0x51,0x61,0x07,0x22,0x71,0x14,0x32,0x81,0x91,0xa1,0x08,
+  0x23,0x42,0xb1,0xc1,0x15,0x52,0xd1,0xf0,0x24,0x33,0x62,0x72,0x82,0x09,0x0a,0x16,0x17,0x18,0x19,0x1a,0x25,0x26,0x27,0x28,
+  0x29,0x2a,0x34,0x35,0x36,0x37,0x38,0x39,0x3a,0x43,0x44,0x45,0x46,0x47,0x48,0x49,0x4a,0x53,0x54,0x55,0x56,0x57,0x58,0x59,
+  0x5a,0x63,0x64,0x65,0x66,0x67,0x68,0x69,0x6a,0x73,0x74,0x75,0x76,0x77,0x78,0x79,0x7a,0x83,0x84,0x85,0x86,0x87,0x88,0x89,
+  0x8a,0x92,0x93,0x94,0x95,0x96,0x97,0x98,0x99,0x9a,0xa2,0xa3,0xa4,0xa5,0xa6,0xa7,0xa8,0xa9,0xaa,0xb2,0xb3,0xb4,0xb5,0xb6,
+  0xb7,0xb8,0xb9,0xba,0xc2,0xc3,0xc4,0xc5,0xc6,0xc7,0xc8,0xc9,0xca,0xd2,0xd3,0xd4,0xd5,0xd6,0xd7,0xd8,0xd9,0xda,0xe1,0xe2,
+  0xe3,0xe4,0xe5,0xe6,0xe7,0xe8,0xe9,0xea,0xf1,0xf2,0xf3,0xf4,0xf5,0xf6,0xf7,0xf8,0xf9,0xfa };
+static const uint8_t kAcChrBits[16] = {0,2,1,2,4,4,3,4,7,5,4,4,0,1,2,0x77};
+static const uint8_t kAcChrVals[162] = {
+  0x00,0x01,0x02,0x03,0x11,0x04,0x05,0x21,0x31,0x06,0x12,0x41,0x51,0x07,0x61,0x71,0x13,0x22,0x32,0x81,0x08,0x14,0x42,0x91,
+  0xa1,0xb1,0xc1,0x09,0x23,0x33,0x52,0xf0,0x15,0x62,0x72,0xd1,0x0a,0x16,0x24,0x34,0xe1,0x25,0xf1,0x17,0x18,0x19,0x1a,0x26,
+  0x27,0x28,0x29,0x2a,0x35,0x36,0x37,0x38,0x39,0x3a,0x43,0x44,0x45,0x46,0x47,0x48,0x49,0x4a,0x53,0x54,0x55,0x56,0x57,0x58,
+  0x59,0x5a,0x63,0x64,0x65,0x66,0x67,0x68,0x69,0x6a,0x73,0x74,0x75,0x76,0x77,0x78,0x79,0x7a,0x82,0x83,0x84,0x85,0x86,0x87,
+  0x88,0x89,0x8a,0x92,0x93,0x94,0x95,0x96,0x97,0x98,0x99,0x9a,0xa2,0xa3,0xa4,0xa5,0xa6,0xa7,0xa8,0xa9,0xaa,0xb2,0xb3,0xb4,
+  0xb5,0xb6,0xb7,0xb8,0xb9,0xba,0xc2,0xc3,0xc4,0xc5,0xc6,0xc7,0xc8,0xc9,0xca,0xd2,0xd3,0xd4,0xd5,0xd6,0xd7,0xd8,0xd9,0xda,
+  0xe2,0xe3,0xe4,0xe5,0xe6,0xe7,0xe8,0xe9,0xea,0xf2,0xf3,0xf4,0xf5,0xf6,0xf7,0xf8,0xf9,0xfa };
+
+struct Huff { uint16_t code[256]; uint8_t size[256]; };
+
+inline void buildHuff(Huff& h, const uint8_t* bits, const uint8_t* vals){
+  memset(&h, 0, sizeof(h));
+  uint16_t code = 0; int k = 0;
+  for (int l = 1; l <= 16; l++){
+    for (int i = 0; i < bits[l-1]; i++){ h.code[vals[k]] = code++; h.size[vals[k]] = (uint8_t)l; k++; }
+    code <<= 1;
+  }
+}
+
+class BitWriter {
+public:
+  explicit BitWriter(std::vector<uint8_t>& o) : out_(o) {}
+  void put(uint32_t bits, int n){
+    acc_ = (acc_ << n) | (bits & ((1u << n) - 1)); cnt_ += n;
+    while (cnt_ >= 8){
+      uint8_t b = (uint8_t)(acc_ >> (cnt_ - 8)); cnt_ -= 8;
+      out_.push_back(b); if (b == 0xFF) out_.push_back(0x00);
+    }
+  }
+  void flush(){ if (cnt_ > 0) put(0x7F, 8 - cnt_); }
+private:
+  std::vector<uint8_t>& out_;
+  uint32_t acc_ = 0;
+  int      cnt_ = 0;
+};
+
+class Encoder {
+public:
+  // quality: libjpeg scale 1..100
+  explicit Encoder(int quality){
+    int q = quality < 1 ? 1 : quality > 100 ? 100 : quality;
+    int scale = q < 50 ? 5000 / q : 200 - 2 * q;
+    for (int i = 0; i < 64; i++){
+      int l = (kStdLumQ[i] * scale + 50) / 100, c = (kStdChrQ[i] * scale + 50) / 100;
+      qY_[i] = (uint8_t)(l < 1 ? 1 : l > 255 ? 255 : l);
+      qC_[i] = (uint8_t)(c < 1 ? 1 : c > 255 ? 255 : c);
+    }
+    buildHuff(dcY_, kDcLumBits, kDcVals);  buildHuff(acY_, kAcLumBits, kAcLumVals);
+    buildHuff(dcC_, kDcChrBits, kDcVals);  buildHuff(acC_, kAcChrBits, kAcChrVals);
+    for (int u = 0; u < 8; u++) for (int x = 0; x < 8; x++)
+      cos_[u][x] = (float)cos((2 * x + 1) * u * M_PI / 16.0) * (u == 0 ? (float)M_SQRT1_2 : 1.0f) * 0.5f;
+  }
+
+  // rgb: w*h*3 bytes. w must be a multiple of 16 and h of 8 (true for all OV2640 sizes).
+  std::vector<uint8_t> encode(const uint8_t* rgb, int w, int h){
+    std::vector<uint8_t> o; o.reserve((size_t)w * h / 4);
+    auto u8  = [&](int v){ o.push_back((uint8_t)v); };
+    auto u16 = [&](int v){ u8(v >> 8); u8(v & 0xFF); };
+    u16(0xFFD8);
+    u16(0xFFDB); u16(2 + 65 * 2);
+    u8(0); for (int i = 0; i < 64; i++) u8(qY_[kZigzag[i]]);
+    u8(1); for (int i = 0; i < 64; i++) u8(qC_[kZigzag[i]]);
+    u16(0xFFC0); u16(17); u8(8); u16(h); u16(w); u8(3);
+    u8(1); u8(0x21); u8(0);  u8(2); u8(0x11); u8(1);  u8(3); u8(0x11); u8(1);
+    auto dht = [&](int cls_id, const uint8_t* bits, const uint8_t* vals){
+      int n = 0; for (int i = 0; i < 16; i++) n += bits[i];
+      u16(0xFFC4); u16(2 + 1 + 16 + n); u8(cls_id);
+      for (int i = 0; i < 16; i++) u8(bits[i]);
+      for (int i = 0; i < n; i++) u8(vals[i]);
+    };
+    dht(0x00, kDcLumBits, kDcVals); dht(0x10, kAcLumBits, kAcLumVals);
+    dht(0x01, kDcChrBits, kDcVals); dht(0x11, kAcChrBits, kAcChrVals);
+    u16(0xFFDA); u16(12); u8(3); u8(1); u8(0x00); u8(2); u8(0x11); u8(3); u8(0x11); u8(0); u8(63); u8(0);
+
+    BitWriter bw(o);
+    int pY = 0, pCb = 0, pCr = 0;
+    float Y[2][64], Cb[64], Cr[64];
+    for (int my = 0; my < h; my += 8){
+      for (int mx = 0; mx < w; mx += 16){
+        for (int y = 0; y < 8; y++){
+          for (int x = 0; x < 16; x++){
+            const uint8_t* p = rgb + ((size_t)(my + y) * w + mx + x) * 3;
+            Y[x >> 3][y * 8 + (x & 7)] = 0.299f * p[0] + 0.587f * p[1] + 0.114f * p[2] - 128.0f;
+          }
+          for (int x = 0; x < 8; x++){
+            const uint8_t* a = rgb + ((size_t)(my + y) * w + mx + 2 * x) * 3;
+            const uint8_t* b = a + 3;
+            float r = (a[0] + b[0]) * 0.5f, g = (a[1] + b[1]) * 0.5f, bl = (a[2] + b[2]) * 0.5f;
+            Cb[y * 8 + x] = -0.168736f * r - 0.331264f * g + 0.5f * bl;
+            Cr[y * 8 + x] =  0.5f * r - 0.418688f * g - 0.081312f * bl;
+          }
+        }
+        block(bw, Y[0], qY_, dcY_, acY_, pY);
+        block(bw, Y[1], qY_, dcY_, acY_, pY);
+        block(bw, Cb,   qC_, dcC_, acC_, pCb);
+        block(bw, Cr,   qC_, dcC_, acC_, pCr);
+      }
+    }
+    bw.flush();
+    u16(0xFFD9);
+    return o;
+  }
+
+private:
+  static int category(int v){ int a = v < 0 ? -v : v, n = 0; while (a){ n++; a >>= 1; } return n; }
+  static uint32_t magnitude(int v, int n){ return v < 0 ? (uint32_t)(v + (1 << n) - 1) : (uint32_t)v; }
+
+  void block(BitWriter& bw, const float* in, const uint8_t* q, const Huff& dc, const Huff& ac, int& pred){
+    float tmp[64]; int coef[64];
+    for (int y = 0; y < 8; y++) for (int u = 0; u < 8; u++){
+      float s = 0; for (int x = 0; x < 8; x++) s += in[y * 8 + x] * cos_[u][x];
+      tmp[y * 8 + u] = s;
+    }
+    for (int u = 0; u < 8; u++) for (int v = 0; v < 8; v++){
+      float s = 0; for (int y = 0; y < 8; y++) s += tmp[y * 8 + u] * cos_[v][y];
+      coef[v * 8 + u] = (int)lroundf(s / q[v * 8 + u]);
+    }
+    int diff = coef[0] - pred; pred = coef[0];
+    int n = category(diff);
+    bw.put(dc.code[n], dc.size[n]); if (n) bw.put(magnitude(diff, n), n);
+    int run = 0;
+    for (int k = 1; k < 64; k++){
+      int v = coef[kZigzag[k]];
+      if (!v){ run++; continue; }
+      while (run > 15){ bw.put(ac.code[0xF0], ac.size[0xF0]); run -= 16; }
+      int c = category(v), sym = (run << 4) | c;
+      bw.put(ac.code[sym], ac.size[sym]); bw.put(magnitude(v, c), c);
+      run = 0;
+    }
+    if (run) bw.put(ac.code[0x00], ac.size[0x00]);
+  }
+
+  uint8_t qY_[64], qC_[64];
+  Huff    dcY_, acY_, dcC_, acC_;
+  float   cos_[8][8];
+};
+
+} // namespace mock_jpeg
@@ -0,0 +1,144 @@
+#pragma once
+#include <Arduino.h>
+#include "esp_heap_caps.h"
+
+// Pre-event recorder: the last N seconds of JPEG frames in one capped PSRAM
+// arena. Frames are laid out back to back and wrap at the end; appending
+// evicts the oldest frames that overlap the new one. One producer (capture).
+// The timelapse store is a second instance holding full-resolution shots.
+//
+// Readers pin() a start frame; nothing at or after the pin is evicted, so a
+// reader can send straight out of the arena without copying. While pinned, a
+// frame that would need to evict a pinned one is dropped instead.
+
+#ifndef CLIP_MAX_FRAMES
+#define CLIP_MAX_FRAMES 1024     // index entries (e.g. 30 s at 30 fps)
+#endif
+
+struct ClipFrame {
+  uint32_t off;
+  uint32_t len;
+  int64_t  ts_us;                // capture time
+};
+
+class ClipRing {
+public:
+  // (Re)allocate the arena; drops all frames. Producer context only, unpinned.
+  bool begin(size_t cap){
+    release_();
+    if (!cap) return true;
+    idx_ = (ClipFrame*)heap_caps_malloc(sizeof(ClipFrame) * CLIP_MAX_FRAMES, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    buf_ = (uint8_t*)heap_caps_malloc(cap, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    if (!idx_ || !buf_){ release_(); return false; }
+    cap_ = cap;
+    return true;
+  }
+
+  // Producer: copy one frame in. False = disabled, too big, or blocked by a pin.
+  bool append(const uint8_t* p, size_t len, int64_t ts_us){
+    if (!buf_ || len > cap_) return false;
+    portENTER_CRITICAL(&mux_);
+    bool     wrap = wpos_ + len > cap_;
+    uint32_t off  = wrap ? 0 : wpos_;
+    while (tail_ != head_){
+      const ClipFrame& e = idx_[tail_ % CLIP_MAX_FRAMES];
+      bool hit = (wrap && e.off >= wpos_) || (e.off < off + len && e.off + e.len > off);
+      if (!hit && head_ - tail_ < CLIP_MAX_FRAMES) break;
+      if (pinned_ && tail_ >= pin_){ dropped_++; portEXIT_CRITICAL(&mux_); return false; }
+      bytes_ -= e.len;
+      tail_++;
+    }
+    portEXIT_CRITICAL(&mux_);
+
+    memcpy(buf_ + off, p, len);            // region holds no live frame now
+
+    portENTER_CRITICAL(&mux_);
+    idx_[head_ % CLIP_MAX_FRAMES] = { off, (uint32_t)len, ts_us };
+    head_++;
+    wpos_   = off + len;
+    bytes_ += len;
+    portEXIT_CRITICAL(&mux_);
+    return true;
+  }
+
+  // Reader: pin the first frame captured at/after from_us. Returns its number.
+  // Only one pin at a time; false if already pinned or disabled.
+  bool pin(int64_t from_us, uint32_t* first){
+    portENTER_CRITICAL(&mux_);
+    bool ok = buf_ && !pinned_;
+    if (ok){
+      uint32_t i = tail_;
+      while (i != head_ && idx_[i % CLIP_MAX_FRAMES].ts_us < from_us) i++;
+      pin_ = i; pinned_ = true; *first = i;
+    }
+    portEXIT_CRITICAL(&mux_);
+    return ok;
+  }
+  // Reader: frame n, if it exists yet. Data stays valid while n >= the pin.
+  bool get(uint32_t n, const uint8_t** data, ClipFrame* out){
+    portENTER_CRITICAL(&mux_);
+    bool ok = pinned_ && n >= tail_ && n != head_ && (int32_t)(head_ - n) > 0;
+    if (ok){ *out = idx_[n % CLIP_MAX_FRAMES]; *data = buf_ + out->off; }
+    portEXIT_CRITICAL(&mux_);
+    return ok;
+  }
+  // Reader: frames before n may be evicted again.
+  void advance(uint32_t n){
+    portENTER_CRITICAL(&mux_);
+    if (pinned_ && n > pin_) pin_ = n;
+    portEXIT_CRITICAL(&mux_);
+  }
+  // Frame numbers [*first, *end) currently held; no pin needed.
+  void range(uint32_t* first, uint32_t* end){
+    portENTER_CRITICAL(&mux_);
+    *first = tail_; *end = head_;
+    portEXIT_CRITICAL(&mux_);
+  }
+  // Index entry of frame n without pinning it (listing only: the data may be
+  // evicted right after).
+  bool peek(uint32_t n, ClipFrame* out){
+    portENTER_CRITICAL(&mux_);
+    bool ok = buf_ && n >= tail_ && (int32_t)(head_ - n) > 0;
+    if (ok) *out = idx_[n % CLIP_MAX_FRAMES];
+    portEXIT_CRITICAL(&mux_);
+    return ok;
+  }
+  void unpin(){
+    portENTER_CRITICAL(&mux_);
+    pinned_ = false;
+    portEXIT_CRITICAL(&mux_);
+  }
+
+  struct Stats { uint32_t frames; uint32_t bytes; uint32_t cap; uint32_t dropped; int64_t oldest_us, newest_us; bool pinned; };
+  Stats stats(){
+    portENTER_CRITICAL(&mux_);
+    Stats s = { head_ - tail_, bytes_, (uint32_t)cap_, dropped_, 0, 0, pinned_ };
+    if (head_ != tail_){
+      s.oldest_us = idx_[tail_ % CLIP_MAX_FRAMES].ts_us;
+      s.newest_us = idx_[(head_ - 1) % CLIP_MAX_FRAMES].ts_us;
+    }
+    portEXIT_CRITICAL(&mux_);
+    return s;
+  }
+  bool pinned(){ return pinned_; }
+
+private:
+  void release_(){
+    if (buf_) heap_caps_free(buf_);
+    if (idx_) heap_caps_free(idx_);
+    buf_ = nullptr; idx_ = nullptr; cap_ = 0;
+    head_ = tail_ = 0; wpos_ = 0; bytes_ = 0;
+  }
+
+  uint8_t*      buf_     = nullptr;
+  ClipFrame*    idx_     = nullptr;
+  size_t        cap_     = 0;
+  uint32_t      head_    = 0;          // frames appended (free-running)
+  uint32_t      tail_    = 0;          // oldest live frame
+  uint32_t      wpos_    = 0;          // next write offset
+  uint32_t      bytes_   = 0;
+  uint32_t      pin_     = 0;
+  uint32_t      dropped_ = 0;          // frames refused because of a pin
+  volatile bool pinned_  = false;
+  portMUX_TYPE  mux_     = portMUX_INITIALIZER_UNLOCKED;
+};
@@ -0,0 +1,105 @@
+#pragma once
+#include <Arduino.h>
+#include "esp_heap_caps.h"
+
+// Shared, reference-counted JPEG frame ring (PSRAM).
+// One capture producer fills slots and publishes them as "latest"; any number
+// of readers acquire the newest slot, send it and release it. A slot is only
+// rewritten once nobody holds a reference, so N viewers = 1 capture + N sends.
+
+#ifndef FRAME_RING_SLOTS
+#define FRAME_RING_SLOTS 8       // queued + in-flight frames across viewers, + latest + writing
+#endif
+
+struct FrameSlot {
+  uint8_t*  buf;
+  size_t    cap;
+  size_t    len;
+  uint32_t  seq;                 // 0 = never published
+  int64_t   ts_us;               // capture time (esp_timer_get_time)
+  uint16_t  width;
+  uint16_t  height;
+  int16_t   refs;                // readers + producer while writing
+};
+
+class FrameRing {
+public:
+  // Producer: claim a free slot with room for `need` bytes (nullptr = all busy / OOM).
+  FrameSlot* beginWrite(size_t need){
+    FrameSlot* s = nullptr;
+    portENTER_CRITICAL(&mux_);
+    for (int i=0;i<FRAME_RING_SLOTS;i++){
+      FrameSlot* c = &slots_[i];
+      if (c == latest_ || c->refs != 0) continue;
+      if (!s || c->cap >= need) s = c;   // prefer a slot that is already big enough
+      if (c->cap >= need) break;
+    }
+    if (s) s->refs = 1;
+    portEXIT_CRITICAL(&mux_);
+    if (!s) return nullptr;
+
+    if (s->cap < need){
+      size_t cap = need + need/4;        // headroom: JPEG size varies per frame
+      uint8_t* nb = (uint8_t*)heap_caps_malloc(cap, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+      if (!nb) nb = (uint8_t*)heap_caps_malloc(cap, MALLOC_CAP_8BIT);
+      if (!nb){ abortWrite(s); return nullptr; }
+      if (s->buf) heap_caps_free(s->buf);
+      s->buf = nb; s->cap = cap;
+    }
+    return s;
+  }
+
+  void abortWrite(FrameSlot* s){
+    portENTER_CRITICAL(&mux_);
+    s->refs = 0;
+    portEXIT_CRITICAL(&mux_);
+  }
+
+  // Producer: make a filled slot the newest frame. Returns its sequence number.
+  uint32_t publish(FrameSlot* s, size_t len, uint16_t w, uint16_t h, int64_t ts_us){
+    portENTER_CRITICAL(&mux_);
+    s->len = len; s->width = w; s->height = h; s->ts_us = ts_us;
+    s->seq = ++seq_;
+    s->refs = 0;
+    latest_ = s;
+    uint32_t seq = s->seq;
+    portEXIT_CRITICAL(&mux_);
+    return seq;
+  }
+
+  // Reader: newest frame if its seq is > newerThan (nullptr otherwise). Must be released.
+  FrameSlot* acquireLatest(uint32_t newerThan = 0){
+    FrameSlot* s = nullptr;
+    portENTER_CRITICAL(&mux_);
+    if (latest_ && latest_->seq > newerThan){ s = latest_; s->refs++; }
+    portEXIT_CRITICAL(&mux_);
+    return s;
+  }
+
+  // Extra reference on a slot the caller already holds or just published.
+  void addRef(FrameSlot* s){
+    portENTER_CRITICAL(&mux_);
+    s->refs++;
+    portEXIT_CRITICAL(&mux_);
+  }
+
+  void release(FrameSlot* s){
+    if (!s) return;
+    portENTER_CRITICAL(&mux_);
+    if (s->refs > 0) s->refs--;
+    portEXIT_CRITICAL(&mux_);
+  }
+
+  uint32_t latestSeq(){
+    portENTER_CRITICAL(&mux_);
+    uint32_t v = latest_ ? latest_->seq : 0;
+    portEXIT_CRITICAL(&mux_);
+    return v;
+  }
+
+private:
+  FrameSlot    slots_[FRAME_RING_SLOTS] = {};
+  FrameSlot*   latest_ = nullptr;
+  uint32_t     seq_    = 0;
+  portMUX_TYPE mux_    = portMUX_INITIALIZER_UNLOCKED;
+};
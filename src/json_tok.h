@@ -0,0 +1,143 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <limits.h>
+
+// Single-pass, allocation-free reader for a flat JSON object of scalars:
+//   {"q": 12, "fs": "VGA", "awb": true, "bri": null}
+// Members are handed to a callback in order, as they are read; nothing is
+// copied. Nested objects/arrays are rejected. The input need not be
+// NUL-terminated and is never read past `n`.
+//
+// Errors carry the byte offset of the offending character (or of the value a
+// callback rejected) and a static message.
+
+struct JsonVal {
+  enum Type : uint8_t { NUM, STR, BOOL, NUL };
+  Type        type;
+  bool        is_int;            // NUM: no fraction/exponent and fits in a long
+  const char* s;                 // STR: raw bytes between the quotes (escapes not decoded); NUM: token
+  size_t      len;
+  long        i;                 // NUM when is_int, BOOL as 0/1
+};
+
+struct JsonErr {
+  size_t      pos;
+  const char* msg;
+  const char* key;               // member being read when it failed (raw, may be nullptr)
+  size_t      klen;
+};
+
+namespace json_tok_detail {
+
+inline bool ws(char c){ return c == ' ' || c == '\t' || c == '\n' || c == '\r'; }
+inline bool hex(char c){ return (c >= '0' && c <= '9') || ((c | 0x20) >= 'a' && (c | 0x20) <= 'f'); }
+
+// p[i] == '"'. On success i is past the closing quote, [*s, *s + *len) the contents.
+inline const char* str(const char* p, size_t n, size_t& i, const char** s, size_t* len){
+  size_t b = ++i;
+  while (i < n){
+    unsigned char c = (unsigned char)p[i];
+    if (c == '"'){ *s = p + b; *len = i - b; i++; return nullptr; }
+    if (c < 0x20) return "control character in string";
+    if (c == '\\'){
+      if (++i >= n) break;
+      char e = p[i];
+      if (e == 'u'){
+        for (int k = 0; k < 4; k++) if (++i >= n || !hex(p[i])) return "bad unicode escape";
+      } else if (e != '"' && e != '\\' && e != '/' && e != 'b' && e != 'f' && e != 'n' && e != 'r' && e != 't')
+        return "bad escape";
+    }
+    i++;
+  }
+  return "unterminated string";
+}
+
+inline const char* num(const char* p, size_t n, size_t& i, JsonVal* v){
+  size_t b = i;
+  bool neg = p[i] == '-', ovf = false;
+  if (neg) i++;
+  if (i >= n || p[i] < '0' || p[i] > '9') return "bad number";
+  unsigned long m = 0, lim = neg ? (unsigned long)LONG_MAX + 1 : (unsigned long)LONG_MAX;
+  if (p[i] == '0') i++;
+  else while (i < n && p[i] >= '0' && p[i] <= '9'){
+    unsigned d = (unsigned)(p[i++] - '0');
+    if (m > (lim - d) / 10) ovf = true; else m = m * 10 + d;
+  }
+  bool frac = false;
+  if (i < n && p[i] == '.'){
+    frac = true;
+    if (++i >= n || p[i] < '0' || p[i] > '9') return "bad number";
+    while (i < n && p[i] >= '0' && p[i] <= '9') i++;
+  }
+  if (i < n && (p[i] | 0x20) == 'e'){
+    frac = true;
+    if (++i < n && (p[i] == '+' || p[i] == '-')) i++;
+    if (i >= n || p[i] < '0' || p[i] > '9') return "bad number";
+    while (i < n && p[i] >= '0' && p[i] <= '9') i++;
+  }
+  v->type = JsonVal::NUM; v->s = p + b; v->len = i - b;
+  v->is_int = !frac && !ovf;
+  v->i = v->is_int ? (neg ? (long)(0 - m) : (long)m) : 0;
+  return nullptr;
+}
+
+inline bool lit(const char* p, size_t n, size_t& i, const char* w, size_t wl){
+  for (size_t k = 0; k < wl; k++) if (i + k >= n || p[i + k] != w[k]) return false;
+  i += wl;
+  return true;
+}
+
+} // namespace json_tok_detail
+
+// fn(const char* key, size_t klen, const JsonVal& v) -> nullptr to accept, or
+// an error message to stop (reported at the value's offset).
+template <typename F>
+bool json_object_each(const char* p, size_t n, F&& fn, JsonErr* err){
+  using namespace json_tok_detail;
+  size_t i = 0;
+  const char* key = nullptr; size_t klen = 0;
+  auto fail = [&](size_t at, const char* msg){
+    if (err){ err->pos = at; err->msg = msg; err->key = key; err->klen = klen; }
+    return false;
+  };
+  auto skip = [&]{ while (i < n && ws(p[i])) i++; };
+
+  skip();
+  if (i >= n || p[i] != '{') return fail(i, "expected '{'");
+  i++; skip();
+  if (i < n && p[i] == '}'){ i++; skip(); return i == n || fail(i, "trailing characters"); }
+  for (;;){
+    key = nullptr; klen = 0;
+    skip();
+    if (i >= n || p[i] != '"') return fail(i, "expected member name");
+    if (const char* e = str(p, n, i, &key, &klen)) return fail(i, e);
+    skip();
+    if (i >= n || p[i] != ':') return fail(i, "expected ':'");
+    i++; skip();
+    if (i >= n) return fail(i, "expected value");
+
+    JsonVal v = {};
+    size_t  at = i;
+    char    c  = p[i];
+    if (c == '"'){
+      v.type = JsonVal::STR;
+      if (const char* e = str(p, n, i, &v.s, &v.len)) return fail(i, e);
+    } else if (c == '-' || (c >= '0' && c <= '9')){
+      if (const char* e = num(p, n, i, &v)) return fail(i, e);
+    } else if (lit(p, n, i, "true", 4))  { v.type = JsonVal::BOOL; v.i = 1; }
+    else if (lit(p, n, i, "false", 5))   { v.type = JsonVal::BOOL; v.i = 0; }
+    else if (lit(p, n, i, "null", 4))    { v.type = JsonVal::NUL; }
+    else if (c == '{' || c == '[')       return fail(i, "nested values not supported");
+    else                                 return fail(i, "expected value");
+    if (const char* e = fn(key, klen, v)) return fail(at, e);
+
+    skip();
+    if (i < n && p[i] == ','){ i++; continue; }
+    if (i < n && p[i] == '}'){ i++; break; }
+    return fail(i, "expected ',' or '}'");
+  }
+  key = nullptr; klen = 0;
+  skip();
+  return i == n || fail(i, "trailing characters");
+}
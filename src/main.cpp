@@ -1,8 +1,10 @@
 /**
  * T-Camera Plus S3 v1.0–v1.1 (ESP32-S3) + OV2640 + ST7789V (240x240, 1.3")
  * Prooven Version
- * - Routes: / (UI from www_index.h), /settings (form), /api/settings (GET/POST),
- *           /jpg, /stream, /health, /reinit
+ * - Routes: / (UI from www_index.h, served gzipped + ETag), /settings (form), /api/settings (GET/POST),
+ *           /jpg, /stream, /health, /reinit, /api/streams, /metrics, /trace, /clip,
+ *           /record.avi, /record/stop, /boot, /ws/stream, /motion, /calibrate
+ * - RTSP (RTP/JPEG over UDP or TCP-interleaved) on port 554
  * - Wi-Fi SoftAP + DNS wildcard (http://nozzlecam/) + mDNS (http://nozzcam.local/)
  * - TFT splash: shows SSID + IP centered (Adafruit_ST7789)
  *
@@ -25,9 +27,21 @@
 #include <ESPmDNS.h>
 #include <DNSServer.h>
 #include <Preferences.h>
+#include <new>
+#include "lwip/sockets.h"
 
-// Web UI (home) uit losse header
-#include "www_index.h"  // extern const char INDEX_HTML[] PROGMEM;
+// Web UI: src/www_index.h (+ web/*) gzipped at build time by tools/gen_web_assets.py
+#include "www_assets.h" // WEB_ASSETS[]: path, mime, gzip body, ETag, Cache-Control
+#include "frame_ring.h" // shared refcounted JPEG ring (PSRAM)
+#include "spsc_queue.h" // lock-free capture -> sender handoff
+#include "span_trace.h" // hot-path spans for /trace
+#include "clip_ring.h"  // pre-event JPEG history for /clip (PSRAM)
+#include "json_tok.h"   // allocation-free JSON reader for /api/settings
+#include "ws_frame.h"   // RFC 6455 framing for /ws/stream
+#include "motion_diff.h" // thumbnail difference kernels (motion metric)
+#include "rtp_jpeg.h"    // RFC 2435 packetizer for RTSP
+#include "tmpl.h"        // streaming PROGMEM templates: /settings, /api/settings
+#include <JPEGDEC.h>     // 1/8-scale decodes: motion metric, TFT preview
 
 #ifdef USE_ST7789
   #include <Adafruit_GFX.h>
@@ -45,6 +59,32 @@
 #define LOGD(tag, fmt, ...) do{ if (LOG_LEVEL >= 3) Serial.printf("[D] %s: " fmt "\n", tag, ##__VA_ARGS__);}while(0)
 static const char* TAG = "TCAM";
 
+// -------------------- Span tracer --------------------
+// Spans (fb_get, frame2jpg, stream writes, sensor apply, reinit) go to a PSRAM
+// ring and are served by /trace as Chrome trace_event JSON (chrome://tracing,
+// ui.perfetto.dev). Compiled out entirely at LOG_LEVEL 0 unless TRACE_ENABLE=1.
+#ifndef TRACE_ENABLE
+#define TRACE_ENABLE (LOG_LEVEL >= 1)
+#endif
+#define TRACE_SPANS 4096                             // 24 B each in PSRAM
+#if TRACE_ENABLE
+static SpanTrace tracer;
+struct TraceScope {
+  const char* name; int64_t t0;
+  explicit TraceScope(const char* n) : name(n), t0(esp_timer_get_time()) {}
+  ~TraceScope(){ tracer.record(name, t0, (uint32_t)(esp_timer_get_time() - t0), 0); }
+};
+#define TRACE_SCOPE(name)              TraceScope _trace_scope(name)
+#define TRACE_BEGIN(t)                 int64_t t = esp_timer_get_time()
+#define TRACE_END(name, t, arg)        tracer.record(name, t, (uint32_t)(esp_timer_get_time() - (t)), (uint32_t)(arg))
+#define TRACE_SPAN(name, t0, t1, arg)  tracer.record(name, t0, (uint32_t)((t1) - (t0)), (uint32_t)(arg))
+#else
+#define TRACE_SCOPE(name)              do{}while(0)
+#define TRACE_BEGIN(t)                 do{}while(0)
+#define TRACE_END(name, t, arg)        do{}while(0)
+#define TRACE_SPAN(name, t0, t1, arg)  do{}while(0)
+#endif
+
 // -------------------- Wi-Fi SoftAP --------------------
 static const char* AP_SSID     = "NozzleCAM";
 static const char* AP_PASSWORD = "";
@@ -92,6 +132,22 @@ struct CamSettings {
   bool     aec;           // auto exposure
   bool     agc;           // auto gain
   uint16_t rot;           // rotation: 0 or 180 (OV2640 supports 180° via vflip+hmirror)
+  bool     abr;           // adaptive bitrate: trade q/fs for fps when viewers fall behind
+  uint8_t  abr_fps;       // 1..30 target fps per viewer
+  uint8_t  abr_qmax;      // 10..63 worst JPEG quality ABR may use
+  uint8_t  abr_fsmin;     // smallest framesize ABR may use
+  bool     tft_pv;        // live preview on the ST7789 instead of the splash
+  uint8_t  tft_fps;       // 1..15 preview rate cap (the CPU budget may lower it)
+  uint16_t clip_kb;       // 0..6144 pre-event buffer in PSRAM (0 = off)
+  uint8_t  clip_fps;      // 1..30 frames per second kept in the pre-event buffer
+  // v2
+  bool     md;            // motion metric on
+  uint16_t md_thr;        // 1..1000 changed pixels (per mille) that count as motion
+  uint16_t md_still_s;    // 1..600 seconds below md_thr before a "still" event
+  uint16_t md_jump;       // 1..1000 per mille changed at once that is a "scene" event
+  // v3
+  uint16_t tl_s;          // 0..3600 timelapse interval in seconds (0 = /trigger only)
+  uint16_t tl_kb;         // 0..4096 timelapse store in PSRAM (0 = off)
 };
 static Preferences prefs;
 static CamSettings S;
@@ -107,24 +163,56 @@ static void setDefaults(CamSettings &cs){
   cs.aec        = true;
   cs.agc        = true;
   cs.rot        = 0;      // 0° standaard
+  cs.abr        = false;
+  cs.abr_fps    = 15;
+  cs.abr_qmax   = 30;
+  cs.abr_fsmin  = (uint8_t)FRAMESIZE_QVGA;
+  cs.tft_pv     = false;
+  cs.tft_fps    = 4;
+  cs.clip_kb    = 2048;
+  cs.clip_fps   = 10;
+  cs.md         = true;
+  cs.md_thr     = 20;
+  cs.md_still_s = 10;
+  cs.md_jump    = 300;
+  cs.tl_s       = 0;
+  cs.tl_kb      = 2048;
+}
+// Stored as one blob under "cam"/"cfg": SettingsHdr + the raw CamSettings.
+// CamSettings is append-only: new fields go at the end and bump
+// SETTINGS_VERSION. An older (shorter) blob is copied over the defaults, so
+// new fields start at their default, then settings_migrate() fixes anything
+// whose meaning changed. Version 0 = the old one-NVS-key-per-field layout.
+#define SETTINGS_VERSION 3
+struct SettingsHdr {
+  uint16_t version;
+  uint16_t len;             // sizeof(CamSettings) when written
+  uint32_t crc;             // CRC-32 of the payload
+};
+static const char* const SETTINGS_V0_KEYS[] = {
+  "q", "fs", "bri", "con", "sat", "ae", "awb", "aec", "agc", "rot",
+  "abr", "abr_f", "abr_q", "abr_s", "pv", "pv_f", "cl_k", "cl_f",
+};
+
+static uint32_t crc32(const uint8_t* p, size_t n){
+  uint32_t c = 0xFFFFFFFF;
+  while (n--){ c ^= *p++; for (int k=0;k<8;k++) c = (c >> 1) ^ (0xEDB88320 & (0 - (c & 1))); }
+  return ~c;
 }
-static void saveSettings(const CamSettings &cs){
+
+static bool saveSettings(const CamSettings &cs){
+  uint8_t blob[sizeof(SettingsHdr) + sizeof(CamSettings)];
+  SettingsHdr h = { SETTINGS_VERSION, (uint16_t)sizeof(CamSettings), crc32((const uint8_t*)&cs, sizeof(cs)) };
+  memcpy(blob, &h, sizeof(h));
+  memcpy(blob + sizeof(h), &cs, sizeof(cs));
   prefs.begin("cam", false);
-  prefs.putUChar("q",   cs.jpeg_q);
-  prefs.putUChar("fs",  cs.fs);
-  prefs.putChar ("bri", cs.brightness);
-  prefs.putChar ("con", cs.contrast);
-  prefs.putChar ("sat", cs.saturation);
-  prefs.putChar ("ae",  cs.ae_level);
-  prefs.putBool ("awb", cs.awb);
-  prefs.putBool ("aec", cs.aec);
-  prefs.putBool ("agc", cs.agc);
-  prefs.putUShort("rot", cs.rot);
+  bool ok = prefs.putBytes("cfg", blob, sizeof(blob)) == sizeof(blob);
   prefs.end();
+  return ok;
 }
-static void loadSettings(CamSettings &cs){
-  prefs.begin("cam", true);
-  if (!prefs.isKey("q")){ prefs.end(); setDefaults(cs); saveSettings(cs); return; }
+
+// Version 0: one key per field (prefs already open).
+static void loadSettingsV0(CamSettings &cs){
   cs.jpeg_q     = prefs.getUChar ("q",   12);
   cs.fs         = prefs.getUChar ("fs",  (uint8_t)FRAMESIZE_SVGA);
   cs.brightness = prefs.getChar  ("bri", 1);
@@ -135,16 +223,236 @@ static void loadSettings(CamSettings &cs){
   cs.aec        = prefs.getBool  ("aec", true);
   cs.agc        = prefs.getBool  ("agc", true);
   cs.rot        = prefs.getUShort("rot", 0);
+  cs.abr        = prefs.getBool  ("abr",   false);
+  cs.abr_fps    = prefs.getUChar ("abr_f", 15);
+  cs.abr_qmax   = prefs.getUChar ("abr_q", 30);
+  cs.abr_fsmin  = prefs.getUChar ("abr_s", (uint8_t)FRAMESIZE_QVGA);
+  cs.tft_pv     = prefs.getBool  ("pv",    false);
+  cs.tft_fps    = prefs.getUChar ("pv_f",  4);
+  cs.clip_kb    = prefs.getUShort("cl_k",  2048);
+  cs.clip_fps   = prefs.getUChar ("cl_f",  10);
+}
+
+// Fix-ups for fields whose meaning changed, applied from `from` upwards.
+// v2 added the motion fields; `md` sits in what was v1's tail padding, so the
+// v1 copy may have overwritten its default. v3 added the timelapse fields.
+static void settings_migrate(CamSettings &cs, uint16_t from){
+  CamSettings d; setDefaults(d);
+  if (from < 2){ cs.md = d.md; cs.md_thr = d.md_thr; cs.md_still_s = d.md_still_s; cs.md_jump = d.md_jump; }
+  if (from < 3){ cs.tl_s = d.tl_s; cs.tl_kb = d.tl_kb; }
+}
+
+static void loadSettings(CamSettings &cs){
+  setDefaults(cs);
+  uint8_t blob[sizeof(SettingsHdr) + sizeof(CamSettings) + 64];   // room for a newer, longer layout
+  prefs.begin("cam", true);
+  size_t n      = prefs.getBytes("cfg", blob, sizeof(blob));
+  bool   legacy = !n && prefs.isKey("q");
+  if (legacy) loadSettingsV0(cs);
   prefs.end();
+
+  if (legacy){
+    LOGI(TAG, "settings: per-key layout -> blob v%u", SETTINGS_VERSION);
+    if (saveSettings(cs)){                       // blob first: a reset in between keeps the old keys
+      prefs.begin("cam", false);
+      for (const char* k : SETTINGS_V0_KEYS) prefs.remove(k);
+      prefs.end();
+    }
+    return;
+  }
+  SettingsHdr h = {};
+  if (n >= sizeof(h)) memcpy(&h, blob, sizeof(h));
+  if (n < sizeof(h) || h.len != n - sizeof(h) || crc32(blob + sizeof(h), h.len) != h.crc){
+    if (n) LOGW(TAG, "settings blob invalid (%u bytes), using defaults", (unsigned)n);
+    saveSettings(cs);
+    return;
+  }
+  memcpy(&cs, blob + sizeof(h), min<size_t>(h.len, sizeof(cs)));
+  if (h.version < SETTINGS_VERSION) settings_migrate(cs, h.version);
+  if (h.version != SETTINGS_VERSION || h.len != sizeof(cs)) saveSettings(cs);
+}
+
+// POST handlers only update S, apply it and call settings_changed(). The
+// writer task waits until edits pause for SETTINGS_COMMIT_IDLE_MS (at most
+// SETTINGS_COMMIT_MAX_MS after the first), then writes the newest snapshot
+// once: a dragged slider costs one flash write, not one per request.
+#define SETTINGS_COMMIT_IDLE_MS 1000
+#define SETTINGS_COMMIT_MAX_MS  5000
+static TaskHandle_t  settingsTask     = nullptr;
+static portMUX_TYPE  settingsMux      = portMUX_INITIALIZER_UNLOCKED;
+static CamSettings   settings_snap;                  // newest S handed to the writer
+static uint32_t      settings_gen     = 0;           // bumped per change
+static uint32_t      settings_saved   = 0;           // generation in flash
+static uint32_t      settings_commits = 0;
+
+static void settings_changed(){
+  portENTER_CRITICAL(&settingsMux);
+  settings_snap = S;
+  settings_gen++;
+  portEXIT_CRITICAL(&settingsMux);
+  if (settingsTask) xTaskNotifyGive(settingsTask);
+  else if (saveSettings(S)) settings_saved = settings_gen;
+}
+
+static void settings_task(void*){
+  for (;;){
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    int64_t first = esp_timer_get_time();
+    while (ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(SETTINGS_COMMIT_IDLE_MS)) &&
+           esp_timer_get_time() - first < SETTINGS_COMMIT_MAX_MS * 1000LL){}
+
+    CamSettings cs; uint32_t gen;
+    portENTER_CRITICAL(&settingsMux);
+    cs = settings_snap; gen = settings_gen;
+    portEXIT_CRITICAL(&settingsMux);
+    if (gen == settings_saved) continue;
+    TRACE_BEGIN(t_nvs);
+    bool ok = saveSettings(cs);
+    TRACE_END("nvs_commit", t_nvs, gen);
+    if (ok){ settings_saved = gen; settings_commits++; }
+    else { LOGW(TAG, "settings commit failed, retrying"); vTaskDelay(pdMS_TO_TICKS(SETTINGS_COMMIT_IDLE_MS)); xTaskNotifyGive(settingsTask); }
+  }
 }
 
 // -------------------- Stream/quality runtime --------------------
 static int         XCLK_HZ      = 24000000;          // OV2640 sweet spot
 static int         FB_COUNT     = 2;                 // use 2 with PSRAM
-static bool        cam_ready    = false;
+#define CAM_FS_MAX FRAMESIZE_UXGA                    // driver buffers sized for this (PSRAM)
+static volatile bool cam_ready = false;
+
+// -------------------- Frame fan-out (one producer, N consumers) --------------------
+static FrameRing         frames;                     // newest JPEGs, refcounted
+static SemaphoreHandle_t camLock      = nullptr;     // fb_get vs. deinit/init
+static TaskHandle_t      captureTask  = nullptr;
+static uint32_t          cap_drops    = 0;           // captures lost: every slot busy
+static volatile uint16_t cap_fps_x10  = 0;           // producer rate, updated every second
+static volatile int64_t  cap_last_us  = 0;           // last fb_get that returned a frame (health monitor)
+static volatile uint32_t cap_stack_free = 0;         // capture task high-water mark after its last camera_reinit()
+#define MAX_STREAM_CLIENTS 4
+#define STREAM_SEND_TIMEOUT_S 5                      // drop a viewer that stops reading
+#define STREAM_QUEUE_DEPTH 2                         // frames queued per viewer (power of 2)
+#define STREAM_MAX_FPS 30                            // upper bound for /stream?fps=
+#define WS_MAX_CREDITS 8                             // frames a /ws/stream client may have outstanding
+#define WS_FRAME_HDR   16                            // binary message prefix: seq, ts_us, w, h (LE)
+#define WS_RX_MAX      256                           // largest client message we accept
+#define WS_STATS_MS    1000                          // stats push period
+#ifdef CONFIG_LWIP_TCP_MSS
+#define STREAM_TCP_MSS CONFIG_LWIP_TCP_MSS
+#else
+#define STREAM_TCP_MSS 1436                          // Arduino-ESP32 sdkconfig default
+#endif
+
+// Pipeline: capture (+ frame2jpg) on APP_CPU, per-viewer senders on PRO_CPU next
+// to the Wi-Fi/lwIP tasks. Frames cross cores through one SPSC mailbox per viewer.
+#define CAPTURE_CORE APP_CPU_NUM
+#define NET_CORE     PRO_CPU_NUM
+
+// One entry per open /stream connection; each is served by its own task.
+struct StreamClient {
+  WiFiClient   client;
+  TaskHandle_t task;                                  // non-null while accepting frames
+  SpscQueue<FrameSlot*, STREAM_QUEUE_DEPTH> q;        // producer: capture, consumer: task
+  uint32_t     last_seq;
+  uint32_t     sent;
+  uint32_t     drops;                                 // published frames never sent (mailbox full / superseded)
+  uint8_t      fps;                                   // 0 = as fast as capture/network allow
+  bool         live;                                  // always send the newest frame
+  bool         ws;                                    // /ws/stream: binary messages, credit flow control
+  uint8_t      credits;                               // ws: frames the client will still accept (task only)
+  uint32_t     skipped;                               // ws: frames superseded while out of credit
+  bool         rtsp;                                  // RTSP session: RTP/JPEG packets, not HTTP
+  bool         rtsp_tcp;                              // rtsp: interleaved on the RTSP connection
+  uint32_t     lost;                                  // rtsp: UDP packets the stack would not take
+  // per-window send stats for the rate controller (guarded by streamsMux)
+  uint32_t     win_frames;
+  uint32_t     win_send_us;                           // sum of per-frame write time
+  uint32_t     win_pending;                           // sum of bytes still unsent at the frame budget
+  uint32_t     win_lat_us;                            // max capture -> fully written
+  // lifetime framing stats (guarded by streamsMux)
+  uint64_t     bytes;
+  uint32_t     writes;                                // sendmsg calls that moved data
+  uint32_t     segs;                                  // MSS segments those calls filled
+  int64_t      t_start;
+  bool         used;
+};
+static StreamClient streams[MAX_STREAM_CLIENTS];
+static portMUX_TYPE streamsMux = portMUX_INITIALIZER_UNLOCKED;
+
+#define JPG_WAITERS 2                                // /jpg requests waiting for a fresh frame off loop()
+static TaskHandle_t jpgWaiters[JPG_WAITERS];         // woken on every publish (guarded by streamsMux)
+
+// Pre-event history: capture copies every (1/clip_fps)-th frame into a capped
+// PSRAM arena; /clip pins it and sends straight from there.
+static ClipRing clips;
+static volatile bool clip_busy = false;             // one /clip download at a time
+#define CLIP_MAX_KB    6144
+#define CLIP_MAX_POST_S 60
+
+// Timelapse store: full-resolution shots taken between stream frames, kept
+// until downloaded or evicted by newer ones (same arena as the clip buffer).
+static ClipRing tl_store;
+static volatile bool tl_busy = false;               // one /timelapse.mjpeg download at a time
+#define TL_MAX_KB      4096
+
+// -------------------- Metrics --------------------
+// Fixed-bucket latency histogram (Prometheus "le" semantics, microseconds).
+// Single writer (capture task); /metrics reads without locking, a scrape may
+// see one observation half-applied, which is fine for monitoring.
+#define HISTO_BUCKETS 10
+struct Histo {
+  const uint32_t* le_us;                              // HISTO_BUCKETS upper bounds; +Inf implied
+  uint32_t        counts[HISTO_BUCKETS + 1];
+  uint64_t        sum_us;
+  uint32_t        n;
+  void observe(uint32_t us){
+    int i = 0;
+    while (i < HISTO_BUCKETS && us > le_us[i]) i++;
+    counts[i]++; sum_us += us; n++;
+  }
+};
+static const uint32_t FBGET_LE_US[HISTO_BUCKETS] = { 1000, 2000, 5000, 10000, 20000, 40000, 60000, 100000, 200000, 500000 };
+static const uint32_t ENCODE_LE_US[HISTO_BUCKETS] = { 2000, 5000, 10000, 20000, 40000, 60000, 100000, 200000, 500000, 1000000 };
+static Histo    m_fbget  = { FBGET_LE_US, {}, 0, 0 };           // esp_camera_fb_get() incl. waiting for VSYNC
+static Histo    m_encode = { ENCODE_LE_US, {}, 0, 0 };          // frame2jpg() (non-JPEG sensor modes)
+static uint32_t m_fb_null     = 0;                    // fb_get returned NULL
+static uint32_t m_reinits     = 0;
+static uint32_t m_reinit_fail = 0;
+static uint64_t m_tx_bytes    = 0;                    // all viewers, incl. closed ones (streamsMux)
+static uint32_t m_tx_frames   = 0;
+static uint32_t m_tx_drops    = 0;
+
+// -------------------- Boot timeline --------------------
+// setup() only starts the slow stages: camera init runs in the capture task
+// (APP_CPU), TFT bring-up in the preview task, Wi-Fi + HTTP on this core, so
+// they overlap. Each stage records [start, end) in esp_timer time (since
+// power-on); /boot serves them with time to first captured / served frame.
+#define BOOT_MAX_STAGES 16
+struct BootStage { const char* name; int64_t t0_us, t1_us; uint8_t core; };
+static BootStage        boot_stages[BOOT_MAX_STAGES];
+static uint8_t          boot_n = 0;
+static portMUX_TYPE     bootMux = portMUX_INITIALIZER_UNLOCKED;
+static int64_t          boot_setup_us        = 0;  // setup() entered
+static int64_t          boot_first_frame_us  = 0;  // first frame published
+static volatile int64_t boot_first_served_us = 0;  // first frame written to a client
+
+static void boot_stage(const char* name, int64_t t0){
+  int64_t t1 = esp_timer_get_time();
+  portENTER_CRITICAL(&bootMux);
+  if (boot_n < BOOT_MAX_STAGES) boot_stages[boot_n++] = { name, t0, t1, (uint8_t)xPortGetCoreID() };
+  portEXIT_CRITICAL(&bootMux);
+  TRACE_SPAN(name, t0, t1, 0);
+}
+static inline void boot_served(){ if (!boot_first_served_us) boot_first_served_us = esp_timer_get_time(); }
 
 // -------------------- Server / DNS / mDNS --------------------
-WebServer server(80);
+// WebServer that can hand its current connection to a long-lived consumer
+// (stream fan-out) instead of parking it in HC_WAIT_CLOSE.
+class CamWebServer : public WebServer {
+public:
+  using WebServer::WebServer;
+  WiFiClient detachClient(){ WiFiClient c = _currentClient; _currentClient = WiFiClient(); return c; }
+};
+CamWebServer server(80);
 DNSServer dnsServer;
 const byte DNS_PORT = 53;
 
@@ -176,6 +484,18 @@ static uint16_t parseRot(const String& s){
   if (s == "180" || s == "180°") return 180;
   return 0;
 }
+// Frame size from the JPEG's SOF marker (what the sensor really produced).
+static bool jpeg_dims(const uint8_t* p, size_t len, uint16_t* w, uint16_t* h){
+  size_t i = 2;
+  while (i + 9 <= len && p[i] == 0xFF){
+    uint8_t m = p[i+1];
+    if (m == 0xFF){ i++; continue; }                          // fill byte
+    if (m >= 0xC0 && m <= 0xC3){ *h = p[i+5] << 8 | p[i+6]; *w = p[i+7] << 8 | p[i+8]; return true; }
+    if (m == 0xDA || m == 0xD9) break;                         // scan data: no SOF before it
+    i += 2 + (p[i+2] << 8 | p[i+3]);
+  }
+  return false;
+}
 
 static void sccb_recover() {
   pinMode(SIOD_GPIO_NUM, INPUT_PULLUP);
@@ -220,20 +540,157 @@ static camera_config_t make_cam_cfg(){
 
   c.xclk_freq_hz = XCLK_HZ;
   c.pixel_format = PIXFORMAT_JPEG;
-  c.frame_size   = (framesize_t)S.fs;
+  c.frame_size   = psramFound() ? CAM_FS_MAX : (framesize_t)S.fs;   // buffers fit any later switch
   c.jpeg_quality = S.jpeg_q;
   c.fb_count     = (psramFound() ? FB_COUNT : 1);
   c.fb_location  = psramFound() ? CAMERA_FB_IN_PSRAM : CAMERA_FB_IN_DRAM;
-#ifdef CAMERA_GRAB_WHEN_EMPTY
-  c.grab_mode    = CAMERA_GRAB_WHEN_EMPTY;
-#endif
+  c.grab_mode    = CAMERA_GRAB_LATEST;   // capture_task drains continuously; never hand out a stale fb
   return c;
 }
 
+// -------------------- Framesize switch (no reinit) --------------------
+// The driver is initialised at CAM_FS_MAX, so its PSRAM frame buffers fit every
+// framesize; a switch is then only sensor registers, written between two
+// frames (camLock). Frames still in flight at the old size are dropped by the
+// capture task (JPEG SOF != target), so viewers never get a mixed sequence.
+// Latency = request -> first frame captured at the new size.
+#define FS_SWITCH_TIMEOUT_US 1000000                 // stop dropping; take what comes
+
+struct FsSwitch {
+  volatile bool pending;
+  uint16_t      w, h;                                // target size
+  int64_t       t_req;
+  uint32_t      last_us, max_us;
+  uint32_t      count;
+  uint32_t      dropped;                             // old-size frames discarded
+  uint32_t      timeouts;
+};
+static FsSwitch SW = {};
+static uint8_t  cam_fs_cap = 0;                      // largest framesize the driver buffers fit
+
+// Caller holds camLock and writes the framesize register right after.
+static void fs_switch_begin(uint8_t fs){
+  SW.w = resolution[fs].width; SW.h = resolution[fs].height;
+  SW.t_req   = esp_timer_get_time();
+  SW.pending = true;
+}
+
+// Capture task (camLock held): true while fb still has the old size.
+static bool fs_switch_stale(const camera_fb_t* fb, int64_t ts){
+  uint16_t w = fb->width, h = fb->height;
+  if (fb->format == PIXFORMAT_JPEG) jpeg_dims(fb->buf, fb->len, &w, &h);
+  uint32_t us = (uint32_t)(ts - SW.t_req);
+  bool match = w == SW.w && h == SW.h;
+  if (!match && us < FS_SWITCH_TIMEOUT_US){ SW.dropped++; return true; }
+  if (!match){ SW.timeouts++; LOGW(TAG, "framesize switch: still %ux%u after %u ms", w, h, (unsigned)(us / 1000)); }
+  SW.last_us = us; SW.max_us = max(SW.max_us, us); SW.count++;
+  SW.pending = false;
+  TRACE_SPAN("fs_switch", SW.t_req, ts, (uint32_t)w << 16 | h);
+  return false;
+}
+
+// -------------------- Adaptive bitrate --------------------
+// Once per second the capture task looks at the slowest viewer: per-frame write
+// time vs. the 1/abr_fps budget, bytes still unsent when that budget ran out
+// and capture->sent latency. Congested -> raise q (worse) up to abr_qmax, then
+// drop one framesize and restart from the user's q. Five calm windows in a row
+// walk the same ladder back up to the configured S.jpeg_q / S.fs.
+static const framesize_t FS_LADDER[] = {
+  FRAMESIZE_QQVGA, FRAMESIZE_QVGA, FRAMESIZE_VGA, FRAMESIZE_SVGA, FRAMESIZE_XGA, FRAMESIZE_SXGA, FRAMESIZE_UXGA
+};
+static const int FS_LADDER_N = sizeof(FS_LADDER)/sizeof(FS_LADDER[0]);
+
+struct RateCtl {
+  uint8_t     q;            // quality currently on the sensor
+  uint8_t     fs;           // framesize currently on the sensor
+  uint8_t     calm;         // consecutive uncongested windows
+  uint8_t     cool;         // windows to wait after a step (queued bytes drain first)
+  uint16_t    fps_x10;      // delivered fps of the slowest viewer
+  uint32_t    send_us;      // avg write time per frame, slowest viewer
+  uint32_t    pending;      // avg unsent bytes per frame, slowest viewer
+  uint32_t    lat_us;       // worst capture -> sent latency
+  const char* state;        // "off" | "idle" | "hold" | "down" | "up" | "floor"
+};
+static RateCtl R = { 12, (uint8_t)FRAMESIZE_SVGA, 0, 0, 0, 0, 0, 0, "off" };
+
+static int fsLadderIdx(uint8_t fs){
+  for (int i=0;i<FS_LADDER_N;i++) if ((uint8_t)FS_LADDER[i] == fs) return i;
+  return 0;
+}
+static uint32_t rate_budget_us(){ return 1000000UL / (S.abr_fps ? S.abr_fps : 1); }
+static void rate_reset(){ R.q = S.jpeg_q; R.fs = S.fs; R.calm = 0; R.cool = 0; }
+
+static void rate_apply(uint8_t q, uint8_t fs){
+  if (q == R.q && fs == R.fs) return;
+  xSemaphoreTake(camLock, portMAX_DELAY);
+  sensor_t* s = cam_ready ? esp_camera_sensor_get() : nullptr;
+  if (s){
+    if (fs != R.fs && s->set_framesize){ fs_switch_begin(fs); s->set_framesize(s, (framesize_t)fs); }
+    if (q  != R.q  && s->set_quality)   s->set_quality(s, q);
+  }
+  xSemaphoreGive(camLock);
+  LOGI(TAG, "abr %s -> fs=%s q=%u", R.state, framesizeName((framesize_t)fs), q);
+  R.q = q; R.fs = fs; R.cool = 2;
+}
+
+static void rate_tick(uint32_t window_us){
+  // Collect and reset the window of every viewer; keep the worst one.
+  uint32_t frames_min = UINT32_MAX, send_max = 0, pend_max = 0, lat_max = 0;
+  int viewers = 0;
+  portENTER_CRITICAL(&streamsMux);
+  for (auto& sc : streams){
+    if (!sc.used || !sc.task) continue;
+    viewers++;
+    uint32_t n = sc.win_frames ? sc.win_frames : 1;
+    frames_min = min(frames_min, sc.win_frames);
+    send_max   = max(send_max, sc.win_send_us / n);
+    pend_max   = max(pend_max, sc.win_pending / n);
+    lat_max    = max(lat_max,  sc.win_lat_us);
+    sc.win_frames = sc.win_send_us = sc.win_pending = sc.win_lat_us = 0;
+  }
+  portEXIT_CRITICAL(&streamsMux);
+
+  if (!S.abr){ if (R.state[0] != 'o'){ R.state = "off"; rate_apply(S.jpeg_q, S.fs); } return; }
+  if (!viewers){ R.state = "idle"; R.fps_x10 = 0; R.calm = 0; return; }
+
+  R.fps_x10 = (uint16_t)((uint64_t)frames_min * 10000000ULL / (window_us ? window_us : 1));
+  R.send_us = send_max; R.pending = pend_max; R.lat_us = lat_max;
+  if (R.cool){ R.cool--; return; }
+
+  uint32_t budget = rate_budget_us();
+  uint8_t  qTop   = S.jpeg_q;
+  uint8_t  qMax   = max(S.abr_qmax, qTop);
+  int      fsTop  = fsLadderIdx(S.fs);
+  int      fsMin  = min(fsLadderIdx(S.abr_fsmin), fsTop);
+  int      fsCur  = fsLadderIdx(R.fs);
+
+  // A viewer short of the target while the producer keeps up is also congested
+  // (covers a window where a single frame blocked the whole second).
+  bool starved   = R.fps_x10 < S.abr_fps * 8 && cap_fps_x10 >= S.abr_fps * 9;
+  bool congested = starved || send_max > budget || pend_max > 0 || lat_max > 2*budget;
+  bool roomy     = send_max < budget/2 && pend_max == 0 && lat_max < budget;
+
+  if (congested){
+    R.calm = 0;
+    if (R.q < qMax)          { R.state = "down";  rate_apply(min<uint8_t>(qMax, R.q + 4), R.fs); }
+    else if (fsCur > fsMin)  { R.state = "down";  rate_apply(qTop, (uint8_t)FS_LADDER[fsCur-1]); }
+    else                       R.state = "floor";
+  } else if (roomy && ++R.calm >= 5){
+    R.calm = 0;
+    if (R.q > qTop)          { R.state = "up";    rate_apply(max<uint8_t>(qTop, R.q - 4), R.fs); }
+    else if (fsCur < fsTop)  { R.state = "up";    rate_apply(qMax, (uint8_t)FS_LADDER[fsCur+1]); }
+    else                       R.state = "hold";
+  } else if (!congested && !roomy){
+    R.calm = 0; R.state = "hold";
+  }
+}
+
 static bool applySensorParams(){
+  TRACE_SCOPE("applySensorParams");
   sensor_t* s = esp_camera_sensor_get();
   if (!s) return false;
 
+  rate_reset();
   if (s->set_framesize)     s->set_framesize(s, (framesize_t)S.fs);
   if (s->set_quality)       s->set_quality(s,   S.jpeg_q);
   if (s->set_brightness)    s->set_brightness(s, S.brightness);
@@ -255,7 +712,22 @@ static bool applySensorParams(){
   return true;
 }
 
+// Stack for any task that runs camera_reinit(): a full driver deinit + init,
+// sccb_recover() and the 20 MHz retry (about 6.4 KB on the host build).
+#define CAM_INIT_STACK 8192
+
+// High-water mark of the calling task's stack in bytes; warns when it is low.
+static uint32_t stack_mark(const char* task){
+  uint32_t free_b = uxTaskGetStackHighWaterMark(nullptr);
+  if (free_b < 512) LOGW(TAG, "%s stack: only %u bytes left", task, (unsigned)free_b);
+  return free_b;
+}
+
 static bool camera_reinit(){
+  TRACE_SCOPE("camera_reinit");
+  xSemaphoreTake(camLock, portMAX_DELAY);   // keep the capture task off the driver
+  cam_ready = false;
+  m_reinits++;
   esp_camera_deinit();
   sccb_recover();
 
@@ -267,350 +739,2908 @@ static bool camera_reinit(){
     err = esp_camera_init(&c);
     if (err != ESP_OK){
       LOGE(TAG, "esp_camera_init failed: 0x%x", err);
-      cam_ready = false;
+      m_reinit_fail++;
+      xSemaphoreGive(camLock);
       return false;
     }
   }
 
   applySensorParams();
-  for (int i=0;i<4;i++){ camera_fb_t* fb = esp_camera_fb_get(); if (fb) esp_camera_fb_return(fb); delay(30); }
+  for (int i=0;i<4;i++){ camera_fb_t* fb = esp_camera_fb_get(); if (fb) esp_camera_fb_return(fb); }   // fb_get paces itself
 
-  cam_ready = true;
+  cam_fs_cap = (uint8_t)c.frame_size;
+  SW.pending = false;
+  cam_ready  = true;
+  xSemaphoreGive(camLock);
   return true;
 }
 
-// -------------------- TFT helpers (Adafruit ST7789) --------------------
-static void tft_init_and_splash(const String &ssid, const String &ipStr) {
-#ifdef USE_ST7789
-  pinMode(LCD_BL, OUTPUT);
-  digitalWrite(LCD_BL, HIGH);
+// Settings changed from the UI/API while running: registers are written
+// between two frames and a framesize change is a hot switch, so open streams
+// stay up. Only a framesize the buffers do not fit (no PSRAM) needs a reinit.
+static void camera_apply_live(){
+  if (S.fs > cam_fs_cap){ camera_reinit(); return; }
+  xSemaphoreTake(camLock, portMAX_DELAY);
+  sensor_t* s = cam_ready ? esp_camera_sensor_get() : nullptr;
+  if (s){
+    if (s->status.framesize != (framesize_t)S.fs) fs_switch_begin(S.fs);
+    applySensorParams();
+  }
+  xSemaphoreGive(camLock);
+}
 
-  lcdSPI.end(); // ensure clean state
-  lcdSPI.begin(LCD_SCLK, -1 /*MISO unused*/, LCD_MOSI, LCD_CS);
+// -------------------- Timelapse (interleaved full-resolution shots) --------------------
+// A trigger (/trigger, or every tl_s seconds) makes the capture task switch
+// the sensor to cam_fs_cap between two stream frames, keep the first frame at
+// that size for tl_store instead of publishing it, and switch straight back to
+// the stream size (R.fs). Viewers see one longer frame gap; that gap and the
+// trigger -> capture latency are measured per shot. Triggers arriving while
+// one is pending share its shot.
+#define TL_SHOTS   64                               // per-shot details kept for /timelapse
+#define TL_WAIT_MS 3000                             // /trigger?wait=1 upper bound
 
-  tft.init(240, 240);            // ST7789V 240x240
-  tft.setSPISpeed(40000000);     // 40MHz is safe
-  tft.setRotation(2);            // landscape
-  tft.fillScreen(ST77XX_BLACK);
-  tft.setTextWrap(false);
-  tft.setTextSize(2);
-  tft.setTextColor(ST77XX_WHITE);
+enum TlSrc : uint8_t { TL_SRC_HTTP, TL_SRC_TIMER };
+static const char* const TL_SRC_NAMES[] = { "http", "timer" };
 
-  // Centered two-line splash
-  int16_t x1, y1; uint16_t w, h;
-  tft.getTextBounds(ssid, 0, 0, &x1, &y1, &w, &h);
-  int x = (tft.width() - (int)w)/2;
-  int y = (tft.height()/2) - h - 4;
-  if (x < 0) x = 0; if (y < 0) y = 0;
-  tft.setCursor(x, y); tft.print(ssid);
+struct TlShot {
+  uint32_t id;                                      // trigger id
+  uint32_t n;                                       // frame number in tl_store
+  int64_t  ts_us;
+  uint32_t lat_us;                                  // trigger -> frame captured
+  uint32_t gap_us;                                  // stream frame gap around the shot (0 = none / not yet)
+  uint32_t len;
+  uint16_t w, h;
+  uint8_t  src;
+  bool     ok;
+};
+struct Timelapse {
+  volatile uint32_t req;                            // newest trigger id
+  volatile uint32_t done;                           // newest id served (shot or failure)
+  int64_t  t_req;                                   // oldest unserved trigger
+  uint8_t  src;
+  volatile bool active;                             // sensor switched for a shot (capture task)
+  volatile bool gap_open;                           // next published frame closes the stream gap
+  int64_t  t_pub;                                   // last stream frame before the shot
+  uint32_t shots, failed, coalesced, store_full;
+  uint32_t lat_last, lat_max, gap_last, gap_max;
+  uint64_t lat_sum;
+  TlShot   last;                                    // newest result, failures included
+  TlShot   hist[TL_SHOTS];                          // successful shots, [shots % TL_SHOTS]
+};
+static Timelapse    TL = {};
+static portMUX_TYPE tlMux = portMUX_INITIALIZER_UNLOCKED;
+static uint16_t     tl_kb_cur = 0;                  // allocated on the first shot
 
-  String ip = ipStr;
-  tft.getTextBounds(ip, 0, 0, &x1, &y1, &w, &h);
-  x = (tft.width() - (int)w)/2;
-  y = (tft.height()/2) + 6;
-  if (x < 0) x = 0; if (y < 0) y = 0;
-  tft.setCursor(x, y); tft.print(ip);
-#else
-  (void)ssid; (void)ipStr;
-#endif
+// Any task. Returns the trigger id; *merged if it joined a pending shot.
+static uint32_t tl_trigger(uint8_t src, bool* merged){
+  portENTER_CRITICAL(&tlMux);
+  bool m = TL.req != TL.done;
+  if (m) TL.coalesced++;
+  else { TL.req++; TL.t_req = esp_timer_get_time(); TL.src = src; }
+  uint32_t id = TL.req;
+  portEXIT_CRITICAL(&tlMux);
+  if (merged) *merged = m;
+  return id;
 }
 
-// -------------------- HTTP: index (from header) --------------------
-static void handleIndex(){
-  server.setContentLength(strlen_P(INDEX_HTML));
-  server.send_P(200, "text/html", INDEX_HTML);
+// Capture task: (re)size the store when tl_kb changed and no download holds a pin.
+static bool tl_store_sync(){
+  if (S.tl_kb != tl_kb_cur && !tl_store.pinned()){
+    tl_kb_cur = S.tl_kb;
+    if (!tl_store.begin((size_t)tl_kb_cur * 1024)){ LOGW(TAG, "timelapse store %u KB alloc failed", tl_kb_cur); tl_kb_cur = 0; tl_store.begin(0); }
+  }
+  return tl_kb_cur != 0;
 }
 
-// -------------------- HTTP: settings (HTML form UI) --------------------
-static void sendSettingsPage(){
-  char html[4600];
-  framesize_t fs = (framesize_t)S.fs;
-  snprintf(html, sizeof(html),
-    "<!doctype html><html><head><meta charset=utf-8>"
-    "<meta name=viewport content='width=device-width,initial-scale=1'>"
-    "<title>NozzleCAM Settings</title>"
-    "<style>body{font-family:system-ui;margin:1rem;background:#111;color:#eee}"
-    "label{display:block;margin:.5rem 0 .2rem}input,select,button{font:inherit;padding:.4rem .5rem;border-radius:.4rem;border:1px solid #444;background:#1a1a1a;color:#eee}"
-    "form{max-width:560px} fieldset{border:1px solid #333;border-radius:.6rem;padding:1rem;margin-bottom:1rem}"
-    "legend{padding:0 .4rem} .row{display:flex;gap:.6rem} .row>div{flex:1}</style>"
-    "</head><body><h2>NozzleCAM Settings</h2>"
-    "<form method='POST' action='/settings'>"
-      "<fieldset><legend>Image</legend>"
-        "<label>Frame size</label>"
-        "<select name='fs'>"
-          "<option value='QQVGA'%s>QQVGA</option>"
-          "<option value='QVGA'%s>QVGA</option>"
-          "<option value='VGA'%s>VGA</option>"
-          "<option value='SVGA'%s>SVGA</option>"
-          "<option value='XGA'%s>XGA</option>"
-          "<option value='SXGA'%s>SXGA</option>"
-          "<option value='UXGA'%s>UXGA</option>"
-        "</select>"
-        "<label>JPEG quality (lower=better)</label>"
-        "<input type='number' min='10' max='30' name='q' value='%u'>"
-        "<label>Rotation</label>"
-        "<select name='rot'>"
-          "<option value='0'%s>0°</option>"
-          "<option value='180'%s>180°</option>"
-        "</select>"
-      "</fieldset>"
-      "<fieldset><legend>Tuning</legend>"
-        "<div class='row'>"
-          "<div><label>Brightness</label><input type='number' min='-2' max='2' name='bri' value='%d'></div>"
-          "<div><label>Contrast</label><input type='number' min='-2' max='2' name='con' value='%d'></div>"
-        "</div>"
-        "<div class='row'>"
-          "<div><label>Saturation</label><input type='number' min='-2' max='2' name='sat' value='%d'></div>"
-          "<div><label>AE Level</label><input type='number' min='-2' max='2' name='ae' value='%d'></div>"
-        "</div>"
-        "<div class='row'>"
-          "<div><label>AWB</label><select name='awb'><option value='1'%s>On</option><option value='0'%s>Off</option></select></div>"
-          "<div><label>AEC</label><select name='aec'><option value='1'%s>On</option><option value='0'%s>Off</option></select></div>"
-          "<div><label>AGC</label><select name='agc'><option value='1'%s>On</option><option value='0'%s>Off</option></select></div>"
-        "</div>"
-      "</fieldset>"
-      "<p><button type='submit'>Apply & Save</button> <a href='/' style='margin-left:.6rem'>Back to UI</a></p>"
-    "</form>"
-    "<p style='opacity:.7'>Current: fs=%s q=%u rot=%u bri=%d con=%d sat=%d ae=%d awb=%d aec=%d agc=%d</p>"
-    "</body></html>",
-    (fs==FRAMESIZE_QQVGA)?" selected":"",
-    (fs==FRAMESIZE_QVGA) ?" selected":"",
-    (fs==FRAMESIZE_VGA)  ?" selected":"",
-    (fs==FRAMESIZE_SVGA) ?" selected":"",
-    (fs==FRAMESIZE_XGA)  ?" selected":"",
-    (fs==FRAMESIZE_SXGA) ?" selected":"",
-    (fs==FRAMESIZE_UXGA) ?" selected":"",
-    S.jpeg_q,
-    (S.rot==0)?" selected":"", (S.rot==180)?" selected":"",
-    S.brightness, S.contrast, S.saturation, S.ae_level,
-    S.awb?" selected":"", (!S.awb)?" selected":"",
-    S.aec?" selected":"", (!S.aec)?" selected":"",
-    S.agc?" selected":"", (!S.agc)?" selected":"",
-    framesizeName((framesize_t)S.fs), S.jpeg_q, S.rot, S.brightness, S.contrast, S.saturation, S.ae_level,
-    S.awb, S.aec, S.agc
-  );
-  server.send(200, "text/html", html);
+// Serve every trigger up to now with result r.
+static void tl_done(const TlShot& r){
+  portENTER_CRITICAL(&tlMux);
+  TL.done = TL.req;
+  TL.last = r;
+  if (r.ok){
+    TL.hist[TL.shots % TL_SHOTS] = r;
+    TL.shots++;
+    TL.lat_last = r.lat_us; TL.lat_max = max(TL.lat_max, r.lat_us); TL.lat_sum += r.lat_us;
+  } else TL.failed++;
+  portEXIT_CRITICAL(&tlMux);
+  if (!r.ok) LOGW(TAG, "timelapse shot %u failed (%ux%u)", (unsigned)r.id, r.w, r.h);
+  TRACE_SPAN("tl_shot", TL.t_req, r.ts_us ? r.ts_us : esp_timer_get_time(), (uint32_t)r.w << 16 | r.h);
 }
-static void handleSettingsGet(){ sendSettingsPage(); }
 
-static void handleSettingsPost(){
-  String fs  = server.arg("fs");
-  String q   = server.arg("q");
-  String bri = server.arg("bri");
-  String con = server.arg("con");
-  String sat = server.arg("sat");
-  String ae  = server.arg("ae");
-  String awb = server.arg("awb");
-  String aec = server.arg("aec");
-  String agc = server.arg("agc");
-  String rot = server.arg("rot");
+// Capture task (camLock held, no framesize switch in flight): start a shot.
+static void tl_begin(int64_t t_pub){
+  sensor_t* s = esp_camera_sensor_get();
+  if (!s || !s->set_framesize || !tl_store_sync()){
+    TlShot r = {}; r.id = TL.req; r.src = TL.src;
+    tl_done(r);
+    return;
+  }
+  TL.t_pub  = t_pub;
+  TL.active = true;
+  if (s->status.framesize != (framesize_t)cam_fs_cap){ fs_switch_begin(cam_fs_cap); s->set_framesize(s, (framesize_t)cam_fs_cap); }
+}
 
-  S.fs         = (uint8_t)fsFromStr(fs);
-  S.jpeg_q     = (uint8_t)clampi(q.toInt(),    10, 30);
-  S.brightness = (int8_t)clampi(bri.toInt(),   -2,  2);
-  S.contrast   = (int8_t)clampi(con.toInt(),   -2,  2);
-  S.saturation = (int8_t)clampi(sat.toInt(),   -2,  2);
-  S.ae_level   = (int8_t)clampi(ae.toInt(),    -2,  2);
-  S.awb        = (awb=="1");
-  S.aec        = (aec=="1");
-  S.agc        = (agc=="1");
-  S.rot        = parseRot(rot);  // 0 of 180
+// Capture task (camLock held): fb is the first frame after the switch. Stores
+// it, switches back, and returns true unless fb is also a stream-size frame
+// (stream already at full size, or a failed switch) that should be published.
+static bool tl_shot(const camera_fb_t* fb, int64_t ts){
+  uint16_t w = fb->width, h = fb->height;
+  bool jpeg = fb->format == PIXFORMAT_JPEG;
+  if (jpeg) jpeg_dims(fb->buf, fb->len, &w, &h);
+  TlShot r = {};
+  r.id = TL.req; r.src = TL.src; r.ts_us = ts; r.lat_us = (uint32_t)(ts - TL.t_req);
+  r.len = fb->len; r.w = w; r.h = h;
+  if (jpeg && w == resolution[cam_fs_cap].width && h == resolution[cam_fs_cap].height){
+    TRACE_BEGIN(t_tl);
+    r.ok = tl_store.append(fb->buf, fb->len, ts);
+    TRACE_END("tl_store", t_tl, fb->len);
+    if (!r.ok) TL.store_full++;                     // a download pins what the shot would evict
+    uint32_t first, end;
+    tl_store.range(&first, &end);
+    r.n = end - 1;
+  }
+  sensor_t* s = esp_camera_sensor_get();
+  if (s && s->status.framesize != (framesize_t)R.fs){ fs_switch_begin(R.fs); s->set_framesize(s, (framesize_t)R.fs); }
+  bool stream = w == resolution[R.fs].width && h == resolution[R.fs].height;
+  TL.active   = false;
+  TL.gap_open = !stream;
+  tl_done(r);
+  return !stream;
+}
 
-  saveSettings(S);
-  applySensorParams();
-  // Als framegrootte wisselt, kun je desgewenst camera_reinit() doen:
-  // camera_reinit();
+// Capture task: first stream frame after a shot.
+static void tl_gap(int64_t ts){
+  uint32_t gap = (uint32_t)(ts - TL.t_pub);
+  portENTER_CRITICAL(&tlMux);
+  TL.gap_last = gap; TL.gap_max = max(TL.gap_max, gap);
+  if (TL.last.ok){ TL.last.gap_us = gap; TL.hist[(TL.shots - 1) % TL_SHOTS].gap_us = gap; }
+  TL.gap_open = false;
+  portEXIT_CRITICAL(&tlMux);
+}
 
-  server.sendHeader("Location", "/settings", true);
-  server.send(303, "text/plain", "");
+// -------------------- XCLK / FB_COUNT calibration --------------------
+// Optional self-benchmark, run by the capture task: POST /calibrate starts one
+// now, ?boot=1 makes every boot start with one (until ?boot=0). Each candidate
+// reinits the driver and is measured over CAL_WINDOW_MS of the normal capture
+// path at the configured framesize (viewers keep getting frames, with a gap
+// per reinit): fps, frame interval jitter and fb_get failures. The winner is
+// the fastest candidate without failures; near-ties go to lower jitter, then
+// to fewer frame buffers (PSRAM), then to the earlier candidate. It is kept
+// in NVS with its framesize and used from boot on while that framesize is
+// configured. GET /calibrate returns the table.
+#define CAL_WINDOW_MS   2000
+#define CAL_WARMUP      3                            // frames skipped after a reinit (AEC, DMA settle)
+#define CAL_FPS_TIE_X10 5                            // within 0.5 fps: lower jitter wins
+#define CAL_JITTER_TIE_US 1000                       // within 1 ms as well: fewer buffers win
+
+struct CalCandidate { int xclk; uint8_t fb; };
+static const CalCandidate CAL_CANDIDATES[] = {
+  { 24000000, 2 }, { 24000000, 3 }, { 24000000, 1 },
+  { 20000000, 2 }, { 20000000, 3 }, { 20000000, 1 },
+  { 16000000, 2 }, { 16000000, 3 },
+  { 10000000, 2 }, { 10000000, 3 },
+};
+static const int CAL_N = sizeof(CAL_CANDIDATES)/sizeof(CAL_CANDIDATES[0]);
+
+struct CalResult {
+  int      xclk;
+  uint8_t  fb;
+  bool     init_ok;                                  // false: esp_camera_init failed (or fell back)
+  uint16_t fps_x10;
+  uint32_t jitter_us;                                // std dev of the frame interval
+  uint32_t max_us;                                   // longest frame interval
+  uint32_t frames;
+  uint32_t fails;                                    // fb_get NULLs
+};
+struct CalStore {                                    // NVS "cam"/"cal"
+  uint8_t  fs;                                       // framesize it was measured at
+  uint8_t  fb;
+  uint16_t fps_x10;
+  int32_t  xclk;
+};
+struct Calib {
+  volatile bool req;
+  bool      active;
+  bool      boot;                                    // run at every boot
+  bool      have_saved;
+  uint8_t   fs, idx, n;
+  int8_t    best;                                    // index into res, -1 = none usable
+  int       prev_xclk;                               // restored when nothing works
+  uint8_t   prev_fb;
+  int64_t   t_start, t_done;
+  int64_t   t0, t_last;                              // current window
+  uint32_t  warm, frames, fails, max_us;
+  uint64_t  sum_us, sum_sq;
+  uint32_t  runs;
+  CalStore  saved;
+  CalResult res[CAL_N];
+};
+static Calib        CAL = {};
+static portMUX_TYPE calMux = portMUX_INITIALIZER_UNLOCKED;
+
+// setup(), before the capture task: tuned values for the configured framesize.
+static void cal_load(){
+  Preferences p;
+  p.begin("cam", true);
+  CAL.boot       = p.getBool("cal_boot", false);
+  CAL.have_saved = p.getBytes("cal", &CAL.saved, sizeof(CAL.saved)) == sizeof(CAL.saved);
+  p.end();
+  if (CAL.have_saved && CAL.saved.fs == S.fs){
+    XCLK_HZ = CAL.saved.xclk; FB_COUNT = CAL.saved.fb;
+    LOGI(TAG, "calibrated: XCLK %d MHz, %u frame buffers", XCLK_HZ / 1000000, FB_COUNT);
+  }
+  CAL.req = CAL.boot;
 }
 
-// -------------------- HTTP: JSON API for settings --------------------
-static void handleApiGet(){
-  char buf[320];
-  framesize_t fs = (framesize_t)S.fs;
-  snprintf(buf, sizeof(buf),
-    "{"
-      "\"fs\":\"%s\",\"q\":%u,"
-      "\"rot\":%u,"
-      "\"bri\":%d,\"con\":%d,\"sat\":%d,\"ae\":%d,"
-      "\"awb\":%d,\"aec\":%d,\"agc\":%d"
-    "}",
-    framesizeName(fs), S.jpeg_q, S.rot,
-    S.brightness, S.contrast, S.saturation, S.ae_level,
-    S.awb, S.aec, S.agc
-  );
-  server.send(200, "application/json", buf);
+static bool cal_better(const CalResult& a, const CalResult& b){
+  if ((a.fails == 0) != (b.fails == 0)) return a.fails == 0;
+  if (abs((int)a.fps_x10 - (int)b.fps_x10) > CAL_FPS_TIE_X10) return a.fps_x10 > b.fps_x10;
+  if (abs((int)a.jitter_us - (int)b.jitter_us) > CAL_JITTER_TIE_US) return a.jitter_us < b.jitter_us;
+  return a.fb < b.fb;
 }
-static void handleApiPost(){
-  if (server.hasArg("plain")) {
-    String body = server.arg("plain");
-    auto findInt = [&](const char* k, int def)->int{
-      int p = body.indexOf(String("\"")+k+"\"");
-      if (p<0) return def;
-      p = body.indexOf(':', p); if (p<0) return def;
-      int e = body.indexOf(',', p+1); if (e<0) e = body.indexOf('}', p+1);
-      if (e<0) return def;
-      return body.substring(p+1, e).toInt();
-    };
-    auto findStr = [&](const char* k, String def)->String{
-      int p = body.indexOf(String("\"")+k+"\"");
-      if (p<0) return def;
-      p = body.indexOf(':', p); if (p<0) return def;
-      int q1 = body.indexOf('"', p+1); if (q1<0) return def;
-      int q2 = body.indexOf('"', q1+1); if (q2<0) return def;
-      return body.substring(q1+1, q2);
-    };
-
-    String fs = findStr("fs", framesizeName((framesize_t)S.fs));
-    S.fs         = (uint8_t)fsFromStr(fs);
-    S.jpeg_q     = (uint8_t)clampi(findInt("q",  S.jpeg_q), 10, 30);
-    S.rot        = (uint16_t)((findInt("rot", S.rot)==180) ? 180 : 0);
-    S.brightness = (int8_t)clampi(findInt("bri",S.brightness), -2, 2);
-    S.contrast   = (int8_t)clampi(findInt("con",S.contrast),   -2, 2);
-    S.saturation = (int8_t)clampi(findInt("sat",S.saturation), -2, 2);
-    S.ae_level   = (int8_t)clampi(findInt("ae", S.ae_level),   -2, 2);
-    S.awb        = findInt("awb", S.awb) ? true:false;
-    S.aec        = findInt("aec", S.aec) ? true:false;
-    S.agc        = findInt("agc", S.agc) ? true:false;
-
-    saveSettings(S);
-    applySensorParams();
-    server.send(200, "application/json", "{\"ok\":true}");
-    return;
+
+static void cal_record(const CalResult& r){
+  portENTER_CRITICAL(&calMux);
+  CAL.res[CAL.n++] = r;
+  portEXIT_CRITICAL(&calMux);
+  LOGI(TAG, "calibration: XCLK %d MHz fb %u: %s %.1f fps, jitter %.1f ms, %u fails",
+       r.xclk / 1000000, r.fb, r.init_ok ? "ok" : "init failed", r.fps_x10 / 10.0, r.jitter_us / 1000.0, (unsigned)r.fails);
+}
+
+// Pick the winner, run with it and keep it.
+static void cal_finish(){
+  int best = -1;
+  for (int i=0;i<CAL.n;i++){
+    const CalResult& r = CAL.res[i];
+    if (r.init_ok && r.frames && (best < 0 || cal_better(r, CAL.res[best]))) best = i;
+  }
+  if (best >= 0){ XCLK_HZ = CAL.res[best].xclk; FB_COUNT = CAL.res[best].fb; }
+  else          { XCLK_HZ = CAL.prev_xclk;      FB_COUNT = CAL.prev_fb; }
+  if (!camera_reinit()) LOGE(TAG, "calibration: reinit with the result failed");
+  cap_stack_free = stack_mark("capture");
+  if (best >= 0){
+    CalStore cs = { CAL.fs, (uint8_t)FB_COUNT, CAL.res[best].fps_x10, XCLK_HZ };
+    Preferences p;
+    p.begin("cam", false);
+    if (p.putBytes("cal", &cs, sizeof(cs)) != sizeof(cs)) LOGW(TAG, "calibration: NVS write failed");
+    p.end();
+    CAL.saved = cs; CAL.have_saved = true;
   }
-  handleSettingsPost();
+  portENTER_CRITICAL(&calMux);
+  CAL.best = (int8_t)best; CAL.active = false; CAL.runs++;
+  CAL.t_done = esp_timer_get_time();
+  portEXIT_CRITICAL(&calMux);
+  if (CAL.boot && CAL.runs == 1) boot_stage("calibrate", CAL.t_start);
+  TRACE_SPAN("calibrate", CAL.t_start, CAL.t_done, best);
+  LOGI(TAG, "calibration done: XCLK %d MHz, %u frame buffers", XCLK_HZ / 1000000, FB_COUNT);
 }
 
-// -------------------- HTTP: health / reinit / jpg / stream --------------------
-static void handleHealth(){
-  bool ok = false;
-  if (cam_ready){
-    for (int i=0;i<2 && !ok;i++){
-      camera_fb_t* fb = esp_camera_fb_get();
-      if (fb){ esp_camera_fb_return(fb); ok = true; }
-      else delay(15);
+// Reinit with candidate CAL.idx (or the next one that comes up) and open its window.
+static void cal_next(){
+  for (; CAL.idx < CAL_N; CAL.idx++){
+    const CalCandidate& c = CAL_CANDIDATES[CAL.idx];
+    XCLK_HZ = c.xclk; FB_COUNT = c.fb;
+    bool ok = camera_reinit();
+    cap_stack_free = stack_mark("capture");           // runs on capture_task, like the boot init
+    if (ok && XCLK_HZ == c.xclk){                     // camera_reinit's 20 MHz fallback does not count
+      CAL.t0 = CAL.t_last = esp_timer_get_time();
+      CAL.warm = CAL.frames = CAL.fails = CAL.max_us = 0;
+      CAL.sum_us = CAL.sum_sq = 0;
+      return;
     }
+    CalResult r = { c.xclk, c.fb, false, 0, 0, 0, 0, 0 };
+    cal_record(r);
   }
-  char buf[160];
-  size_t fi = heap_caps_get_free_size(MALLOC_CAP_8BIT | MALLOC_CAP_INTERNAL);
-  size_t fp = heap_caps_get_free_size(MALLOC_CAP_SPIRAM);
-  snprintf(buf, sizeof(buf), "{\"ok\":%s,\"free_int\":%u,\"free_psram\":%u}",
-           ok?"true":"false", (unsigned)fi, (unsigned)fp);
-  server.send(ok?200:500, "application/json", buf);
+  cal_finish();
 }
-static void handleReinit(){
-  bool ok = camera_reinit();
-  server.send(ok?200:500, "text/plain", ok ? "reinit ok" : "reinit failed");
+
+static void cal_begin(){
+  portENTER_CRITICAL(&calMux);
+  CAL.req = false; CAL.active = true;
+  CAL.fs = S.fs; CAL.idx = 0; CAL.n = 0; CAL.best = -1;
+  CAL.t_start = esp_timer_get_time(); CAL.t_done = 0;
+  portEXIT_CRITICAL(&calMux);
+  CAL.prev_xclk = XCLK_HZ; CAL.prev_fb = (uint8_t)FB_COUNT;
+  LOGI(TAG, "calibration: %d candidates at %s", CAL_N, framesizeName((framesize_t)S.fs));
+  cal_next();
 }
-static void handleJpg(){
-  if (!cam_ready){ server.send(503, "text/plain", "cam not ready"); return; }
-  camera_fb_t* fb = esp_camera_fb_get();
-  if (!fb){ server.send(500, "text/plain", "fb NULL"); return; }
 
-  uint8_t* jpg = nullptr; size_t len = 0;
-  if (fb->format != PIXFORMAT_JPEG){
-    bool ok = frame2jpg(fb, S.jpeg_q, &jpg, &len);
-    esp_camera_fb_return(fb); fb=nullptr;
-    if (!ok){ server.send(500, "text/plain", "frame2jpg failed"); return; }
-  } else { jpg = fb->buf; len = fb->len; }
+// Capture task, after every fb_get (camLock released).
+static void cal_tick(bool got, int64_t now){
+  if (!got) CAL.fails++;
+  else if (CAL.warm < CAL_WARMUP){ CAL.warm++; CAL.t0 = CAL.t_last = now; return; }
+  else {
+    uint32_t d = (uint32_t)(now - CAL.t_last);
+    CAL.sum_us += d; CAL.sum_sq += (uint64_t)d * d; CAL.max_us = max(CAL.max_us, d);
+    CAL.frames++; CAL.t_last = now;
+  }
+  if (now - CAL.t0 < CAL_WINDOW_MS * 1000LL) return;
 
-  server.setContentLength(len);
-  server.send(200, "image/jpeg", "");
-  server.client().write((const uint8_t*)jpg, len);
+  const CalCandidate& c = CAL_CANDIDATES[CAL.idx];
+  CalResult r = { c.xclk, c.fb, true, 0, 0, CAL.max_us, CAL.frames, CAL.fails };
+  if (CAL.frames){
+    double mean = (double)CAL.sum_us / CAL.frames;
+    double var  = (double)CAL.sum_sq / CAL.frames - mean * mean;
+    r.fps_x10   = (uint16_t)(CAL.frames * 10000000LL / max<int64_t>(CAL.t_last - CAL.t0, 1));
+    r.jitter_us = (uint32_t)sqrt(var > 0 ? var : 0);
+  }
+  cal_record(r);
+  CAL.idx++;
+  cal_next();
+}
 
-  if (fb) esp_camera_fb_return(fb); else if (jpg) free(jpg);
+// -------------------- Capture producer --------------------
+// Hand a freshly published frame to every viewer: one ref per mailbox entry.
+static void stream_dispatch(FrameSlot* f){
+  portENTER_CRITICAL(&streamsMux);
+  for (auto& sc : streams){
+    if (!sc.used || !sc.task) continue;
+    frames.addRef(f);
+    if (sc.q.push(f)) xTaskNotifyGive(sc.task);
+    else frames.release(f);                           // shows up as a seq gap in drops
+  }
+  for (auto t : jpgWaiters) if (t) xTaskNotifyGive(t);
+  portEXIT_CRITICAL(&streamsMux);
 }
-static void handleStream(){
-  if (!cam_ready){ server.send(503, "text/plain", "cam not ready"); return; }
-  WiFiClient client = server.client(); if (!client) return;
 
-  client.print(
-    "HTTP/1.1 200 OK\r\n"
-    "Content-Type: multipart/x-mixed-replace; boundary=frame\r\n"
-    "Cache-Control: no-store, no-cache, must-revalidate, max-age=0\r\n"
-    "Pragma: no-cache\r\n"
-    "Connection: close\r\n\r\n"
-  );
+// Feed the pre-event buffer at clip_fps; (re)size the arena here, in the only
+// producer, whenever the setting changed and no /clip holds a pin.
+static void clip_record(const FrameSlot* f, int64_t ts){
+  static uint16_t cur_kb = 0;
+  static int64_t  last   = 0;
+  if (S.clip_kb != cur_kb && !clips.pinned()){
+    cur_kb = S.clip_kb;
+    if (!clips.begin((size_t)cur_kb * 1024)){ LOGW(TAG, "clip buffer %u KB alloc failed", cur_kb); cur_kb = 0; clips.begin(0); }
+  }
+  if (!cur_kb) return;
+  int64_t period = 1000000 / max<uint8_t>(S.clip_fps, 1);
+  if (ts - last < period - period / 8) return;   // slack: capture jitter must not halve the rate
+  last = (ts - last > 2 * period) ? ts : last + period;
+  TRACE_BEGIN(t_clip);
+  clips.append(f->buf, f->len, ts);
+  TRACE_END("clip_append", t_clip, f->len);
+}
+
+// The only caller of esp_camera_fb_get() while running: every frame is copied
+// once into the shared ring and the driver buffer goes straight back.
+static void capture_task(void*){
+  int64_t t_init = esp_timer_get_time();
+  if (!camera_reinit()) LOGE(TAG, "Camera failed to init");   // boot: overlaps Wi-Fi start on the other core
+  cap_stack_free = stack_mark("capture");
+  boot_stage("camera", t_init);
+
+  uint8_t  nulls = 0;
+  uint32_t n = 0;
+  int64_t  win = esp_timer_get_time();
+  int64_t  t_pub = 0, tl_next = 0;
+  for (;;){
+    if (!cam_ready){ vTaskDelay(pdMS_TO_TICKS(50)); continue; }
 
-  uint8_t nulls = 0;
-  while (client.connected()){
-    camera_fb_t* fb = esp_camera_fb_get();
+    if (CAL.req && !CAL.active && !TL.active && !TL.gap_open && !SW.pending) cal_begin();
+
+    xSemaphoreTake(camLock, portMAX_DELAY);
+    if (TL.req != TL.done && !TL.active && !TL.gap_open && !SW.pending && !CAL.active && cam_ready) tl_begin(t_pub);
+    int64_t t_get = esp_timer_get_time();
+    camera_fb_t* fb = cam_ready ? esp_camera_fb_get() : nullptr;
     if (!fb){
-      if (++nulls >= 8) break;
-      delay(8);
+      xSemaphoreGive(camLock);
+      m_fb_null++;
+      if (++nulls >= 8){ LOGW(TAG, "fb_get NULL x%u", nulls); nulls = 0; }
+      vTaskDelay(pdMS_TO_TICKS(8));
+      if (CAL.active) cal_tick(false, esp_timer_get_time());
       continue;
     }
     nulls = 0;
+    int64_t  ts = esp_timer_get_time();
+    cap_last_us = ts;
+    m_fbget.observe((uint32_t)(ts - t_get));
+    TRACE_SPAN("fb_get", t_get, ts, fb->len);
+    if (SW.pending && fs_switch_stale(fb, ts)){ esp_camera_fb_return(fb); xSemaphoreGive(camLock); continue; }
+    if (TL.active && tl_shot(fb, ts)){ esp_camera_fb_return(fb); xSemaphoreGive(camLock); continue; }
+    uint16_t w  = fb->width, h = fb->height;
 
     uint8_t* jpg = nullptr; size_t len = 0;
     if (fb->format != PIXFORMAT_JPEG){
       bool ok = frame2jpg(fb, S.jpeg_q, &jpg, &len);
-      esp_camera_fb_return(fb); fb=nullptr;
-      if (!ok) break;
+      int64_t t_enc = esp_timer_get_time();
+      m_encode.observe((uint32_t)(t_enc - ts));
+      TRACE_SPAN("frame2jpg", ts, t_enc, len);
+      esp_camera_fb_return(fb); fb = nullptr;
+      xSemaphoreGive(camLock);
+      if (!ok){ LOGW(TAG, "frame2jpg failed"); continue; }
     } else { jpg = fb->buf; len = fb->len; }
 
-    char part[128];
-    int hlen = snprintf(part, sizeof(part),
-      "--frame\r\nContent-Type: image/jpeg\r\nContent-Length: %u\r\n\r\n", (unsigned)len);
-    if (!client.write((const uint8_t*)part, hlen)) { if (fb) esp_camera_fb_return(fb); else if (jpg) free(jpg); break; }
-    if (!client.write((const uint8_t*)jpg,  len))  { if (fb) esp_camera_fb_return(fb); else if (jpg) free(jpg); break; }
-    if (!client.write((const uint8_t*)"\r\n", 2))  { if (fb) esp_camera_fb_return(fb); else if (jpg) free(jpg); break; }
+    TRACE_BEGIN(t_copy);
+    FrameSlot* slot = frames.beginWrite(len);
+    if (slot) memcpy(slot->buf, jpg, len);
+    TRACE_END("ring_copy", t_copy, len);
+    if (fb){ esp_camera_fb_return(fb); xSemaphoreGive(camLock); } else free(jpg);
+
+    if (slot){
+      frames.publish(slot, len, w, h, ts); stream_dispatch(slot); n++;
+      if (!boot_first_frame_us) boot_first_frame_us = ts;
+      if (TL.gap_open) tl_gap(ts);
+      t_pub = ts;
+      clip_record(slot, ts);                     // still latest: not rewritten until our next beginWrite
+    }
+    else cap_drops++;
+    if (CAL.active) cal_tick(true, ts);            // may reinit the driver
+
+    int64_t tl_period = (S.tl_kb ? S.tl_s : 0) * 1000000LL;      // interval trigger
+    if (!tl_period) tl_next = 0;
+    else if (!tl_next) tl_next = ts + tl_period;
+    else if (ts >= tl_next){ tl_trigger(TL_SRC_TIMER, nullptr); tl_next = ts - tl_next >= tl_period ? ts + tl_period : tl_next + tl_period; }
 
-    if (fb) esp_camera_fb_return(fb); else if (jpg) free(jpg);
-    delay(1);
+    if (ts - win >= 1000000){
+      cap_fps_x10 = (uint16_t)((n * 10000000LL) / (ts - win));
+      if (!TL.active && !CAL.active) rate_tick((uint32_t)(ts - win));   // ABR must not switch mid-shot or mid-measurement
+      if (tl_kb_cur) tl_store_sync();
+      n = 0; win = ts;
+    }
   }
 }
 
-// -------------------- Setup --------------------
-void setup(){
-  Serial.begin(115200);
-  delay(150);
+// -------------------- Camera health monitor (passive) --------------------
+// Judges the camera from what the capture task records anyway, never by taking
+// frames: the time of the last fb_get that returned one, and whether the
+// driver is up. No frame for HW_STALL_MS is an outage. Its cause is read once
+// at the start: "init" (driver down, the last init failed), "sccb" (the
+// sensor's ID register does not read back) or "stall" (the sensor answers but
+// sends nothing). Recovery is camera_reinit(), which deinits, runs
+// sccb_recover() and inits again. It is retried with a doubling backoff
+// (HW_BACKOFF_MIN_MS .. HW_BACKOFF_MAX_MS) until a frame arrives. Resolved
+// outages go into a short history, and their downtime adds up.
+#define HW_CHECK_MS       250
+#define HW_STALL_MS       2000                       // no frame for this long = outage
+#define HW_BOOT_GRACE_MS  8000                       // first init + first frame
+#define HW_LOCK_MS        5000                       // fb_get gives up after 4 s
+#define HW_BACKOFF_MIN_MS 1000
+#define HW_BACKOFF_MAX_MS 60000
+#define HW_HIST           8
+#define HW_STACK          CAM_INIT_STACK             // camera_reinit() runs the whole driver init here
 
-  if (nvs_flash_init()!=ESP_OK){ nvs_flash_erase(); nvs_flash_init(); }
-  loadSettings(S);
+enum : uint8_t { HW_CAUSE_STALL, HW_CAUSE_SCCB, HW_CAUSE_INIT };
+static const char* const HW_CAUSES[] = { "stall", "sccb", "init" };
 
-  cam_ready = camera_reinit();
-  if (!cam_ready) LOGE(TAG, "Camera failed to init");
+struct Outage {
+  uint8_t  cause;
+  uint8_t  attempts;                                 // recoveries run
+  int64_t  t0_us;                                    // last frame before (boot if none)
+  int64_t  t1_us;                                    // first frame after
+};
+struct HealthMon {
+  bool     down;
+  Outage   cur;                                      // while down
+  int64_t  next_try;
+  uint32_t backoff_ms;
+  uint32_t outages, attempts, init_fails;
+  int64_t  down_us;                                  // resolved outages, summed
+  Outage   hist[HW_HIST];                            // resolved, [resolved % HW_HIST]
+  uint32_t resolved;
+  uint32_t stack_free;                               // camwd high-water mark after the last recovery
+};
+static HealthMon    HW = {};
+static portMUX_TYPE hwMux = portMUX_INITIALIZER_UNLOCKED;
+static TaskHandle_t healthTask = nullptr;
 
-  WiFi.mode(WIFI_AP);
-  bool ap_ok = WiFi.softAP(AP_SSID, AP_PASSWORD, AP_CHANNEL, false, 4);
-  IPAddress ip = WiFi.softAPIP();
+// One SCCB read of the OV2640 product ID (bank 1, reg 0x0A). True when the
+// sensor answers, or when there is nothing to ask (other sensor, lock busy).
+static bool sensor_answers(){
+  if (xSemaphoreTake(camLock, pdMS_TO_TICKS(HW_LOCK_MS)) != pdTRUE) return true;
+  sensor_t* s = cam_ready ? esp_camera_sensor_get() : nullptr;
+  bool ok = !s || !s->get_reg || s->id.PID != OV2640_PID || s->get_reg(s, 0x10A, 0xFF) == OV2640_PID;
+  xSemaphoreGive(camLock);
+  return ok;
+}
 
-  Serial.println(ap_ok ? "AP started." : "AP start failed!");
-  Serial.print("SSID: "); Serial.println(AP_SSID);
-  Serial.print("IP:   "); Serial.println(ip);
+static void health_task(void*){
+  int64_t armed = esp_timer_get_time() + HW_BOOT_GRACE_MS * 1000LL;
+  for (;;){
+    vTaskDelay(pdMS_TO_TICKS(HW_CHECK_MS));
+    int64_t now = esp_timer_get_time();
+    if (now < armed || CAL.active) continue;          // calibration reinits on purpose
+    int64_t last = cap_last_us;
 
-  dnsServer.start(DNS_PORT, "*", ip);
-  Serial.println("DNS server started (wildcard): http://nozzlecam/");
+    if (!HW.down){
+      if (now - last < HW_STALL_MS * 1000LL) continue;
+      uint8_t cause = !cam_ready ? HW_CAUSE_INIT : sensor_answers() ? HW_CAUSE_STALL : HW_CAUSE_SCCB;
+      portENTER_CRITICAL(&hwMux);
+      HW.down = true;
+      HW.cur  = { cause, 0, last ? last : boot_setup_us, 0 };
+      HW.outages++;
+      HW.backoff_ms = HW_BACKOFF_MIN_MS;
+      HW.next_try   = now;
+      portEXIT_CRITICAL(&hwMux);
+      LOGW(TAG, "camera down (%s): no frame for %u ms", HW_CAUSES[cause], (unsigned)((now - HW.cur.t0_us) / 1000));
+    }
 
-  if (MDNS.begin("nozzcam")) {
-    Serial.println("mDNS: http://nozzcam.local");
-  } else {
-    Serial.println("mDNS setup failed");
+    if (last > HW.cur.t0_us){                         // frames again
+      portENTER_CRITICAL(&hwMux);
+      HW.cur.t1_us = last;
+      HW.down_us  += last - HW.cur.t0_us;
+      HW.hist[HW.resolved++ % HW_HIST] = HW.cur;
+      HW.down = false;
+      portEXIT_CRITICAL(&hwMux);
+      LOGW(TAG, "camera back after %u ms, %u recoveries", (unsigned)((last - HW.cur.t0_us) / 1000), HW.cur.attempts);
+      TRACE_SPAN("camera_outage", HW.cur.t0_us, last, HW.cur.cause);
+      continue;
+    }
+    if (now < HW.next_try) continue;
+
+    LOGW(TAG, "camera %s: recovery #%u", HW_CAUSES[HW.cur.cause], HW.cur.attempts + 1);
+    bool ok = camera_reinit();
+    uint32_t free_b = stack_mark("camwd");
+    portENTER_CRITICAL(&hwMux);
+    HW.cur.attempts++; HW.attempts++;
+    HW.stack_free = free_b;
+    if (!ok) HW.init_fails++;
+    HW.next_try   = esp_timer_get_time() + HW.backoff_ms * 1000LL;
+    HW.backoff_ms = min<uint32_t>(HW.backoff_ms * 2, HW_BACKOFF_MAX_MS);
+    portEXIT_CRITICAL(&hwMux);
   }
+}
 
+// -------------------- TFT helpers (Adafruit ST7789) --------------------
 #ifdef USE_ST7789
-  // Show splash op de TFT
-  tft_init_and_splash(AP_SSID, ip.toString());
-#endif
+static String splash_ssid, splash_ip;            // redrawn when the preview is switched off
 
-  // Routes
-  server.on("/",             HTTP_GET, handleIndex);
-  server.on("/settings",     HTTP_GET,  [](){ handleSettingsGet(); });
-  server.on("/settings",     HTTP_POST, [](){ handleSettingsPost(); });
-  server.on("/api/settings", HTTP_GET,  [](){ handleApiGet(); });
-  server.on("/api/settings", HTTP_POST, [](){ handleApiPost(); });
-  server.on("/health",       HTTP_GET, handleHealth);
-  server.on("/reinit",       HTTP_GET, handleReinit);
-  server.on("/jpg",          HTTP_GET, handleJpg);
-  server.on("/stream",       HTTP_GET, handleStream);
-  server.begin();
+static void tft_draw_splash(const String &ssid, const String &ipStr) {
+  splash_ssid = ssid; splash_ip = ipStr;
+  tft.fillScreen(ST77XX_BLACK);
+  tft.setTextWrap(false);
+  tft.setTextSize(2);
+  tft.setTextColor(ST77XX_WHITE);
+
+  // Centered two-line splash
+  int16_t x1, y1; uint16_t w, h;
+  tft.getTextBounds(ssid, 0, 0, &x1, &y1, &w, &h);
+  int x = (tft.width() - (int)w)/2;
+  int y = (tft.height()/2) - h - 4;
+  if (x < 0) x = 0; if (y < 0) y = 0;
+  tft.setCursor(x, y); tft.print(ssid);
+
+  String ip = ipStr;
+  tft.getTextBounds(ip, 0, 0, &x1, &y1, &w, &h);
+  x = (tft.width() - (int)w)/2;
+  y = (tft.height()/2) + 6;
+  if (x < 0) x = 0; if (y < 0) y = 0;
+  tft.setCursor(x, y); tft.print(ip);
+}
+
+static void tft_init() {
+  pinMode(LCD_BL, OUTPUT);
+  digitalWrite(LCD_BL, HIGH);
+
+  lcdSPI.end(); // ensure clean state
+  lcdSPI.begin(LCD_SCLK, -1 /*MISO unused*/, LCD_MOSI, LCD_CS);
+
+  tft.init(240, 240);            // ST7789V 240x240
+  tft.setSPISpeed(40000000);     // 40MHz is safe
+  tft.setRotation(2);            // landscape
+}
+#endif
+
+// -------------------- TFT live preview (JPEGDEC scaled decode) --------------------
+// Low-priority task on CAPTURE_CORE: takes the newest ring frame, decodes it at
+// 1/1..1/8 scale straight into bulk SPI pixel writes (no full-frame buffer).
+// Frame budget: the next preview frame waits until decode+push time is at most
+// PREVIEW_BUDGET_PCT of the elapsed time, so a slow panel lowers preview fps,
+// never capture or stream fps (those run on other priorities / the other core).
+#define PREVIEW_BUDGET_PCT 25
+struct PreviewStats {
+  uint32_t frames;
+  uint32_t cost_us;                              // last decode + SPI push
+  uint8_t  div;                                  // 1, 2, 4 or 8
+  bool     active;
+};
+static PreviewStats PV = {};
+
+#ifdef USE_ST7789
+static JPEGDEC jpegdec;
+
+static int preview_draw(JPEGDRAW* d){
+  tft.setAddrWindow(d->x, d->y, d->iWidth, d->iHeight);
+  tft.writePixels(d->pPixels, (uint32_t)d->iWidth * d->iHeight, true, true);   // RGB565 big-endian: raw bytes
+  return 1;
+}
+
+// Least reduction that fits the panel.
+static int preview_scale(uint16_t w, uint16_t h, uint8_t* div){
+  static const int OPT[4] = { 0, JPEG_SCALE_HALF, JPEG_SCALE_QUARTER, JPEG_SCALE_EIGHTH };
+  for (int i=0;i<4;i++){
+    *div = 1 << i;
+    if (w / *div <= 240 && h / *div <= 240) return OPT[i];
+  }
+  return OPT[3];
+}
+
+static TaskHandle_t previewTask = nullptr;
+
+// Also brings the panel up at boot: init overlaps Wi-Fi start, the splash
+// follows once setup() notifies that the AP (and so its IP) is up.
+static void preview_task(void*){
+  int64_t t0 = esp_timer_get_time();
+  tft_init();
+  boot_stage("tft_init", t0);
+  ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+  t0 = esp_timer_get_time();
+  tft_draw_splash(AP_SSID, WiFi.softAPIP().toString());
+  boot_stage("tft_splash", t0);
+
+  uint32_t last_seq = 0;
+  uint16_t last_w = 0, last_h = 0;
+  int64_t  next = 0;
+  for (;;){
+    if (!S.tft_pv || !cam_ready){
+      if (PV.active){ PV.active = false; last_w = 0; tft_draw_splash(splash_ssid, splash_ip); }
+      vTaskDelay(pdMS_TO_TICKS(200));
+      continue;
+    }
+    int64_t now = esp_timer_get_time();
+    if (now < next){ vTaskDelay(pdMS_TO_TICKS((next - now) / 1000 + 1)); continue; }
+    FrameSlot* f = frames.acquireLatest(last_seq);
+    if (!f){ vTaskDelay(pdMS_TO_TICKS(20)); continue; }
+    last_seq = f->seq;
+
+    TRACE_BEGIN(t_pv);
+    int64_t t0 = esp_timer_get_time();
+    uint8_t div;
+    int opt = preview_scale(f->width, f->height, &div);
+    if (!PV.active || f->width != last_w || f->height != last_h){
+      tft.fillScreen(ST77XX_BLACK);              // size changed: clear the old borders
+      last_w = f->width; last_h = f->height; PV.active = true;
+    }
+    if (jpegdec.openRAM(f->buf, (int)f->len, preview_draw)){
+      jpegdec.setPixelType(RGB565_BIG_ENDIAN);
+      int x0 = (240 - f->width / div) / 2, y0 = (240 - f->height / div) / 2;
+      tft.startWrite();
+      jpegdec.decode(max(0, x0), max(0, y0), opt);
+      tft.endWrite();
+      jpegdec.close();
+    }
+    frames.release(f);
+    uint32_t cost = (uint32_t)(esp_timer_get_time() - t0);
+    TRACE_END("tft_preview", t_pv, div);
+
+    PV.frames++; PV.cost_us = cost; PV.div = div;
+    int64_t interval = max<int64_t>(1000000 / max<uint8_t>(S.tft_fps, 1), (int64_t)cost * 100 / PREVIEW_BUDGET_PCT);
+    next = t0 + interval;
+  }
+}
+#endif
+
+// -------------------- Motion metric (JPEG DC thumbnails) --------------------
+// A low-priority task on CAPTURE_CORE decodes the newest frame at 1/8 scale:
+// JPEGDEC then only evaluates each block's DC coefficient, so an SVGA frame
+// becomes a 100x75 grayscale thumbnail in a few ms. The thumbnail is compared
+// with the previous one (motion_diff_swar): the score is the per mille of
+// pixels that changed by more than MOTION_NOISE grey levels, plus the mean
+// absolute difference. It only ever looks at the latest frame and holds no
+// mailbox slot, and a CPU budget caps its rate, so capture and stream fps do
+// not depend on it.
+//
+// Events, with hysteresis: "motion" when the score reaches md_thr, "still"
+// after md_still_s seconds below it (head parked, print stopped), "scene"
+// when md_jump per mille change at once (a blob, spaghetti, a hand).
+#define MOTION_MAX_HZ        10
+#define MOTION_BUDGET_PCT    20
+#define MOTION_NOISE         12       // grey levels: sensor noise and JPEG block jitter
+#define MOTION_HIST          32       // per-frame scores kept for /motion
+#define MOTION_EVENTS        16
+#define MOTION_SCENE_HOLD_MS 2000     // at most one "scene" event per window
+#define MOTION_THUMB_MAX     ((1600 / 8) * (1200 / 8))
+
+enum MotionEvt : uint8_t { ME_MOTION, ME_STILL, ME_SCENE };
+static const char* const MOTION_EVT_NAME[] = { "motion", "still", "scene" };
+enum MotionSt : uint8_t { MS_UNKNOWN, MS_MOVING, MS_STILL };
+static const char* const MOTION_ST_NAME[] = { "unknown", "moving", "still" };
+
+struct MotionScore { uint32_t seq; int64_t ts_us; uint16_t changed; uint16_t mad_x10; };
+struct MotionEvent { uint32_t id; uint8_t type; uint32_t seq; int64_t ts_us; uint16_t score; };
+struct MotionStats {
+  MotionScore hist[MOTION_HIST];
+  uint32_t    scores;                           // scores computed (hist index = scores % MOTION_HIST)
+  MotionEvent ev[MOTION_EVENTS];
+  uint32_t    events;                           // events emitted; ids are 1..events
+  uint32_t    ev_count[3];                      // per MotionEvt
+  uint16_t    w, h;                             // thumbnail size
+  uint8_t     state;                            // MotionSt
+  uint32_t    decode_us, diff_us;               // last frame
+  bool        active;
+};
+static MotionStats  MD = {};
+static portMUX_TYPE motionMux = portMUX_INITIALIZER_UNLOCKED;
+
+static JPEGDEC* motion_dec   = nullptr;         // allocated on first use (~20 KB)
+static uint8_t* motion_thumb[2] = {};           // current, previous
+static uint16_t motion_tw = 0, motion_th = 0;   // thumbnail being decoded
+
+static int motion_draw(JPEGDRAW* d){
+  const uint8_t* px = (const uint8_t*)d->pPixels;
+  for (int y = 0; y < d->iHeight && d->y + y < motion_th; y++){
+    int w = min<int>(d->iWidth, motion_tw - d->x);
+    if (w > 0) memcpy(motion_thumb[0] + (size_t)(d->y + y) * motion_tw + d->x, px + (size_t)y * d->iWidth, w);
+  }
+  return 1;
+}
+
+static void motion_emit(uint8_t type, uint32_t seq, int64_t ts, uint16_t score){
+  portENTER_CRITICAL(&motionMux);
+  uint32_t id = ++MD.events;
+  MD.ev[(id - 1) % MOTION_EVENTS] = { id, type, seq, ts, score };
+  MD.ev_count[type]++;
+  portEXIT_CRITICAL(&motionMux);
+  LOGI(TAG, "motion: %s (score %u, seq %u)", MOTION_EVT_NAME[type], score, (unsigned)seq);
+}
+
+static void motion_task(void*){
+  uint32_t last_seq = 0;
+  int64_t  next = 0, last_motion = 0, last_scene = -MOTION_SCENE_HOLD_MS * 1000LL;
+  bool     have_prev = false;
+  for (;;){
+    if (!S.md || !cam_ready){
+      MD.active = false; MD.state = MS_UNKNOWN; have_prev = false;
+      vTaskDelay(pdMS_TO_TICKS(200));
+      continue;
+    }
+    int64_t now = esp_timer_get_time();
+    if (now < next){ vTaskDelay(pdMS_TO_TICKS((next - now) / 1000 + 1)); continue; }
+    FrameSlot* f = frames.acquireLatest(last_seq);
+    if (!f){ vTaskDelay(pdMS_TO_TICKS(20)); continue; }
+    last_seq = f->seq;
+
+    uint16_t tw = (f->width + 7) / 8, th = (f->height + 7) / 8;
+    if (!motion_dec){
+      motion_dec = new (std::nothrow) JPEGDEC;
+      for (auto& t : motion_thumb) if (!t) t = (uint8_t*)heap_caps_malloc(MOTION_THUMB_MAX, MALLOC_CAP_8BIT);
+      if (!motion_dec || !motion_thumb[0] || !motion_thumb[1]){
+        LOGE(TAG, "motion buffers alloc failed");
+        delete motion_dec; motion_dec = nullptr;
+        frames.release(f);
+        vTaskDelay(pdMS_TO_TICKS(5000));
+        continue;
+      }
+    }
+    if ((size_t)tw * th > MOTION_THUMB_MAX){ frames.release(f); vTaskDelay(pdMS_TO_TICKS(200)); continue; }
+    if (tw != motion_tw || th != motion_th){ motion_tw = tw; motion_th = th; have_prev = false; }
+    size_t n = ((size_t)tw * th + 3) & ~(size_t)3;               // whole words; pad bytes stay equal
+    memset(motion_thumb[0] + (size_t)tw * th, 0, n - (size_t)tw * th);
+
+    TRACE_BEGIN(t_md);
+    int64_t t0 = esp_timer_get_time();
+    bool ok = false;
+    if (motion_dec->openRAM(f->buf, (int)f->len, motion_draw)){
+      motion_dec->setPixelType(EIGHT_BIT_GRAYSCALE);
+      ok = motion_dec->decode(0, 0, JPEG_SCALE_EIGHTH);
+      motion_dec->close();
+    }
+    uint32_t seq = f->seq; int64_t ts = f->ts_us;
+    frames.release(f);
+    int64_t t1 = esp_timer_get_time();
+    MotionDiff d = {};
+    if (ok && have_prev) d = motion_diff_swar(motion_thumb[0], motion_thumb[1], n, MOTION_NOISE);
+    int64_t t2 = esp_timer_get_time();
+    TRACE_END("motion", t_md, seq);
+    next = t0 + max<int64_t>(1000000 / MOTION_MAX_HZ, (t2 - t0) * 100 / MOTION_BUDGET_PCT);
+    if (!ok){ have_prev = false; continue; }
+
+    std::swap(motion_thumb[0], motion_thumb[1]);
+    MD.w = tw; MD.h = th; MD.decode_us = (uint32_t)(t1 - t0); MD.diff_us = (uint32_t)(t2 - t1); MD.active = true;
+    if (!have_prev){ have_prev = true; if (!last_motion) last_motion = ts; continue; }
+
+    uint32_t px      = (uint32_t)tw * th;
+    uint16_t changed = (uint16_t)((uint64_t)d.changed * 1000 / px);
+    portENTER_CRITICAL(&motionMux);
+    MD.hist[MD.scores++ % MOTION_HIST] = { seq, ts, changed, (uint16_t)((uint64_t)d.sad * 10 / px) };
+    portEXIT_CRITICAL(&motionMux);
+
+    if (changed >= S.md_thr){
+      last_motion = ts;
+      if (MD.state != MS_MOVING){ MD.state = MS_MOVING; motion_emit(ME_MOTION, seq, ts, changed); }
+    } else if (MD.state != MS_STILL && ts - last_motion >= S.md_still_s * 1000000LL){
+      MD.state = MS_STILL; motion_emit(ME_STILL, seq, ts, changed);
+    }
+    if (changed >= S.md_jump && ts - last_scene >= MOTION_SCENE_HOLD_MS * 1000LL){
+      last_scene = ts; motion_emit(ME_SCENE, seq, ts, changed);
+    }
+  }
+}
+
+// -------------------- HTTP: static UI assets (pre-gzipped) --------------------
+// Strong ETag per asset: a matching If-None-Match gets an empty 304, anything
+// else the gzip body straight from flash (every browser sends Accept-Encoding: gzip).
+static bool etagMatches(const char* etag){
+  if (!server.hasHeader("If-None-Match")) return false;
+  String inm = server.header("If-None-Match");
+  return inm == "*" || inm.indexOf(etag) >= 0;
+}
+
+static void serveAsset(const WebAsset& a){
+  server.sendHeader("ETag", a.etag);
+  server.sendHeader("Cache-Control", a.cache);
+  if (etagMatches(a.etag)){ server.send(304); return; }
+  server.sendHeader("Content-Encoding", "gzip");
+  server.sendHeader("Vary", "Accept-Encoding");
+  server.send_P(200, a.mime, (PGM_P)a.gz, a.gz_len);
+}
+
+// -------------------- HTTP: chunked output --------------------
+// Large text responses are formatted into a stack buffer and sent as chunks;
+// no String building, no heap. Templated pages (tmpl.h) use an MSS-sized
+// buffer so a full chunk plus its size line and CRLF fits one TCP segment.
+#define HTTP_CHUNK (STREAM_TCP_MSS - 8)
+
+template <size_t CAP>
+struct ChunkedBuf {
+  char   buf[CAP];
+  size_t n = 0;
+  void flush(){ if (n){ server.sendContent(buf, n); n = 0; } }
+  void write(const char* p, size_t len){
+    while (len){
+      if (n == CAP) flush();
+      size_t k = min(CAP - n, len);
+      memcpy(buf + n, p, k);
+      n += k; p += k; len -= k;
+    }
+  }
+  void puts(const char* s){ write(s, strlen(s)); }
+  // Format straight into the buffer; if it does not fit, flush and retry once.
+  void printf(const char* fmt, ...) __attribute__((format(printf, 2, 3))){
+    for (int pass = 0; pass < 2; pass++){
+      va_list ap; va_start(ap, fmt);
+      int l = vsnprintf(buf + n, CAP - n, fmt, ap);
+      va_end(ap);
+      if (l < 0) return;
+      if (n + l < CAP){ n += l; return; }
+      if (!n){ n = CAP - 1; break; }                 // longer than the buffer: truncated
+      flush();
+    }
+    flush();
+  }
+};
+typedef ChunkedBuf<512>        ChunkedOut;           // /metrics, /trace, /motion, ...
+typedef ChunkedBuf<HTTP_CHUNK> PageOut;              // tmpl_render() pages
+
+// -------------------- Settings field table (form, JSON API, WebSocket) --------------------
+enum FieldKind : uint8_t { F_INT, F_BOOL, F_FS, F_ROT };
+struct SettingField {
+  const char* key;
+  FieldKind   kind;
+  uint8_t     size;
+  uint16_t    off;
+  int16_t     lo, hi;
+};
+#define SETTING(k, kind, m, lo, hi) { k, kind, sizeof(CamSettings::m), offsetof(CamSettings, m), lo, hi }
+static const SettingField SETTING_FIELDS[] = {
+  SETTING("fs",        F_FS,   fs,         0, 0),
+  SETTING("q",         F_INT,  jpeg_q,     10, 30),
+  SETTING("rot",       F_ROT,  rot,        0, 180),
+  SETTING("bri",       F_INT,  brightness, -2, 2),
+  SETTING("con",       F_INT,  contrast,   -2, 2),
+  SETTING("sat",       F_INT,  saturation, -2, 2),
+  SETTING("ae",        F_INT,  ae_level,   -2, 2),
+  SETTING("awb",       F_BOOL, awb,        0, 1),
+  SETTING("aec",       F_BOOL, aec,        0, 1),
+  SETTING("agc",       F_BOOL, agc,        0, 1),
+  SETTING("abr",       F_BOOL, abr,        0, 1),
+  SETTING("abr_fps",   F_INT,  abr_fps,    1, 30),
+  SETTING("abr_qmax",  F_INT,  abr_qmax,   10, 63),
+  SETTING("abr_fsmin", F_FS,   abr_fsmin,  0, 0),
+  SETTING("tft_pv",    F_BOOL, tft_pv,     0, 1),
+  SETTING("tft_fps",   F_INT,  tft_fps,    1, 15),
+  SETTING("clip_kb",   F_INT,  clip_kb,    0, CLIP_MAX_KB),
+  SETTING("clip_fps",  F_INT,  clip_fps,   1, 30),
+  SETTING("md",        F_BOOL, md,         0, 1),
+  SETTING("md_thr",    F_INT,  md_thr,     1, 1000),
+  SETTING("md_still_s",F_INT,  md_still_s, 1, 600),
+  SETTING("md_jump",   F_INT,  md_jump,    1, 1000),
+  SETTING("tl_s",      F_INT,  tl_s,       0, 3600),
+  SETTING("tl_kb",     F_INT,  tl_kb,      0, TL_MAX_KB),
+};
+static const int SETTING_FIELD_N = sizeof(SETTING_FIELDS) / sizeof(SETTING_FIELDS[0]);
+
+static const SettingField* setting_find(const char* k, size_t kl){
+  for (int i=0;i<SETTING_FIELD_N;i++)
+    if (strlen(SETTING_FIELDS[i].key) == kl && !memcmp(SETTING_FIELDS[i].key, k, kl)) return &SETTING_FIELDS[i];
+  return nullptr;
+}
+static int setting_get(const CamSettings& cs, const SettingField& f){
+  const uint8_t* p = (const uint8_t*)&cs + f.off;
+  if (f.size == 2) return *(const uint16_t*)p;
+  return f.lo < 0 ? (int)*(const int8_t*)p : (int)*p;
+}
+static void setting_set(CamSettings& cs, const SettingField& f, int v){
+  uint8_t* p = (uint8_t*)&cs + f.off;
+  if (f.size == 2) *(uint16_t*)p = (uint16_t)v;
+  else *p = (uint8_t)v;
+}
+
+// -------------------- HTTP: settings (HTML form UI) --------------------
+// The form page: every {{placeholder}} is a SETTING_FIELDS key.
+//   {{key}}       current value (framesize name, else the number)
+//   {{key=v}}     " selected" when the value is v
+//   {{opts:key}}  <option> list of the framesize ladder, current one selected
+static const char SETTINGS_HTML[] PROGMEM =
+  "<!doctype html><html><head><meta charset=utf-8>"
+  "<meta name=viewport content='width=device-width,initial-scale=1'>"
+  "<title>NozzleCAM Settings</title>"
+  "<style>body{font-family:system-ui;margin:1rem;background:#111;color:#eee}"
+  "label{display:block;margin:.5rem 0 .2rem}input,select,button{font:inherit;padding:.4rem .5rem;border-radius:.4rem;border:1px solid #444;background:#1a1a1a;color:#eee}"
+  "form{max-width:560px} fieldset{border:1px solid #333;border-radius:.6rem;padding:1rem;margin-bottom:1rem}"
+  "legend{padding:0 .4rem} .row{display:flex;gap:.6rem} .row>div{flex:1}</style>"
+  "</head><body><h2>NozzleCAM Settings</h2>"
+  "<form method='POST' action='/settings'>"
+    "<fieldset><legend>Image</legend>"
+      "<label>Frame size</label>"
+      "<select name='fs'>{{opts:fs}}</select>"
+      "<label>JPEG quality (lower=better)</label>"
+      "<input type='number' min='10' max='30' name='q' value='{{q}}'>"
+      "<label>Rotation</label>"
+      "<select name='rot'>"
+        "<option value='0'{{rot=0}}>0°</option>"
+        "<option value='180'{{rot=180}}>180°</option>"
+      "</select>"
+    "</fieldset>"
+    "<fieldset><legend>Tuning</legend>"
+      "<div class='row'>"
+        "<div><label>Brightness</label><input type='number' min='-2' max='2' name='bri' value='{{bri}}'></div>"
+        "<div><label>Contrast</label><input type='number' min='-2' max='2' name='con' value='{{con}}'></div>"
+      "</div>"
+      "<div class='row'>"
+        "<div><label>Saturation</label><input type='number' min='-2' max='2' name='sat' value='{{sat}}'></div>"
+        "<div><label>AE Level</label><input type='number' min='-2' max='2' name='ae' value='{{ae}}'></div>"
+      "</div>"
+      "<div class='row'>"
+        "<div><label>AWB</label><select name='awb'><option value='1'{{awb=1}}>On</option><option value='0'{{awb=0}}>Off</option></select></div>"
+        "<div><label>AEC</label><select name='aec'><option value='1'{{aec=1}}>On</option><option value='0'{{aec=0}}>Off</option></select></div>"
+        "<div><label>AGC</label><select name='agc'><option value='1'{{agc=1}}>On</option><option value='0'{{agc=0}}>Off</option></select></div>"
+      "</div>"
+    "</fieldset>"
+    "<fieldset><legend>Adaptive bitrate</legend>"
+      "<div class='row'>"
+        "<div><label>ABR</label><select name='abr'><option value='1'{{abr=1}}>On</option><option value='0'{{abr=0}}>Off</option></select></div>"
+        "<div><label>Target fps</label><input type='number' min='1' max='30' name='abr_fps' value='{{abr_fps}}'></div>"
+      "</div>"
+      "<div class='row'>"
+        "<div><label>Worst quality</label><input type='number' min='10' max='63' name='abr_qmax' value='{{abr_qmax}}'></div>"
+        "<div><label>Smallest size</label><select name='abr_fsmin'>{{opts:abr_fsmin}}</select></div>"
+      "</div>"
+    "</fieldset>"
+    "<fieldset><legend>TFT preview</legend>"
+      "<div class='row'>"
+        "<div><label>Live preview</label><select name='tft_pv'><option value='1'{{tft_pv=1}}>On</option><option value='0'{{tft_pv=0}}>Off</option></select></div>"
+        "<div><label>Max fps</label><input type='number' min='1' max='15' name='tft_fps' value='{{tft_fps}}'></div>"
+      "</div>"
+    "</fieldset>"
+    "<fieldset><legend>Pre-event clip (/clip)</legend>"
+      "<div class='row'>"
+        "<div><label>Buffer KB (0=off)</label><input type='number' min='0' max='6144' name='clip_kb' value='{{clip_kb}}'></div>"
+        "<div><label>Frames/s kept</label><input type='number' min='1' max='30' name='clip_fps' value='{{clip_fps}}'></div>"
+      "</div>"
+    "</fieldset>"
+    "<fieldset><legend>Motion detection (/motion)</legend>"
+      "<div class='row'>"
+        "<div><label>Motion metric</label><select name='md'><option value='1'{{md=1}}>On</option><option value='0'{{md=0}}>Off</option></select></div>"
+        "<div><label>Motion at ‰ changed</label><input type='number' min='1' max='1000' name='md_thr' value='{{md_thr}}'></div>"
+      "</div>"
+      "<div class='row'>"
+        "<div><label>Still after s</label><input type='number' min='1' max='600' name='md_still_s' value='{{md_still_s}}'></div>"
+        "<div><label>Scene change at ‰</label><input type='number' min='1' max='1000' name='md_jump' value='{{md_jump}}'></div>"
+      "</div>"
+    "</fieldset>"
+    "<fieldset><legend>Timelapse (/trigger, /timelapse)</legend>"
+      "<div class='row'>"
+        "<div><label>Interval s (0=trigger only)</label><input type='number' min='0' max='3600' name='tl_s' value='{{tl_s}}'></div>"
+        "<div><label>Store KB (0=off)</label><input type='number' min='0' max='4096' name='tl_kb' value='{{tl_kb}}'></div>"
+      "</div>"
+    "</fieldset>"
+    "<p><button type='submit'>Apply & Save</button> <a href='/' style='margin-left:.6rem'>Back to UI</a></p>"
+  "</form>"
+  "<p style='opacity:.7'>Current: fs={{fs}} q={{q}} rot={{rot}} bri={{bri}} con={{con}} sat={{sat}} ae={{ae}} awb={{awb}} aec={{aec}} agc={{agc}}</p>"
+  "</body></html>";
+
+// Setting value as form text: framesize name or plain number.
+static int setting_text(char* out, size_t n, const SettingField& f, int v){
+  if (f.kind == F_FS) return snprintf(out, n, "%s", framesizeName((framesize_t)v));
+  return snprintf(out, n, "%d", v);
+}
+
+static void fsOptions(PageOut& o, uint8_t sel){
+  for (int i=0;i<FS_LADDER_N;i++){
+    const char* nm = framesizeName(FS_LADDER[i]);
+    o.printf("<option value='%s'%s>%s</option>", nm, ((uint8_t)FS_LADDER[i]==sel)?" selected":"", nm);
+  }
+}
+
+static void settings_fill(PageOut& o, const char* k, size_t kl){
+  bool opts = kl > 5 && !memcmp(k, "opts:", 5);
+  if (opts){ k += 5; kl -= 5; }
+  const char* eq = (const char*)memchr(k, '=', kl);
+  const SettingField* f = setting_find(k, eq ? (size_t)(eq - k) : kl);
+  if (!f){ LOGW(TAG, "/settings: unknown placeholder %.*s", (int)kl, k); return; }
+  int  v = setting_get(S, *f);
+  char t[16];
+  int  tl = setting_text(t, sizeof(t), *f, v);
+  if (opts) fsOptions(o, (uint8_t)v);
+  else if (!eq) o.write(t, tl);
+  else if ((size_t)tl == kl - (eq - k) - 1 && !memcmp(t, eq + 1, tl)) o.puts(" selected");
+}
+
+// Rendered straight into MSS-sized chunks; the page never exists in RAM whole.
+static void sendSettingsPage(){
+  PageOut o;
+  server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+  server.send(200, "text/html", "");
+  tmpl_render(o, SETTINGS_HTML, settings_fill);
+  o.flush();
+}
+static void handleSettingsGet(){ sendSettingsPage(); }
+
+static void handleSettingsPost(){
+  String fs  = server.arg("fs");
+  String q   = server.arg("q");
+  String bri = server.arg("bri");
+  String con = server.arg("con");
+  String sat = server.arg("sat");
+  String ae  = server.arg("ae");
+  String awb = server.arg("awb");
+  String aec = server.arg("aec");
+  String agc = server.arg("agc");
+  String rot = server.arg("rot");
+  String abr = server.arg("abr");
+
+  S.fs         = (uint8_t)fsFromStr(fs);
+  S.jpeg_q     = (uint8_t)clampi(q.toInt(),    10, 30);
+  S.brightness = (int8_t)clampi(bri.toInt(),   -2,  2);
+  S.contrast   = (int8_t)clampi(con.toInt(),   -2,  2);
+  S.saturation = (int8_t)clampi(sat.toInt(),   -2,  2);
+  S.ae_level   = (int8_t)clampi(ae.toInt(),    -2,  2);
+  S.awb        = (awb=="1");
+  S.aec        = (aec=="1");
+  S.agc        = (agc=="1");
+  S.rot        = parseRot(rot);  // 0 of 180
+  S.abr        = (abr=="1");
+  S.abr_fps    = (uint8_t)clampi(server.arg("abr_fps").toInt(),  1, 30);
+  S.abr_qmax   = (uint8_t)clampi(server.arg("abr_qmax").toInt(), 10, 63);
+  S.abr_fsmin  = (uint8_t)fsFromStr(server.arg("abr_fsmin"));
+  S.tft_pv     = (server.arg("tft_pv")=="1");
+  S.tft_fps    = (uint8_t)clampi(server.arg("tft_fps").toInt(), 1, 15);
+  S.clip_kb    = (uint16_t)clampi(server.arg("clip_kb").toInt(), 0, CLIP_MAX_KB);
+  S.clip_fps   = (uint8_t)clampi(server.arg("clip_fps").toInt(), 1, 30);
+  S.md         = (server.arg("md")=="1");
+  S.md_thr     = (uint16_t)clampi(server.arg("md_thr").toInt(), 1, 1000);
+  S.md_still_s = (uint16_t)clampi(server.arg("md_still_s").toInt(), 1, 600);
+  S.md_jump    = (uint16_t)clampi(server.arg("md_jump").toInt(), 1, 1000);
+  S.tl_s       = (uint16_t)clampi(server.arg("tl_s").toInt(), 0, 3600);
+  S.tl_kb      = (uint16_t)clampi(server.arg("tl_kb").toInt(), 0, TL_MAX_KB);
+
+  camera_apply_live();
+  settings_changed();
+
+  server.sendHeader("Location", "/settings", true);
+  server.send(303, "text/plain", "");
+}
+
+// -------------------- HTTP: JSON API for settings --------------------
+// Settings by SETTING_FIELDS key (booleans as 0/1), runtime state as whole
+// objects filled by api_fill().
+static const char API_SETTINGS_JSON[] PROGMEM =
+  "{"
+    "\"fs\":\"{{fs}}\",\"q\":{{q}},"
+    "\"rot\":{{rot}},"
+    "\"bri\":{{bri}},\"con\":{{con}},\"sat\":{{sat}},\"ae\":{{ae}},"
+    "\"awb\":{{awb}},\"aec\":{{aec}},\"agc\":{{agc}},"
+    "\"abr\":{{abr}},\"abr_fps\":{{abr_fps}},\"abr_qmax\":{{abr_qmax}},\"abr_fsmin\":\"{{abr_fsmin}}\","
+    "\"tft_pv\":{{tft_pv}},\"tft_fps\":{{tft_fps}},\"clip_kb\":{{clip_kb}},\"clip_fps\":{{clip_fps}},"
+    "\"md\":{{md}},\"md_thr\":{{md_thr}},\"md_still_s\":{{md_still_s}},\"md_jump\":{{md_jump}},"
+    "\"tl_s\":{{tl_s}},\"tl_kb\":{{tl_kb}},"
+    "\"rate\":{{rate}},"
+    "\"preview\":{{preview}},"
+    "\"clip\":{{clip}},"
+    "\"fs_switch\":{{fs_switch}},"
+    "\"store\":{{store}}"
+  "}";
+
+static void api_fill(PageOut& o, const char* k, size_t kl){
+  auto is = [&](const char* name){ return strlen(name) == kl && !memcmp(k, name, kl); };
+  if (const SettingField* f = setting_find(k, kl)){
+    char t[16];
+    o.write(t, setting_text(t, sizeof(t), *f, setting_get(S, *f)));
+  } else if (is("rate")){
+    o.printf("{\"state\":\"%s\",\"fs\":\"%s\",\"q\":%u,\"fps\":%.1f,\"send_ms\":%.1f,\"pending\":%u,\"lat_ms\":%.1f}",
+             R.state, framesizeName((framesize_t)R.fs), R.q, R.fps_x10 / 10.0,
+             R.send_us / 1000.0, (unsigned)R.pending, R.lat_us / 1000.0);
+  } else if (is("preview")){
+    o.printf("{\"active\":%d,\"frames\":%u,\"ms\":%.1f,\"scale\":\"1/%u\"}",
+             PV.active, (unsigned)PV.frames, PV.cost_us / 1000.0, (unsigned)max<uint8_t>(PV.div, 1));
+  } else if (is("clip")){
+    ClipRing::Stats cs = clips.stats();
+    o.printf("{\"frames\":%u,\"seconds\":%.1f,\"used_kb\":%u,\"dropped\":%u,\"busy\":%d}",
+             (unsigned)cs.frames, (cs.newest_us - cs.oldest_us) / 1e6, (unsigned)(cs.bytes / 1024), (unsigned)cs.dropped, clip_busy);
+  } else if (is("fs_switch")){
+    o.printf("{\"last_ms\":%.1f,\"max_ms\":%.1f,\"count\":%u,\"dropped\":%u,\"timeouts\":%u,\"pending\":%d}",
+             SW.last_us / 1000.0, SW.max_us / 1000.0, (unsigned)SW.count, (unsigned)SW.dropped, (unsigned)SW.timeouts, SW.pending);
+  } else if (is("store")){
+    o.printf("{\"version\":%u,\"changes\":%u,\"commits\":%u,\"pending\":%d}",
+             SETTINGS_VERSION, (unsigned)settings_gen, (unsigned)settings_commits, settings_gen != settings_saved);
+  } else {
+    LOGW(TAG, "/api/settings: unknown placeholder %.*s", (int)kl, k);
+  }
+}
+
+static void handleApiGet(){
+  PageOut o;
+  server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+  server.send(200, "application/json", "");
+  tmpl_render(o, API_SETTINGS_JSON, api_fill);
+  o.flush();
+}
+// PATCH semantics: only members present in the body change. The body is read
+// in one pass by json_object_each() (no String per key, no rescans) into a
+// copy of S; a bad member rejects the whole request with its byte offset, and
+// nothing is applied. null resets a field to its default. The reply lists what
+// actually changed as "key":[old,new].
+// Parse one member into `cs`; nullptr or an error message.
+static const char* setting_parse(CamSettings& cs, const SettingField& f, const JsonVal& v){
+  static CamSettings defs;
+  static bool        have_defs = false;
+  if (v.type == JsonVal::NUL){
+    if (!have_defs){ setDefaults(defs); have_defs = true; }
+    setting_set(cs, f, setting_get(defs, f));
+    return nullptr;
+  }
+  switch (f.kind){
+    case F_FS:
+      if (v.type != JsonVal::STR) return "expected framesize name";
+      for (int i=0;i<FS_LADDER_N;i++){
+        const char* name = framesizeName(FS_LADDER[i]);
+        if (strlen(name) == v.len && !strncasecmp(name, v.s, v.len)){ setting_set(cs, f, FS_LADDER[i]); return nullptr; }
+      }
+      return "unknown framesize (QQVGA, QVGA, VGA, SVGA, XGA, SXGA, UXGA)";
+    case F_BOOL:
+      if (v.type == JsonVal::BOOL || (v.type == JsonVal::NUM && v.is_int && (v.i == 0 || v.i == 1))){ setting_set(cs, f, (int)v.i); return nullptr; }
+      return "expected true/false (or 0/1)";
+    case F_ROT:
+      if (v.type == JsonVal::NUM && v.is_int && (v.i == 0 || v.i == 180)){ setting_set(cs, f, (int)v.i); return nullptr; }
+      return "expected 0 or 180";
+    case F_INT:
+      if (v.type != JsonVal::NUM || !v.is_int) return "expected integer";
+      if (v.i < f.lo || v.i > f.hi) return "out of range";
+      setting_set(cs, f, (int)v.i);
+      return nullptr;
+  }
+  return "unsupported";
+}
+
+static int setting_fmt(char* out, size_t n, const SettingField& f, int v){
+  if (f.kind == F_FS)   return snprintf(out, n, "\"%s\"", framesizeName((framesize_t)v));
+  if (f.kind == F_BOOL) return snprintf(out, n, "%s", v ? "true" : "false");
+  return snprintf(out, n, "%d", v);
+}
+
+static void handleApiPost(){
+  if (!server.hasArg("plain")){ handleSettingsPost(); return; }
+  String body = server.arg("plain");                // WebServer's copy; parsing allocates nothing more
+  CamSettings next = S;
+  JsonErr err = {};
+  bool ok = json_object_each(body.c_str(), body.length(), [&](const char* k, size_t kl, const JsonVal& v) -> const char* {
+    const SettingField* f = setting_find(k, kl);
+    return f ? setting_parse(next, *f, v) : "unknown setting";
+  }, &err);
+
+  char buf[640];
+  if (!ok){
+    int n = snprintf(buf, sizeof(buf), "{\"ok\":false,\"error\":\"%s\",\"pos\":%u", err.msg, (unsigned)err.pos);
+    if (const SettingField* f = err.key ? setting_find(err.key, err.klen) : nullptr){
+      n += snprintf(buf + n, sizeof(buf) - n, ",\"key\":\"%s\"", f->key);
+      if (f->kind == F_INT) n += snprintf(buf + n, sizeof(buf) - n, ",\"min\":%d,\"max\":%d", f->lo, f->hi);
+    } else if (err.key && err.klen <= 32){                  // unknown name: echo it if it is plain
+      size_t k = 0;
+      while (k < err.klen && (isalnum((unsigned char)err.key[k]) || err.key[k] == '_')) k++;
+      if (k == err.klen) n += snprintf(buf + n, sizeof(buf) - n, ",\"key\":\"%.*s\"", (int)k, err.key);
+    }
+    snprintf(buf + n, sizeof(buf) - n, "}");
+    server.send(400, "application/json", buf);
+    return;
+  }
+
+  int n = snprintf(buf, sizeof(buf), "{\"ok\":true,\"applied\":{");
+  bool changed = false;
+  for (int i=0;i<SETTING_FIELD_N;i++){
+    const SettingField& f = SETTING_FIELDS[i];
+    int a = setting_get(S, f), b = setting_get(next, f);
+    if (a == b) continue;
+    n += snprintf(buf + n, sizeof(buf) - n, "%s\"%s\":[", changed ? "," : "", f.key);
+    n += setting_fmt(buf + n, sizeof(buf) - n, f, a);
+    n += snprintf(buf + n, sizeof(buf) - n, ",");
+    n += setting_fmt(buf + n, sizeof(buf) - n, f, b);
+    n += snprintf(buf + n, sizeof(buf) - n, "]");
+    changed = true;
+  }
+  snprintf(buf + n, sizeof(buf) - n, "}}");
+  if (changed){
+    S = next;
+    camera_apply_live();
+    settings_changed();
+  }
+  server.send(200, "application/json", buf);
+}
+
+// -------------------- HTTP: health / reinit / jpg / stream --------------------
+// Passive: answered from the health monitor and the capture task's counters,
+// so polling it never takes a frame from a viewer. 500 while the camera is
+// down (or not up yet); the outage history comes along.
+static void handleHealth(){
+  HealthMon h;
+  portENTER_CRITICAL(&hwMux);
+  h = HW;
+  portEXIT_CRITICAL(&hwMux);
+  int64_t now = esp_timer_get_time(), last = cap_last_us;
+  bool    ok  = cam_ready && !h.down && last && now - last < HW_STALL_MS * 1000LL;
+  int64_t out = h.down ? now - h.cur.t0_us : 0;
+
+  ChunkedOut o;
+  server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+  server.send(ok ? 200 : 500, "application/json", "");
+  o.printf("{\"ok\":%s,\"state\":\"%s\",\"cause\":", ok ? "true" : "false",
+           ok ? "ok" : h.down ? "down" : last ? "stalling" : "starting");
+  if (h.down) o.printf("\"%s\"", HW_CAUSES[h.cur.cause]); else o.printf("null");
+  o.printf(",\"frame_age_ms\":%.1f,\"free_int\":%u,\"free_psram\":%u,\"seq\":%u,\"cap_drops\":%u,\"cap_fps\":%.1f,"
+           "\"fb_null\":%u,\"outages\":%u,\"recoveries\":%u,\"init_failures\":%u,\"outage_ms\":%.0f,\"downtime_s\":%.1f,\"stack_free\":%u,\"history\":[",
+           last ? (now - last) / 1000.0 : -1.0,
+           (unsigned)heap_caps_get_free_size(MALLOC_CAP_8BIT | MALLOC_CAP_INTERNAL),
+           (unsigned)heap_caps_get_free_size(MALLOC_CAP_SPIRAM),
+           (unsigned)frames.latestSeq(), (unsigned)cap_drops, cap_fps_x10 / 10.0,
+           (unsigned)m_fb_null, (unsigned)h.outages, (unsigned)h.attempts, (unsigned)h.init_fails,
+           out / 1000.0, (h.down_us + out) / 1e6, (unsigned)h.stack_free);
+  uint32_t first = h.resolved > HW_HIST ? h.resolved - HW_HIST : 0;
+  for (uint32_t i = h.resolved; i-- > first;){                    // newest first
+    const Outage& e = h.hist[i % HW_HIST];
+    o.printf("%s{\"cause\":\"%s\",\"at_s\":%.1f,\"down_ms\":%.0f,\"recoveries\":%u}",
+             i + 1 == h.resolved ? "" : ",", HW_CAUSES[e.cause], e.t0_us / 1e6, (e.t1_us - e.t0_us) / 1000.0, e.attempts);
+  }
+  o.printf("]}");
+  o.flush();
+}
+static void handleReinit(){
+  bool ok = camera_reinit();
+  server.send(ok?200:500, "text/plain", ok ? "reinit ok" : "reinit failed");
+}
+
+// -------------------- HTTP: /jpg (shared snapshot cache) --------------------
+// Pollers (OctoPrint, Home Assistant) hit /jpg several times a second. The
+// newest ring frame is copied once per new seq into a PSRAM snapshot and every
+// request is answered from that copy, so a slow poller never pins a ring slot
+// the capture task wants back. The ETag is boot id + frame seq: an unchanged
+// frame gets an empty 304. ?max_age_ms=N waits (up to JPG_WAIT_MS) for a frame
+// captured at most N ms before the request; 0 = the next frame.
+// Only loop() touches the cache, so it needs no lock. loop() never waits: a
+// request the cache cannot answer yet is detached to a jpg_wait_task, which
+// sleeps on the capture notification and sends the frame from the ring.
+#define JPG_WAIT_MS 2000
+
+struct SnapCache {
+  uint8_t* buf;
+  size_t   cap, len;
+  uint32_t seq;                                       // 0 = empty
+  int64_t  ts_us;
+  uint16_t w, h;
+  char     etag[24];
+  uint32_t fills, ok, not_modified, timeouts;        // responses: loop() and waiters, under snapMux
+};
+static SnapCache    snap = {};
+static portMUX_TYPE snapMux = portMUX_INITIALIZER_UNLOCKED;
+static uint32_t  boot_id = 0;                         // ETags of an earlier boot never match
+
+// Copy the ring's newest frame if it is newer than the cached one.
+static bool snap_refresh(){
+  FrameSlot* f = frames.acquireLatest(snap.seq);
+  if (!f) return snap.seq != 0;
+  if (snap.cap < f->len){
+    size_t cap = f->len + f->len / 4;
+    uint8_t* nb = (uint8_t*)heap_caps_malloc(cap, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    if (!nb){ frames.release(f); return snap.seq != 0; }
+    heap_caps_free(snap.buf);
+    snap.buf = nb; snap.cap = cap;
+  }
+  TRACE_BEGIN(t_cp);
+  memcpy(snap.buf, f->buf, f->len);
+  snap.len = f->len; snap.seq = f->seq; snap.ts_us = f->ts_us; snap.w = f->width; snap.h = f->height;
+  frames.release(f);
+  TRACE_END("jpg_snap", t_cp, snap.len);
+  snprintf(snap.etag, sizeof(snap.etag), "\"%08x-%u\"", (unsigned)boot_id, (unsigned)snap.seq);
+  snap.fills++;
+  return true;
+}
+
+static void snap_count(uint32_t& c){
+  portENTER_CRITICAL(&snapMux);
+  c++;
+  portEXIT_CRITICAL(&snapMux);
+}
+
+// Gathered send of iov[0..cnt) or fail at the deadline. lwIP's sendmsg hands
+// all vectors to one tcp_write pass, so header + JPEG + trailer fill MSS-sized
+// segments straight from the PSRAM slot instead of each write starting its own.
+// With a frame `*budget` (absolute time, 0 once used), `*pending` grows by the
+// bytes still unsent when it runs out: a ~5.7 KB lwIP send buffer never takes
+// a whole JPEG at once, but a healthy link drains it well inside the budget.
+// `*calls`/`*segs` count sendmsg calls and the MSS segments they produced.
+static bool sock_sendv_all(int fd, struct iovec* iov, int cnt, int64_t deadline_us, int64_t* budget,
+                           uint32_t* pending, uint32_t* calls, uint32_t* segs){
+  while (cnt){
+    struct msghdr m = {};
+    m.msg_iov = iov; m.msg_iovlen = cnt;
+    ssize_t n = sendmsg(fd, &m, MSG_DONTWAIT | MSG_NOSIGNAL);
+    if (n > 0){
+      (*calls)++;
+      *segs += (n + STREAM_TCP_MSS - 1) / STREAM_TCP_MSS;
+      while (cnt && (size_t)n >= iov->iov_len){ n -= iov->iov_len; iov++; cnt--; }
+      if (cnt){ iov->iov_base = (uint8_t*)iov->iov_base + n; iov->iov_len -= n; }
+    }
+    else if (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) return false;
+    if (!cnt) break;
+
+    int64_t now = esp_timer_get_time();
+    if (budget && *budget && now >= *budget){ for (int i=0;i<cnt;i++) *pending += iov[i].iov_len; *budget = 0; }
+    if (now >= deadline_us) return false;
+    int64_t until = (budget && *budget) ? min(*budget, deadline_us) : deadline_us;
+    int64_t left  = until - now;
+    fd_set wf; FD_ZERO(&wf); FD_SET(fd, &wf);
+    struct timeval tv = { (time_t)(left / 1000000), (suseconds_t)(left % 1000000) };
+    int r = select(fd + 1, nullptr, &wf, nullptr, &tv);
+    if (r < 0 || (r == 0 && until == deadline_us)) return false;   // timeout at the budget: count, keep going
+  }
+  return true;
+}
+
+struct JpgWait {
+  WiFiClient    client;
+  int64_t       oldest, until;
+  char          inm[48];                              // If-None-Match, for the 304
+  volatile bool busy;
+};
+static JpgWait jpgWait[JPG_WAITERS];
+
+// One detached /jpg: wait for a frame captured at or after `oldest`, answer
+// like handleJpg() straight from the ring slot, close.
+static void jpg_wait_task(void* arg){
+  JpgWait& w = *(JpgWait*)arg;
+  int      k = (int)(&w - jpgWait);
+  portENTER_CRITICAL(&streamsMux);
+  jpgWaiters[k] = xTaskGetCurrentTaskHandle();
+  portEXIT_CRITICAL(&streamsMux);
+  FrameSlot* f = nullptr;
+  uint32_t   seen = 0;
+  for (;;){
+    if ((f = frames.acquireLatest(seen))){
+      if (f->ts_us >= w.oldest) break;
+      seen = f->seq; frames.release(f); f = nullptr;
+    }
+    int64_t left = w.until - esp_timer_get_time();
+    if (left <= 0) break;
+    ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(left / 1000 + 1));
+  }
+  portENTER_CRITICAL(&streamsMux);
+  jpgWaiters[k] = nullptr;
+  portEXIT_CRITICAL(&streamsMux);
+
+  char hdr[320];
+  int  n;
+  if (!f){
+    snap_count(snap.timeouts);
+    const char* msg = seen ? "no frame that fresh" : "no frame";
+    n = snprintf(hdr, sizeof(hdr), "HTTP/1.1 504 Gateway Timeout\r\nContent-Type: text/plain\r\n"
+                 "Content-Length: %u\r\nConnection: close\r\n\r\n%s", (unsigned)strlen(msg), msg);
+  } else {
+    char etag[24];
+    snprintf(etag, sizeof(etag), "\"%08x-%u\"", (unsigned)boot_id, (unsigned)f->seq);
+    bool nm = w.inm[0] && (!strcmp(w.inm, "*") || strstr(w.inm, etag));
+    snap_count(nm ? snap.not_modified : snap.ok);
+    n = snprintf(hdr, sizeof(hdr), "HTTP/1.1 %s\r\nContent-Type: image/jpeg\r\nContent-Length: %u\r\nETag: %s\r\n"
+                 "Cache-Control: no-cache\r\nX-Timestamp: %u.%06u\r\nConnection: close\r\n\r\n",
+                 nm ? "304 Not Modified" : "200 OK", nm ? 0u : (unsigned)f->len, etag,
+                 (unsigned)(f->ts_us / 1000000), (unsigned)(f->ts_us % 1000000));
+    if (nm){ frames.release(f); f = nullptr; }
+  }
+  struct iovec iov[2] = { { hdr, (size_t)min<int>(n, sizeof(hdr) - 1) }, { f ? f->buf : nullptr, f ? f->len : 0 } };
+  uint32_t pending = 0, calls = 0, segs = 0;
+  if (sock_sendv_all(w.client.fd(), iov, f ? 2 : 1, esp_timer_get_time() + STREAM_SEND_TIMEOUT_S * 1000000LL, nullptr,
+                     &pending, &calls, &segs) && f) boot_served();
+  if (f) frames.release(f);
+  w.client.stop();
+  w.busy = false;
+  vTaskDelete(nullptr);
+}
+
+// Hand the current request to a free waiter; false if none is free.
+static bool jpg_wait_start(int64_t oldest, int64_t until){
+  JpgWait* w = nullptr;
+  for (auto& j : jpgWait) if (!j.busy){ w = &j; break; }
+  if (!w) return false;
+  w->busy   = true;
+  w->oldest = oldest;
+  w->until  = until;
+  snprintf(w->inm, sizeof(w->inm), "%s", server.hasHeader("If-None-Match") ? server.header("If-None-Match").c_str() : "");
+  w->client = server.detachClient();
+  if (!w->client){ w->busy = false; return true; }
+  if (xTaskCreatePinnedToCore(jpg_wait_task, "jpgwait", 4096, w, 1, nullptr, NET_CORE) != pdPASS){
+    LOGW(TAG, "jpgwait task alloc failed");
+    w->client.stop();
+    w->busy = false;
+  }
+  return true;
+}
+
+static void handleJpg(){
+  if (!cam_ready){ server.send(503, "text/plain", "cam not ready"); return; }
+  int64_t t_req  = esp_timer_get_time();
+  int64_t oldest = server.hasArg("max_age_ms") ? t_req - clampi(server.arg("max_age_ms").toInt(), 0, 3600000) * 1000LL
+                                               : INT64_MIN;   // any frame will do
+  int64_t until  = t_req + (server.hasArg("max_age_ms") ? JPG_WAIT_MS : 1000) * 1000LL;
+  if (!snap_refresh() || snap.ts_us < oldest){
+    if (jpg_wait_start(oldest, until)) return;
+    snap_count(snap.timeouts);                        // every waiter busy: do not block loop()
+    server.send(504, "text/plain", snap.seq ? "no frame that fresh" : "no frame");
+    return;
+  }
+
+  char ts[24];
+  snprintf(ts, sizeof(ts), "%u.%06u", (unsigned)(snap.ts_us / 1000000), (unsigned)(snap.ts_us % 1000000));
+  server.sendHeader("ETag", snap.etag);
+  server.sendHeader("Cache-Control", "no-cache");     // always revalidate: a 304 is cheap
+  server.sendHeader("X-Timestamp", ts);
+  if (etagMatches(snap.etag)){ snap_count(snap.not_modified); server.send(304); return; }
+  server.setContentLength(snap.len);
+  server.send(200, "image/jpeg", "");
+  TRACE_BEGIN(t_wr);
+  server.client().write((const uint8_t*)snap.buf, snap.len);
+  TRACE_END("jpg_write", t_wr, snap.len);
+  snap_count(snap.ok);
+  boot_served();
+}
+
+// /ws/stream binary message prefix, little-endian: u32 seq, u64 capture time
+// (us, esp_timer clock), u16 width, u16 height; the JPEG follows.
+static int ws_frame_prefix(uint8_t* p, const FrameSlot* f){
+  uint64_t ts = (uint64_t)f->ts_us;
+  for (int i=0;i<4;i++) p[i]     = (uint8_t)(f->seq >> (8 * i));
+  for (int i=0;i<8;i++) p[4 + i] = (uint8_t)(ts >> (8 * i));
+  p[12] = (uint8_t)f->width;  p[13] = (uint8_t)(f->width >> 8);
+  p[14] = (uint8_t)f->height; p[15] = (uint8_t)(f->height >> 8);
+  return WS_FRAME_HDR;
+}
+
+// Per-frame send stats: the rate controller's window and the lifetime counters.
+static void stream_account(StreamClient* sc, const FrameSlot* f, int64_t send_us, size_t total,
+                           uint32_t pending, uint32_t calls, uint32_t segs){
+  portENTER_CRITICAL(&streamsMux);
+  sc->win_frames++;
+  sc->win_send_us += (uint32_t)send_us;
+  sc->win_pending += pending;
+  sc->win_lat_us   = max(sc->win_lat_us, (uint32_t)(esp_timer_get_time() - f->ts_us));
+  sc->bytes       += total;
+  sc->writes      += calls;
+  sc->segs        += segs;
+  m_tx_bytes      += total;
+  m_tx_frames++;
+  portEXIT_CRITICAL(&streamsMux);
+}
+
+// One frame = one gathered send. Multipart: boundary/headers, JPEG, trailer.
+// WebSocket: frame header + WS_FRAME_HDR prefix, JPEG.
+static bool stream_send_frame(StreamClient* sc, const FrameSlot* f){
+  char part[128];
+  int hlen, cnt = 3;
+  if (sc->ws){
+    uint8_t* p = (uint8_t*)part;
+    hlen = (int)ws_header(p, WS_OP_BINARY, WS_FRAME_HDR + f->len);
+    hlen += ws_frame_prefix(p + hlen, f);
+    cnt = 2;
+  } else {
+    hlen = snprintf(part, sizeof(part),
+      "--frame\r\nContent-Type: image/jpeg\r\nContent-Length: %u\r\nX-Timestamp: %u.%06u\r\n\r\n",
+      (unsigned)f->len, (unsigned)(f->ts_us / 1000000), (unsigned)(f->ts_us % 1000000));
+  }
+  struct iovec iov[3] = {
+    { part, (size_t)hlen }, { f->buf, f->len }, { (void*)"\r\n", 2 },
+  };
+  size_t   total    = hlen + f->len + (cnt == 3 ? 2 : 0);
+  int64_t  t0       = esp_timer_get_time();
+  int64_t  deadline = t0 + STREAM_SEND_TIMEOUT_S * 1000000LL, budget = t0 + rate_budget_us();
+  uint32_t pending = 0, calls = 0, segs = 0;
+  bool ok = sock_sendv_all(sc->client.fd(), iov, cnt, deadline, &budget, &pending, &calls, &segs);
+  int64_t t1 = esp_timer_get_time();
+  TRACE_SPAN("stream_write", t0, t1, total);
+  if (ok) boot_served();
+  stream_account(sc, f, t1 - t0, total, pending, calls, segs);
+  return ok;
+}
+
+// Live mode: swap the held frame for the newest one, queued or published.
+static FrameSlot* stream_newest(StreamClient* sc, FrameSlot* f){
+  FrameSlot* n;
+  while (sc->q.pop(n)){ frames.release(f); f = n; }
+  if ((n = frames.acquireLatest(f->seq))){ frames.release(f); f = n; }
+  return f;
+}
+
+// Count a frame as handled; seq gaps since the previous one are drops.
+static void stream_mark_sent(StreamClient* sc, const FrameSlot* f){
+  if (sc->last_seq){
+    uint32_t gap = f->seq - sc->last_seq - 1;
+    portENTER_CRITICAL(&streamsMux);
+    sc->drops += gap; m_tx_drops += gap;
+    portEXIT_CRITICAL(&streamsMux);
+  }
+  sc->last_seq = f->seq; sc->sent++;
+}
+
+// Give a claimed slot back (another claimant may be scanning on the other core).
+static void stream_release(StreamClient* sc){
+  portENTER_CRITICAL(&streamsMux);
+  sc->used = false;
+  portEXIT_CRITICAL(&streamsMux);
+}
+
+// Sender task entry: from here on the producer queues frames and notifies us.
+// The task publishes its own handle, so a slot that was already closed and
+// claimed again never ends up with a stale one.
+static void stream_attach(StreamClient* sc){
+  portENTER_CRITICAL(&streamsMux);
+  sc->task = xTaskGetCurrentTaskHandle();
+  portEXIT_CRITICAL(&streamsMux);
+}
+
+// Sender task exit: stop the producer queueing, drop our refs, free the slot.
+static void stream_close(StreamClient* sc, FrameSlot* f){
+  if (f) frames.release(f);
+  portENTER_CRITICAL(&streamsMux);
+  sc->task = nullptr;
+  portEXIT_CRITICAL(&streamsMux);
+  while (sc->q.pop(f)) frames.release(f);
+  sc->client.stop();
+  stream_release(sc);
+}
+
+// Per-connection sender (NET_CORE): pops frames the producer queued for it and
+// writes them while the next frame is already being read out on CAPTURE_CORE.
+// Runs beside loop(), so HTTP control + DNS never wait on a viewer.
+// With fps set, sends are paced to fixed slots; late slots are not made up.
+static void stream_task(void* arg){
+  StreamClient* sc = (StreamClient*)arg;
+  stream_attach(sc);
+  const int64_t period = sc->fps ? 1000000 / sc->fps : 0;
+  int64_t due = 0;
+  FrameSlot* f = frames.acquireLatest();        // first frame without waiting a period
+  while (sc->client.connected()){
+    if (!f){
+      if (!sc->q.pop(f)){ ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(500)); continue; }
+    }
+    if (period){
+      int64_t now = esp_timer_get_time();
+      if (now < due) vTaskDelay(pdMS_TO_TICKS((due - now + 999) / 1000));
+      due = (now - due > period) ? now + period : due + period;
+    }
+    if (sc->live) f = stream_newest(sc, f);
+    bool ok = f->seq <= sc->last_seq || stream_send_frame(sc, f);
+    if (f->seq > sc->last_seq) stream_mark_sent(sc, f);
+    frames.release(f); f = nullptr;
+    if (!ok) break;
+  }
+  stream_close(sc, f);
+  vTaskDelete(nullptr);
+}
+
+static const char* stream_mode(const StreamClient& sc){
+  return sc.rtsp ? "rtsp" : sc.ws ? "ws" : sc.live ? "live" : "queued";
+}
+
+// Reserve a viewer slot; nullptr when all MAX_STREAM_CLIENTS are taken.
+static StreamClient* stream_claim(){
+  StreamClient* sc = nullptr;
+  portENTER_CRITICAL(&streamsMux);
+  for (auto& c : streams) if (!c.used){ sc = &c; sc->used = true; sc->task = nullptr; break; }
+  portEXIT_CRITICAL(&streamsMux);
+  return sc;
+}
+
+// Take over the (already answered) connection and start its sender task.
+static void stream_start(StreamClient* sc, WiFiClient& client, TaskFunction_t fn, const char* name){
+  sc->client   = client;
+  sc->last_seq = 0;
+  sc->sent     = 0;
+  sc->drops    = 0;
+  sc->skipped  = 0;
+  sc->lost     = 0;
+  sc->win_frames = sc->win_send_us = sc->win_pending = sc->win_lat_us = 0;
+  sc->bytes = 0; sc->writes = sc->segs = 0;
+  sc->t_start = esp_timer_get_time();
+
+  if (xTaskCreatePinnedToCore(fn, name, 4096, sc, 1, nullptr, NET_CORE) != pdPASS){   // fn calls stream_attach()
+    LOGW(TAG, "%s task alloc failed", name);
+    sc->client.stop();
+    stream_release(sc);
+  }
+}
+
+static void handleStream(){
+  if (!cam_ready){ server.send(503, "text/plain", "cam not ready"); return; }
+  StreamClient* sc = stream_claim();
+  if (!sc){ server.send(503, "text/plain", "too many streams"); return; }
+  sc->ws   = false;
+  sc->rtsp = false;
+  sc->live = server.arg("mode") == "live";
+  sc->fps  = (uint8_t)clampi(server.arg("fps").toInt(), 0, STREAM_MAX_FPS);
+
+  WiFiClient client = server.detachClient();
+  if (!client){ stream_release(sc); return; }
+  client.setTimeout(STREAM_SEND_TIMEOUT_S);
+  client.print(
+    "HTTP/1.1 200 OK\r\n"
+    "Content-Type: multipart/x-mixed-replace; boundary=frame\r\n"
+    "Cache-Control: no-store, no-cache, must-revalidate, max-age=0\r\n"
+    "Pragma: no-cache\r\n"
+    "Connection: close\r\n\r\n"
+  );
+  stream_start(sc, client, stream_task, "stream");
+}
+
+// -------------------- HTTP: /clip (pre-event download) --------------------
+// /clip?pre=S&post=S: frames from S seconds before the request until S seconds
+// after it, as concatenated JPEGs (video/x-motion-jpeg; VLC/ffmpeg play it).
+// The buffer is pinned for the duration and frames are sent from PSRAM as-is.
+// /timelapse.mjpeg uses the same sender on the timelapse store.
+struct ClipJob {
+  WiFiClient     client;
+  ClipRing*      ring;
+  volatile bool* busy;
+  const char*    name;
+  uint32_t       next;                            // next frame number to send
+  int64_t        t_end;                           // last capture time included
+};
+static ClipJob clipJob = { WiFiClient(), &clips, &clip_busy, "clip", 0, 0 };
+static ClipJob tlJob   = { WiFiClient(), &tl_store, &tl_busy, "timelapse", 0, 0 };
+
+static void clip_task(void* arg){
+  ClipJob& j = *(ClipJob*)arg;
+  int fd = j.client.fd();
+  uint32_t n = j.next, sent = 0;
+  for (;;){
+    const uint8_t* p; ClipFrame e;
+    if (!j.ring->get(n, &p, &e)){
+      if (esp_timer_get_time() > j.t_end || !j.client.connected()) break;
+      vTaskDelay(pdMS_TO_TICKS(20));              // post-event: wait for capture
+      continue;
+    }
+    if (e.ts_us > j.t_end) break;
+    struct iovec iov = { (void*)p, e.len };
+    uint32_t pending = 0, calls = 0, segs = 0;
+    if (!sock_sendv_all(fd, &iov, 1, esp_timer_get_time() + STREAM_SEND_TIMEOUT_S * 1000000LL, nullptr,
+                        &pending, &calls, &segs)) break;
+    j.ring->advance(++n);                         // sent frames may be recycled
+    sent++;
+  }
+  LOGI(TAG, "%s: %u frames", j.name, (unsigned)sent);
+  j.ring->unpin();
+  j.client.stop();
+  *j.busy = false;
+  vTaskDelete(nullptr);
+}
+
+// Detach the connection, send the MJPEG response header and start clip_task on
+// job j; the caller has pinned j.ring at j.next and set j.t_end.
+static void clip_start(ClipJob& j, const char* filename){
+  *j.busy  = true;
+  j.client = server.detachClient();
+  j.client.printf(
+    "HTTP/1.1 200 OK\r\n"
+    "Content-Type: video/x-motion-jpeg\r\n"
+    "Content-Disposition: attachment; filename=\"%s\"\r\n"
+    "Cache-Control: no-store\r\n"
+    "Connection: close\r\n\r\n", filename
+  );
+  if (xTaskCreatePinnedToCore(clip_task, j.name, 4096, &j, 1, nullptr, NET_CORE) != pdPASS){
+    LOGW(TAG, "%s task alloc failed", j.name);
+    j.ring->unpin();
+    j.client.stop();
+    *j.busy = false;
+  }
+}
+
+static void handleClip(){
+  if (!S.clip_kb){ server.send(503, "text/plain", "pre-event buffer disabled"); return; }
+  if (clip_busy){ server.send(503, "text/plain", "clip download in progress"); return; }
+  int pre  = server.hasArg("pre")  ? clampi(server.arg("pre").toInt(),  0, 3600) : 10;
+  int post = server.hasArg("post") ? clampi(server.arg("post").toInt(), 0, CLIP_MAX_POST_S) : 0;
+  int64_t now = esp_timer_get_time();
+  uint32_t first;
+  if (!clips.pin(now - pre * 1000000LL, &first)){ server.send(503, "text/plain", "clip buffer busy"); return; }
+
+  clipJob.next  = first;
+  clipJob.t_end = now + post * 1000000LL;
+  clip_start(clipJob, "nozzlecam-clip.mjpeg");
+}
+
+// -------------------- HTTP: /record.avi (MJPEG in AVI, streamed) --------------------
+// /record.avi?seconds=S&fps=F wraps the camera's JPEGs in an AVI container as
+// they are captured: no re-encoding on the device or in the browser.
+// AVI is constant-rate, so the task walks a fixed 1/F timeline and writes the
+// newest frame at each slot. A slot with no new frame (camera slower than F,
+// or the link fell behind) gets a zero-length 00dc chunk ("repeat previous"),
+// so playback time stays equal to capture time.
+// RIFF/movi sizes and frame counts are only known at the end; as with any
+// streamed AVI they are left as placeholders and idx1 follows movi once the
+// recording ends (duration reached or /record/stop). A dropped link has none.
+#define REC_MAX_S      3600
+#define AVI_HDR_LEN    224
+#define AVIF_HASINDEX  0x10
+#define AVIIF_KEYFRAME 0x10
+
+struct RecJob {
+  WiFiClient    client;
+  uint32_t*     sizes;                            // chunk size per slot for idx1 (PSRAM), 0 = repeat
+  uint32_t      slots;                            // planned: seconds * fps
+  uint8_t       fps;
+  volatile bool stop;
+  uint32_t      n;                                // slots written
+  uint32_t      repeats;
+  uint64_t      bytes;
+};
+static RecJob recJob;
+static volatile bool rec_busy = false;             // one recording at a time
+
+static uint8_t* avi_u32(uint8_t* p, uint32_t v){ p[0]=v; p[1]=v>>8; p[2]=v>>16; p[3]=v>>24; return p + 4; }
+static uint8_t* avi_u16(uint8_t* p, uint16_t v){ p[0]=v; p[1]=v>>8; return p + 2; }
+static uint8_t* avi_cc(uint8_t* p, const char* cc){ memcpy(p, cc, 4); return p + 4; }
+
+// RIFF 'AVI ' + hdrl (avih, strl: strh + MJPG BITMAPINFOHEADER) + open 'movi' list.
+static void avi_header(uint8_t* b, uint8_t fps, uint16_t w, uint16_t h, uint32_t bufsz){
+  uint8_t* p = b;
+  p = avi_cc(p, "RIFF"); p = avi_u32(p, 0xFFFFFFFF); p = avi_cc(p, "AVI ");
+  p = avi_cc(p, "LIST"); p = avi_u32(p, 192);       p = avi_cc(p, "hdrl");
+  p = avi_cc(p, "avih"); p = avi_u32(p, 56);
+  p = avi_u32(p, 1000000 / fps);                  // dwMicroSecPerFrame
+  p = avi_u32(p, 0); p = avi_u32(p, 0);           // dwMaxBytesPerSec, dwPaddingGranularity
+  p = avi_u32(p, AVIF_HASINDEX);                  // dwFlags
+  p = avi_u32(p, 0); p = avi_u32(p, 0);           // dwTotalFrames (unknown), dwInitialFrames
+  p = avi_u32(p, 1); p = avi_u32(p, bufsz);       // dwStreams, dwSuggestedBufferSize
+  p = avi_u32(p, w); p = avi_u32(p, h);
+  memset(p, 0, 16); p += 16;                      // dwReserved[4]
+  p = avi_cc(p, "LIST"); p = avi_u32(p, 116);       p = avi_cc(p, "strl");
+  p = avi_cc(p, "strh"); p = avi_u32(p, 56);
+  p = avi_cc(p, "vids"); p = avi_cc(p, "MJPG");
+  p = avi_u32(p, 0); p = avi_u16(p, 0); p = avi_u16(p, 0);   // dwFlags, wPriority, wLanguage
+  p = avi_u32(p, 0);                              // dwInitialFrames
+  p = avi_u32(p, 1); p = avi_u32(p, fps);         // dwScale, dwRate
+  p = avi_u32(p, 0); p = avi_u32(p, 0);           // dwStart, dwLength (unknown)
+  p = avi_u32(p, bufsz); p = avi_u32(p, 0xFFFFFFFF); p = avi_u32(p, 0);   // buffer, quality, sample size
+  p = avi_u16(p, 0); p = avi_u16(p, 0); p = avi_u16(p, w); p = avi_u16(p, h);
+  p = avi_cc(p, "strf"); p = avi_u32(p, 40);
+  p = avi_u32(p, 40); p = avi_u32(p, w); p = avi_u32(p, h);
+  p = avi_u16(p, 1); p = avi_u16(p, 24); p = avi_cc(p, "MJPG");
+  p = avi_u32(p, (uint32_t)w * h * 3);
+  memset(p, 0, 16); p += 16;
+  p = avi_cc(p, "LIST"); p = avi_u32(p, 0xFFFFFFFF); p = avi_cc(p, "movi");
+}
+
+static bool rec_send(int fd, struct iovec* iov, int cnt){
+  uint32_t pending = 0, calls = 0, segs = 0;
+  return sock_sendv_all(fd, iov, cnt, esp_timer_get_time() + STREAM_SEND_TIMEOUT_S * 1000000LL, nullptr,
+                        &pending, &calls, &segs);
+}
+
+// idx1: offsets are relative to the 'movi' fourcc, chunks are word aligned.
+static bool rec_write_index(int fd){
+  uint8_t  e[32 * 16];
+  uint8_t  h[8];
+  avi_u32(avi_cc(h, "idx1"), recJob.n * 16);
+  struct iovec iov = { h, 8 };
+  if (!rec_send(fd, &iov, 1)) return false;
+  uint32_t off = 4;
+  for (uint32_t i = 0; i < recJob.n; ){
+    uint8_t* p = e;
+    for (; i < recJob.n && p < e + sizeof(e); i++){
+      uint32_t sz = recJob.sizes[i];
+      p = avi_cc(p, "00dc"); p = avi_u32(p, sz ? AVIIF_KEYFRAME : 0);
+      p = avi_u32(p, off);   p = avi_u32(p, sz);
+      off += 8 + sz + (sz & 1);
+    }
+    iov = { e, (size_t)(p - e) };
+    if (!rec_send(fd, &iov, 1)) return false;
+  }
+  return true;
+}
+
+static void rec_task(void*){
+  RecJob& j = recJob;
+  int fd = j.client.fd();
+  const int64_t period = 1000000 / j.fps;
+  const int64_t t0 = esp_timer_get_time();
+  uint32_t last_seq = 0;
+  bool ok = true;
+  while (ok && !j.stop && j.n < j.slots && j.client.connected()){
+    int64_t now = esp_timer_get_time();
+    int64_t due = t0 + (int64_t)j.n * period;
+    if (now < due){ vTaskDelay(pdMS_TO_TICKS((due - now + 999) / 1000)); continue; }
+
+    // Already past the next slot too (link stalled): this one is a repeat.
+    FrameSlot* f = now < due + period ? frames.acquireLatest(last_seq) : nullptr;
+    uint8_t ck[8];
+    avi_u32(avi_cc(ck, "00dc"), f ? f->len : 0);
+    struct iovec iov[3] = { { ck, 8 }, { f ? f->buf : nullptr, f ? f->len : 0 }, { (void*)"", f ? (f->len & 1) : 0 } };
+    TRACE_BEGIN(t_wr);
+    ok = rec_send(fd, iov, 3);
+    TRACE_END("avi_write", t_wr, f ? f->len : 0);
+    j.sizes[j.n] = f ? f->len : 0;
+    j.bytes += 8 + iov[1].iov_len + iov[2].iov_len;
+    if (f){ last_seq = f->seq; frames.release(f); } else j.repeats++;
+    if (ok) j.n++;
+  }
+  if (ok && j.client.connected()) ok = rec_write_index(fd);
+  LOGI(TAG, "record: %u slots @%u fps (%u repeats), %s", (unsigned)j.n, j.fps, (unsigned)j.repeats,
+       ok ? "indexed" : "aborted");
+  j.client.stop();
+  heap_caps_free(j.sizes); j.sizes = nullptr;
+  rec_busy = false;
+  vTaskDelete(nullptr);
+}
+
+static void handleRecord(){
+  if (!cam_ready){ server.send(503, "text/plain", "cam not ready"); return; }
+  if (rec_busy){ server.send(503, "text/plain", "recording in progress"); return; }
+  int secs = server.hasArg("seconds") ? clampi(server.arg("seconds").toInt(), 1, REC_MAX_S) : 60;
+  int fps  = clampi(server.hasArg("fps") ? server.arg("fps").toInt() : (cap_fps_x10 + 5) / 10, 1, STREAM_MAX_FPS);
+  FrameSlot* f = frames.acquireLatest();
+  if (!f){ server.send(503, "text/plain", "no frame"); return; }
+  uint16_t w = f->width, h = f->height;
+  uint32_t bufsz = (f->len * 2 + 4095) & ~4095u;
+  frames.release(f);
+
+  recJob.slots = (uint32_t)secs * fps;
+  recJob.sizes = (uint32_t*)heap_caps_malloc(recJob.slots * sizeof(uint32_t), MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+  if (!recJob.sizes){ server.send(503, "text/plain", "no memory for index"); return; }
+  rec_busy       = true;
+  recJob.fps     = (uint8_t)fps;
+  recJob.stop    = false;
+  recJob.n       = recJob.repeats = 0;
+  recJob.bytes   = 0;
+  recJob.client  = server.detachClient();
+  recJob.client.print(
+    "HTTP/1.1 200 OK\r\n"
+    "Content-Type: video/x-msvideo\r\n"
+    "Content-Disposition: attachment; filename=\"nozzlecam.avi\"\r\n"
+    "Cache-Control: no-store\r\n"
+    "Connection: close\r\n\r\n"
+  );
+  uint8_t hdr[AVI_HDR_LEN];
+  avi_header(hdr, recJob.fps, w, h, bufsz);
+  recJob.client.write(hdr, sizeof(hdr));
+  if (xTaskCreatePinnedToCore(rec_task, "record", 4096, nullptr, 1, nullptr, NET_CORE) != pdPASS){
+    LOGW(TAG, "record task alloc failed");
+    recJob.client.stop();
+    heap_caps_free(recJob.sizes); recJob.sizes = nullptr;
+    rec_busy = false;
+  }
+}
+
+// Ends the running recording after the current slot; the file gets its index.
+static void handleRecordStop(){
+  if (!rec_busy){ server.send(409, "text/plain", "not recording"); return; }
+  recJob.stop = true;
+  server.send(200, "text/plain", "stopping");
+}
+
+// Per-viewer delivery report: mode, pacing, frames sent and dropped, and the
+// framing cost: sendmsg calls and TCP segments per frame, and throughput.
+// A running /record.avi is reported as "record".
+static void handleStreams(){
+  ChunkedOut o;
+  server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+  server.send(200, "application/json", "");
+  o.printf("{\"cap_fps\":%.1f,\"streams\":[", cap_fps_x10 / 10.0);
+  bool first = true;
+  for (int i=0;i<MAX_STREAM_CLIENTS;i++){
+    StreamClient& sc = streams[i];
+    portENTER_CRITICAL(&streamsMux);
+    bool     used  = sc.used && sc.task;
+    uint32_t sent  = sc.sent, drops = sc.drops, queued = sc.q.size();
+    uint32_t wr    = sc.writes, segs = sc.segs;
+    uint64_t bytes = sc.bytes;
+    int64_t  age   = esp_timer_get_time() - sc.t_start;
+    portEXIT_CRITICAL(&streamsMux);
+    if (!used) continue;
+    float per = sent ? 1.0f / sent : 0.0f;
+    o.printf("%s{\"id\":%d,\"mode\":\"%s\",\"fps\":%u,\"sent\":%u,\"drops\":%u,\"queued\":%u,"
+             "\"bytes\":%llu,\"kBps\":%.1f,\"writes_per_frame\":%.2f,\"segs_per_frame\":%.2f",
+             first ? "" : ",", i, stream_mode(sc), (unsigned)sc.fps,
+             (unsigned)sent, (unsigned)drops, (unsigned)queued, (unsigned long long)bytes,
+             age > 0 ? bytes * 1000.0 / age : 0.0, wr * per, segs * per);
+    if (sc.ws) o.printf(",\"credits\":%u,\"skipped\":%u", sc.credits, (unsigned)sc.skipped);
+    if (sc.rtsp) o.printf(",\"transport\":\"%s\",\"lost\":%u", sc.rtsp_tcp ? "tcp" : "udp", (unsigned)sc.lost);
+    o.puts("}");
+    first = false;
+  }
+  o.puts("]");
+  if (rec_busy)
+    o.printf(",\"record\":{\"fps\":%u,\"seconds\":%.1f,\"planned_s\":%u,\"repeats\":%u,\"bytes\":%llu}",
+             recJob.fps, (double)recJob.n / recJob.fps, (unsigned)(recJob.slots / recJob.fps),
+             (unsigned)recJob.repeats, (unsigned long long)recJob.bytes);
+  o.puts("}");
+  o.flush();
+}
+
+// -------------------- HTTP: /ws/stream (WebSocket, credit flow control) --------------------
+// Same fan-out as /stream, but each JPEG is one binary message
+// (ws_frame_prefix() + JPEG) and the browser says how much it can take: every
+// {"credit":N} text message lets the server send N more frames (at most
+// WS_MAX_CREDITS outstanding; ?credits= sets the initial grant, default 2).
+// Out of credit, nothing is queued: the next send is the newest frame, and
+// the frames passed over are counted as skipped. Settings (on change), motion
+// events and a stats summary (every WS_STATS_MS) are pushed as text messages.
+static bool ws_send(StreamClient* sc, uint8_t op, const void* p, size_t n){
+  uint8_t hdr[WS_MAX_HEADER];
+  size_t  hl = ws_header(hdr, op, n);
+  struct iovec iov[2] = { { hdr, hl }, { (void*)p, n } };
+  uint32_t pending = 0, calls = 0, segs = 0;
+  bool ok = sock_sendv_all(sc->client.fd(), iov, n ? 2 : 1, esp_timer_get_time() + STREAM_SEND_TIMEOUT_S * 1000000LL, nullptr,
+                           &pending, &calls, &segs);
+  portENTER_CRITICAL(&streamsMux);
+  sc->bytes += hl + n; m_tx_bytes += hl + n;
+  portEXIT_CRITICAL(&streamsMux);
+  return ok;
+}
+
+static bool ws_push_settings(StreamClient* sc, uint32_t gen){
+  char buf[512];
+  int n = snprintf(buf, sizeof(buf), "{\"type\":\"settings\",\"gen\":%u", (unsigned)gen);
+  for (int i=0;i<SETTING_FIELD_N && n < (int)sizeof(buf) - 32;i++){
+    const SettingField& f = SETTING_FIELDS[i];
+    n += snprintf(buf + n, sizeof(buf) - n, ",\"%s\":", f.key);
+    n += setting_fmt(buf + n, sizeof(buf) - n, f, setting_get(S, f));
+  }
+  n += snprintf(buf + n, sizeof(buf) - n, "}");
+  return ws_send(sc, WS_OP_TEXT, buf, n);
+}
+
+// Motion events after `*seen` (one message each); *seen advances.
+static bool ws_push_motion(StreamClient* sc, uint32_t* seen){
+  while (*seen != MD.events){
+    portENTER_CRITICAL(&motionMux);
+    uint32_t    total = MD.events;
+    if (total - *seen > MOTION_EVENTS) *seen = total - MOTION_EVENTS;   // overwritten meanwhile
+    MotionEvent e = MD.ev[*seen % MOTION_EVENTS];
+    portEXIT_CRITICAL(&motionMux);
+    char buf[160];
+    int n = snprintf(buf, sizeof(buf), "{\"type\":\"motion\",\"id\":%u,\"event\":\"%s\",\"seq\":%u,\"t_ms\":%u,\"score\":%u}",
+                     (unsigned)e.id, MOTION_EVT_NAME[e.type], (unsigned)e.seq, (unsigned)(e.ts_us / 1000), e.score);
+    if (!ws_send(sc, WS_OP_TEXT, buf, n)) return false;
+    *seen = e.id;
+  }
+  return true;
+}
+
+static bool ws_push_stats(StreamClient* sc){
+  int viewers = 0;
+  portENTER_CRITICAL(&streamsMux);
+  for (auto& c : streams) if (c.used && c.task) viewers++;
+  uint32_t sent = sc->sent, drops = sc->drops;
+  uint64_t bytes = sc->bytes;
+  portEXIT_CRITICAL(&streamsMux);
+  int64_t age = esp_timer_get_time() - sc->t_start;
+  portENTER_CRITICAL(&motionMux);
+  uint16_t score = MD.scores ? MD.hist[(MD.scores - 1) % MOTION_HIST].changed : 0;
+  portEXIT_CRITICAL(&motionMux);
+  char buf[384];
+  int n = snprintf(buf, sizeof(buf),
+    "{\"type\":\"stats\",\"seq\":%u,\"cap_fps\":%.1f,\"sent\":%u,\"drops\":%u,\"skipped\":%u,\"credits\":%u,"
+    "\"kBps\":%.1f,\"viewers\":%d,\"rate\":{\"state\":\"%s\",\"fs\":\"%s\",\"q\":%u},\"record\":%s,"
+    "\"motion\":{\"state\":\"%s\",\"score\":%u}}",
+    (unsigned)frames.latestSeq(), cap_fps_x10 / 10.0, (unsigned)sent, (unsigned)drops, (unsigned)sc->skipped,
+    sc->credits, age > 0 ? bytes * 1000.0 / age : 0.0, viewers,
+    R.state, framesizeName((framesize_t)R.fs), R.q, rec_busy ? "true" : "false",
+    MOTION_ST_NAME[MD.state], score);
+  return ws_send(sc, WS_OP_TEXT, buf, n);
+}
+
+// Drain what the client sent: credits, ping, close. False = close the connection.
+static bool ws_rx(StreamClient* sc, uint8_t* rx, size_t cap, size_t* rn){
+  for (;;){
+    ssize_t r = recv(sc->client.fd(), rx + *rn, cap - *rn, MSG_DONTWAIT);
+    if (r == 0) return false;
+    if (r < 0) return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+    *rn += r;
+    WsFrame fr;
+    long used;
+    while ((used = ws_parse(rx, *rn, WS_RX_MAX, &fr)) > 0){
+      if (fr.op == WS_OP_TEXT){
+        json_object_each((const char*)fr.data, fr.len, [&](const char* k, size_t kl, const JsonVal& v) -> const char* {
+          if (kl == 6 && !memcmp(k, "credit", 6) && v.type == JsonVal::NUM && v.is_int && v.i > 0)
+            sc->credits += (uint8_t)min<long>(v.i, WS_MAX_CREDITS - sc->credits);   // no signed add of v.i
+          return nullptr;
+        }, nullptr);
+      }
+      else if (fr.op == WS_OP_PING){ if (!ws_send(sc, WS_OP_PONG, fr.data, fr.len)) return false; }
+      else if (fr.op == WS_OP_CLOSE){ ws_send(sc, WS_OP_CLOSE, fr.data, min<size_t>(fr.len, 2)); return false; }
+      memmove(rx, rx + used, *rn - used);
+      *rn -= used;
+    }
+    if (used < 0){
+      static const uint8_t PROTOCOL_ERROR[2] = { 0x03, 0xEA };     // 1002
+      ws_send(sc, WS_OP_CLOSE, PROTOCOL_ERROR, 2);
+      return false;
+    }
+  }
+}
+
+// Sender for one /ws/stream client (NET_CORE). The mailbox is only a wakeup
+// here: with credit left, the newest unsent frame goes out; without, the task
+// waits on the socket for the next grant.
+static void ws_task(void* arg){
+  StreamClient* sc = (StreamClient*)arg;
+  stream_attach(sc);
+  uint8_t  rx[WS_RX_MAX + 14];                       // one client frame incl. its longest header
+  size_t   rn = 0;
+  uint32_t gen = settings_gen - 1;                   // first pass pushes the settings
+  uint32_t mev = MD.events;                          // motion events from now on
+  int64_t  next_stats = 0;
+  bool     starved = false;                          // a newer frame waited for credit
+  bool     ok = true;
+  while (ok && sc->client.connected()){
+    if (!ws_rx(sc, rx, sizeof(rx), &rn)) break;
+    if (gen != settings_gen){ gen = settings_gen; ok = ws_push_settings(sc, gen); }
+    if (ok && mev != MD.events) ok = ws_push_motion(sc, &mev);
+    int64_t now = esp_timer_get_time();
+    if (ok && now >= next_stats){ next_stats = now + WS_STATS_MS * 1000LL; ok = ws_push_stats(sc); }
+
+    FrameSlot* f;
+    while (sc->q.pop(f)) frames.release(f);
+    f = (ok && sc->credits) ? frames.acquireLatest(sc->last_seq) : nullptr;
+    if (f){
+      if (starved && sc->last_seq) sc->skipped += f->seq - sc->last_seq - 1;
+      starved = false;
+      ok = stream_send_frame(sc, f);
+      stream_mark_sent(sc, f);
+      sc->credits--;
+      frames.release(f);
+      continue;
+    }
+    if (!ok) break;
+    if (!sc->credits){
+      if (frames.latestSeq() > sc->last_seq) starved = true;
+      int fd = sc->client.fd();
+      fd_set rf; FD_ZERO(&rf); FD_SET(fd, &rf);
+      struct timeval tv = { 0, 100000 };
+      select(fd + 1, &rf, nullptr, nullptr, &tv);
+    }
+    else ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(100));
+  }
+  stream_close(sc, nullptr);
+  vTaskDelete(nullptr);
+}
+
+static void handleWsStream(){
+  String key = server.header("Sec-WebSocket-Key");
+  if (!server.header("Upgrade").equalsIgnoreCase("websocket") || !key.length()){
+    server.sendHeader("Upgrade", "websocket");
+    server.send(426, "text/plain", "websocket upgrade required");
+    return;
+  }
+  if (server.header("Sec-WebSocket-Version") != "13"){
+    server.sendHeader("Sec-WebSocket-Version", "13");
+    server.send(426, "text/plain", "unsupported websocket version");
+    return;
+  }
+  char accept[29];
+  if (!ws_accept_key(key.c_str(), key.length(), accept)){ server.send(400, "text/plain", "bad key"); return; }
+  if (!cam_ready){ server.send(503, "text/plain", "cam not ready"); return; }
+  StreamClient* sc = stream_claim();
+  if (!sc){ server.send(503, "text/plain", "too many streams"); return; }
+  sc->ws      = true;
+  sc->rtsp    = false;
+  sc->live    = true;
+  sc->fps     = 0;
+  sc->credits = (uint8_t)clampi(server.hasArg("credits") ? server.arg("credits").toInt() : 2, 1, WS_MAX_CREDITS);
+
+  WiFiClient client = server.detachClient();
+  if (!client){ stream_release(sc); return; }
+  char resp[160];
+  snprintf(resp, sizeof(resp),
+    "HTTP/1.1 101 Switching Protocols\r\n"
+    "Upgrade: websocket\r\n"
+    "Connection: Upgrade\r\n"
+    "Sec-WebSocket-Accept: %s\r\n\r\n", accept);
+  client.print(resp);
+  stream_start(sc, client, ws_task, "ws");
+}
+
+// -------------------- RTSP (RTP/JPEG, RFC 2326 + RFC 2435) --------------------
+// rtsp://<ip>/ for NVRs and go2rtc. A session is one more viewer of the frame
+// ring: it takes a StreamClient slot (shared with /stream and /ws/stream,
+// listed in /api/streams and /metrics) and, while playing, sends the newest
+// frame whenever the capture task publishes one. Each frame is cut into
+// RFC 2435 packets straight from the PSRAM slot (rtp_jpeg.h).
+// Transport is RTP/AVP over UDP (server ports RTSP_UDP_BASE + 2 * slot; the
+// RTCP port is only read, as a keepalive), or RTP/AVP/TCP interleaved on the
+// RTSP connection when the client asks for it. Over TCP a frame's packets go
+// out in gathered sends with the usual deadline. Over UDP a full send buffer
+// costs the rest of that frame (counted as lost), never a stall.
+#ifndef RTSP_PORT
+#define RTSP_PORT 554
+#endif
+#define RTSP_UDP_BASE  6970
+#define RTSP_MTU       1400                          // RTP packet size
+#define RTSP_TCP_BATCH 8                             // interleaved packets per sendmsg
+#define RTSP_TIMEOUT_S 60                            // UDP session with no RTSP request or RTCP
+#define RTSP_RX_MAX    1024                          // largest request we accept
+
+struct RtspSession {
+  int         rtp, rtcp;                             // UDP sockets, -1 = none / interleaved
+  sockaddr_in peer;                                  // client RTP port (UDP)
+  uint8_t     ch;                                    // interleaved RTP channel
+  bool        playing;
+  uint16_t    seq;
+  uint32_t    ssrc, id, ts_base;
+  int64_t     last_rx;                               // keepalive: last request or RTCP packet
+  uint32_t    skip;                                  // rest of an interleaved packet from the client
+  uint32_t    bad;                                   // frames RFC 2435 cannot carry
+  size_t      rn;
+  char        rx[RTSP_RX_MAX];
+  char        tx[768];
+  uint8_t     hdr[RTSP_TCP_BATCH][4 + RTP_JPEG_MAX_HDR];
+};
+
+static inline uint32_t rtsp_rtptime(const RtspSession& rs, int64_t us){ return rs.ts_base + (uint32_t)(us * 9 / 100); }
+
+static void rtsp_udp_close(RtspSession& rs){
+  if (rs.rtp  >= 0) close(rs.rtp);
+  if (rs.rtcp >= 0) close(rs.rtcp);
+  rs.rtp = rs.rtcp = -1;
+}
+
+static int rtsp_udp_bind(uint16_t port){
+  int fd = socket(AF_INET, SOCK_DGRAM, 0);
+  if (fd < 0) return -1;
+  sockaddr_in a = {}; a.sin_family = AF_INET; a.sin_port = htons(port); a.sin_addr.s_addr = htonl(INADDR_ANY);
+  if (bind(fd, (sockaddr*)&a, sizeof(a)) < 0){ close(fd); return -1; }
+  return fd;
+}
+
+// Value of header `name` in the request head (NUL-terminated), or nullptr.
+static const char* rtsp_header(const char* req, const char* name, size_t* len){
+  size_t nl = strlen(name);
+  for (const char* l = strstr(req, "\r\n"); l && l[2] != '\r'; l = strstr(l + 2, "\r\n")){
+    if (strncasecmp(l + 2, name, nl) || l[2 + nl] != ':') continue;
+    const char* v = l + 3 + nl;
+    while (*v == ' ') v++;
+    *len = strcspn(v, "\r\n");
+    return v;
+  }
+  return nullptr;
+}
+
+static bool rtsp_reply(StreamClient* sc, RtspSession& rs, const char* status, int cseq, const char* extra, const char* body){
+  size_t bl = body ? strlen(body) : 0;
+  int n = snprintf(rs.tx, sizeof(rs.tx), "RTSP/1.0 %s\r\nCSeq: %d\r\nServer: NozzleCAM\r\n%s", status, cseq, extra ? extra : "");
+  if (bl) n += snprintf(rs.tx + n, sizeof(rs.tx) - n, "Content-Type: application/sdp\r\nContent-Length: %u\r\n", (unsigned)bl);
+  n += snprintf(rs.tx + n, sizeof(rs.tx) - n, "\r\n");
+  struct iovec iov[2] = { { rs.tx, (size_t)min<int>(n, sizeof(rs.tx) - 1) }, { (void*)body, bl } };
+  uint32_t pending = 0, calls = 0, segs = 0;
+  return sock_sendv_all(sc->client.fd(), iov, bl ? 2 : 1, esp_timer_get_time() + STREAM_SEND_TIMEOUT_S * 1000000LL, nullptr,
+                        &pending, &calls, &segs);
+}
+
+// One request (head NUL-terminated). False = close the connection.
+static bool rtsp_request(StreamClient* sc, RtspSession& rs, char* req){
+  char method[16] = {}, url[128] = {};
+  if (sscanf(req, "%15s %127s RTSP/1.0", method, url) != 2){ rtsp_reply(sc, rs, "400 Bad Request", 0, nullptr, nullptr); return false; }
+  size_t vl;
+  const char* v = rtsp_header(req, "CSeq", &vl);
+  int cseq = v ? atoi(v) : 0;
+  char sess[48];
+  snprintf(sess, sizeof(sess), "Session: %08X;timeout=%d\r\n", (unsigned)rs.id, RTSP_TIMEOUT_S);
+  bool has_session = (v = rtsp_header(req, "Session", &vl)) != nullptr;
+  if (has_session && strtoul(v, nullptr, 16) != rs.id) return rtsp_reply(sc, rs, "454 Session Not Found", cseq, nullptr, nullptr);
+  rs.last_rx = esp_timer_get_time();
+
+  if (!strcmp(method, "OPTIONS"))
+    return rtsp_reply(sc, rs, "200 OK", cseq, "Public: OPTIONS, DESCRIBE, SETUP, PLAY, PAUSE, TEARDOWN, GET_PARAMETER\r\n", nullptr);
+  if (!strcmp(method, "DESCRIBE")){
+    sockaddr_in a = {}; socklen_t al = sizeof(a);
+    getsockname(sc->client.fd(), (sockaddr*)&a, &al);
+    const uint8_t* ip = (const uint8_t*)&a.sin_addr.s_addr;
+    char sdp[256], hdr[192];
+    snprintf(sdp, sizeof(sdp),
+      "v=0\r\no=- %u 1 IN IP4 %u.%u.%u.%u\r\ns=NozzleCAM\r\nc=IN IP4 0.0.0.0\r\nt=0 0\r\n"
+      "a=control:*\r\nm=video 0 RTP/AVP %d\r\na=rtpmap:%d JPEG/90000\r\na=control:track1\r\n",
+      (unsigned)rs.id, ip[0], ip[1], ip[2], ip[3], RTP_JPEG_PT, RTP_JPEG_PT);
+    size_t ul = strlen(url);
+    snprintf(hdr, sizeof(hdr), "Content-Base: %s%s\r\n", url, ul && url[ul-1] == '/' ? "" : "/");
+    return rtsp_reply(sc, rs, "200 OK", cseq, hdr, sdp);
+  }
+  if (!strcmp(method, "SETUP")){
+    if (!(v = rtsp_header(req, "Transport", &vl))) return rtsp_reply(sc, rs, "461 Unsupported Transport", cseq, nullptr, nullptr);
+    char tr[160];
+    snprintf(tr, sizeof(tr), "%.*s", (int)vl, v);
+    char hdr[224];
+    rtsp_udp_close(rs);
+    if (strstr(tr, "RTP/AVP/TCP")){
+      int a = 0, b = 1;
+      if (const char* il = strstr(tr, "interleaved=")) sscanf(il + 12, "%d-%d", &a, &b);
+      rs.ch = (uint8_t)a; sc->rtsp_tcp = true;
+      snprintf(hdr, sizeof(hdr), "%sTransport: RTP/AVP/TCP;unicast;interleaved=%d-%d;ssrc=%08X\r\n", sess, a, b, (unsigned)rs.ssrc);
+    } else {
+      const char* cp = strstr(tr, "client_port=");
+      int a = 0, b = 0;
+      if (!cp || sscanf(cp + 12, "%d-%d", &a, &b) < 1 || a <= 0 || a > 65535)
+        return rtsp_reply(sc, rs, "461 Unsupported Transport", cseq, nullptr, nullptr);
+      if (!b) b = a + 1;
+      uint16_t sp = RTSP_UDP_BASE + 2 * (uint16_t)(sc - streams);
+      rs.rtp = rtsp_udp_bind(sp); rs.rtcp = rtsp_udp_bind(sp + 1);
+      if (rs.rtp < 0){ rtsp_udp_close(rs); return rtsp_reply(sc, rs, "500 Internal Server Error", cseq, nullptr, nullptr); }
+      socklen_t pl = sizeof(rs.peer);
+      getpeername(sc->client.fd(), (sockaddr*)&rs.peer, &pl);
+      rs.peer.sin_port = htons((uint16_t)a);
+      sc->rtsp_tcp = false;
+      snprintf(hdr, sizeof(hdr), "%sTransport: RTP/AVP;unicast;client_port=%d-%d;server_port=%u-%u;ssrc=%08X\r\n",
+               sess, a, b, sp, sp + 1, (unsigned)rs.ssrc);
+    }
+    return rtsp_reply(sc, rs, "200 OK", cseq, hdr, nullptr);
+  }
+  if (!strcmp(method, "PLAY")){
+    if (rs.rtp < 0 && !sc->rtsp_tcp) return rtsp_reply(sc, rs, "455 Method Not Valid in This State", cseq, nullptr, nullptr);
+    char hdr[256];
+    snprintf(hdr, sizeof(hdr), "%sRange: npt=0.000-\r\nRTP-Info: url=%s;seq=%u;rtptime=%u\r\n",
+             sess, url, rs.seq, (unsigned)rtsp_rtptime(rs, esp_timer_get_time()));
+    rs.playing = true;
+    return rtsp_reply(sc, rs, "200 OK", cseq, hdr, nullptr);
+  }
+  if (!strcmp(method, "PAUSE")){ rs.playing = false; return rtsp_reply(sc, rs, "200 OK", cseq, sess, nullptr); }
+  if (!strcmp(method, "TEARDOWN")){ rtsp_reply(sc, rs, "200 OK", cseq, sess, nullptr); return false; }
+  if (!strcmp(method, "GET_PARAMETER") || !strcmp(method, "SET_PARAMETER"))
+    return rtsp_reply(sc, rs, "200 OK", cseq, sess, nullptr);
+  return rtsp_reply(sc, rs, "501 Not Implemented", cseq, nullptr, nullptr);
+}
+
+// Drain the RTSP connection: requests, and RTCP the client interleaves.
+static bool rtsp_rx(StreamClient* sc, RtspSession& rs){
+  for (;;){
+    ssize_t r = recv(sc->client.fd(), rs.rx + rs.rn, sizeof(rs.rx) - 1 - rs.rn, MSG_DONTWAIT);
+    if (r == 0) return false;
+    if (r < 0) return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+    rs.rn += r;
+    for (;;){
+      if (rs.skip){
+        size_t k = min<size_t>(rs.skip, rs.rn);
+        memmove(rs.rx, rs.rx + k, rs.rn - k); rs.rn -= k; rs.skip -= k;
+        if (rs.skip) break;
+      }
+      if (!rs.rn) break;
+      if (rs.rx[0] == '$'){                            // $ ch len16 packet
+        if (rs.rn < 4) break;
+        rs.skip = 4 + ((uint8_t)rs.rx[2] << 8 | (uint8_t)rs.rx[3]);
+        rs.last_rx = esp_timer_get_time();
+        continue;
+      }
+      rs.rx[rs.rn] = 0;
+      char* end = strstr(rs.rx, "\r\n\r\n");
+      if (!end){
+        if (rs.rn >= sizeof(rs.rx) - 1){ rtsp_reply(sc, rs, "400 Bad Request", 0, nullptr, nullptr); return false; }
+        break;
+      }
+      end[2] = 0;                                      // head ends after its last CRLF
+      size_t vl, used = end + 4 - rs.rx;
+      const char* cl = rtsp_header(rs.rx, "Content-Length", &vl);
+      uint32_t body = cl ? (uint32_t)atoi(cl) : 0;
+      if (!rtsp_request(sc, rs, rs.rx)) return false;
+      memmove(rs.rx, rs.rx + used, rs.rn - used); rs.rn -= used;
+      rs.skip = body;                                  // parameters are not used
+    }
+  }
+}
+
+// One frame as RFC 2435 packets: one sendmsg per datagram over UDP, batches of
+// RTSP_TCP_BATCH '$'-framed packets per gathered send when interleaved.
+static bool rtsp_send_frame(StreamClient* sc, RtspSession& rs, const FrameSlot* f){
+  RtpJpeg j;
+  if (!rtp_jpeg_parse(f->buf, f->len, &j)){
+    if (!rs.bad++) LOGW(TAG, "rtsp: frame %u is not RFC 2435 baseline, skipped", (unsigned)f->seq);
+    return true;
+  }
+  uint32_t ts  = rtsp_rtptime(rs, f->ts_us);
+  size_t   mtu = RTSP_MTU, total = 0;
+  uint32_t pending = 0, calls = 0, segs = 0;
+  int64_t  t0 = esp_timer_get_time(), deadline = t0 + STREAM_SEND_TIMEOUT_S * 1000000LL;
+  int64_t  budget = t0 + rate_budget_us();
+  bool     ok = true;
+  struct iovec iov[2 * RTSP_TCP_BATCH];
+  for (uint32_t off = 0; ok && off < j.scan_len; ){
+    int cnt = 0;
+    for (int k = 0; k < (sc->rtsp_tcp ? RTSP_TCP_BATCH : 1) && off < j.scan_len; k++){
+      uint8_t* h = rs.hdr[k];
+      size_t   n, pre = sc->rtsp_tcp ? 4 : 0;
+      size_t   hl = rtp_jpeg_fragment(h + pre, j, off, mtu, rs.seq++, ts, rs.ssrc, &n);
+      if (pre){ h[0] = '$'; h[1] = rs.ch; h[2] = (uint8_t)((hl + n) >> 8); h[3] = (uint8_t)(hl + n); }
+      iov[cnt++] = { h, pre + hl };
+      iov[cnt++] = { (void*)(j.scan + off), n };
+      off += n; total += pre + hl + n; segs++;
+    }
+    if (sc->rtsp_tcp){ uint32_t s = 0; ok = sock_sendv_all(sc->client.fd(), iov, cnt, deadline, &budget, &pending, &calls, &s); continue; }
+
+    struct msghdr m = {};
+    m.msg_name = &rs.peer; m.msg_namelen = sizeof(rs.peer);
+    m.msg_iov = iov; m.msg_iovlen = cnt;
+    int tries = 0;
+    while (sendmsg(rs.rtp, &m, MSG_DONTWAIT) < 0){
+      if ((errno != EAGAIN && errno != EWOULDBLOCK && errno != ENOMEM && errno != ENOBUFS) || ++tries > 3){
+        uint32_t left = (j.scan_len - off + mtu - 1) / mtu + 1;  // this packet and the rest of the frame
+        portENTER_CRITICAL(&streamsMux);
+        sc->lost += left;
+        portEXIT_CRITICAL(&streamsMux);
+        rs.seq += left - 1;                               // receivers see the gap
+        off = j.scan_len;
+        break;
+      }
+      vTaskDelay(1);                                      // pbufs / Wi-Fi queue full: let it drain
+    }
+    calls++;
+  }
+  int64_t t1 = esp_timer_get_time();
+  TRACE_SPAN("rtsp_write", t0, t1, total);
+  if (ok) boot_served();
+  stream_account(sc, f, t1 - t0, total, pending, calls, segs);
+  return ok;
+}
+
+// Session task (NET_CORE): answers requests and, while playing, sends the
+// newest frame; the mailbox is only a wakeup, as for /ws/stream.
+static void rtsp_task(void* arg){
+  StreamClient* sc = (StreamClient*)arg;
+  stream_attach(sc);
+  RtspSession*  rs = new (std::nothrow) RtspSession;
+  if (!rs){ LOGW(TAG, "rtsp session alloc failed"); stream_close(sc, nullptr); vTaskDelete(nullptr); return; }
+  rs->rtp = rs->rtcp = -1;
+  rs->playing = false; rs->skip = rs->bad = 0; rs->rn = 0; rs->ch = 0;
+  rs->seq = (uint16_t)esp_random(); rs->ssrc = esp_random(); rs->id = esp_random(); rs->ts_base = esp_random();
+  rs->last_rx = esp_timer_get_time();
+  bool ok = true;
+  while (ok && sc->client.connected()){
+    if (!rtsp_rx(sc, *rs)) break;
+    uint8_t d[64];
+    if (rs->rtcp >= 0) while (recv(rs->rtcp, d, sizeof(d), MSG_DONTWAIT) > 0) rs->last_rx = esp_timer_get_time();
+    if (!sc->rtsp_tcp && esp_timer_get_time() - rs->last_rx > RTSP_TIMEOUT_S * 1000000LL){ LOGI(TAG, "rtsp: session timeout"); break; }
+
+    FrameSlot* f;
+    while (sc->q.pop(f)) frames.release(f);
+    f = rs->playing ? frames.acquireLatest(sc->last_seq) : nullptr;
+    if (f){
+      ok = rtsp_send_frame(sc, *rs, f);
+      stream_mark_sent(sc, f);
+      frames.release(f);
+      continue;
+    }
+    if (rs->playing){ ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(100)); continue; }
+    int fd = sc->client.fd();
+    fd_set rf; FD_ZERO(&rf); FD_SET(fd, &rf);
+    struct timeval tv = { 0, 100000 };
+    select(fd + 1, &rf, nullptr, nullptr, &tv);
+  }
+  rtsp_udp_close(*rs);
+  delete rs;
+  stream_close(sc, nullptr);
+  vTaskDelete(nullptr);
+}
+
+// Accepts RTSP connections; each gets a viewer slot and its own task.
+static void rtsp_listen_task(void*){
+  int64_t t0 = esp_timer_get_time();
+  int lfd = socket(AF_INET, SOCK_STREAM, 0);
+  int one = 1;
+  setsockopt(lfd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+  sockaddr_in a = {}; a.sin_family = AF_INET; a.sin_port = htons(RTSP_PORT); a.sin_addr.s_addr = htonl(INADDR_ANY);
+  if (lfd < 0 || bind(lfd, (sockaddr*)&a, sizeof(a)) < 0 || listen(lfd, 2) < 0){
+    LOGE(TAG, "rtsp: cannot listen on port %d", RTSP_PORT);
+    if (lfd >= 0) close(lfd);
+    vTaskDelete(nullptr);
+    return;
+  }
+  boot_stage("rtsp_listen", t0);
+  for (;;){
+    int fd = accept(lfd, nullptr, nullptr);
+    if (fd < 0){ vTaskDelay(pdMS_TO_TICKS(100)); continue; }
+    WiFiClient client(fd);
+    StreamClient* sc = cam_ready ? stream_claim() : nullptr;
+    if (!sc){
+      client.print("RTSP/1.0 503 Service Unavailable\r\nCSeq: 0\r\n\r\n");
+      client.stop();
+      continue;
+    }
+    sc->ws = false; sc->rtsp = true; sc->rtsp_tcp = false; sc->live = true; sc->fps = 0;
+    stream_start(sc, client, rtsp_task, "rtsp");
+  }
+}
+
+// -------------------- HTTP: /metrics (Prometheus text) --------------------
+static void metrics_histo(ChunkedOut& m, const char* name, const char* help, const Histo& h){
+  m.printf("# HELP %s %s\n# TYPE %s histogram\n", name, help, name);
+  uint32_t cum = 0;
+  for (int i=0;i<HISTO_BUCKETS;i++){
+    cum += h.counts[i];
+    m.printf("%s_bucket{le=\"%g\"} %u\n", name, h.le_us[i] / 1e6, (unsigned)cum);
+  }
+  cum += h.counts[HISTO_BUCKETS];
+  m.printf("%s_bucket{le=\"+Inf\"} %u\n%s_sum %.6f\n%s_count %u\n",
+           name, (unsigned)cum, name, h.sum_us / 1e6, name, (unsigned)h.n);
+}
+
+static void handleMetrics(){
+  ChunkedOut m;
+  server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+  server.send(200, "text/plain; version=0.0.4", "");
+
+  m.printf("# TYPE nozzlecam_up gauge\nnozzlecam_up %d\n", cam_ready ? 1 : 0);
+  m.printf("# TYPE nozzlecam_uptime_seconds gauge\nnozzlecam_uptime_seconds %.3f\n", esp_timer_get_time() / 1e6);
+  m.printf("# HELP nozzlecam_capture_fps Frames published per second (1 s window).\n"
+           "# TYPE nozzlecam_capture_fps gauge\nnozzlecam_capture_fps %.1f\n", cap_fps_x10 / 10.0);
+  m.printf("# TYPE nozzlecam_capture_frames_total counter\nnozzlecam_capture_frames_total %u\n",
+           (unsigned)frames.latestSeq());
+  m.printf("# HELP nozzlecam_capture_drops_total Captures discarded because every ring slot was busy.\n"
+           "# TYPE nozzlecam_capture_drops_total counter\nnozzlecam_capture_drops_total %u\n", (unsigned)cap_drops);
+  m.printf("# TYPE nozzlecam_fb_get_null_total counter\nnozzlecam_fb_get_null_total %u\n", (unsigned)m_fb_null);
+  metrics_histo(m, "nozzlecam_fb_get_seconds", "esp_camera_fb_get() latency.", m_fbget);
+  metrics_histo(m, "nozzlecam_frame2jpg_seconds", "Software JPEG encode time.", m_encode);
+  m.printf("# TYPE nozzlecam_reinit_total counter\nnozzlecam_reinit_total %u\n", (unsigned)m_reinits);
+  m.printf("# TYPE nozzlecam_reinit_failures_total counter\nnozzlecam_reinit_failures_total %u\n", (unsigned)m_reinit_fail);
+  {
+    HealthMon h;
+    portENTER_CRITICAL(&hwMux);
+    h = HW;
+    portEXIT_CRITICAL(&hwMux);
+    int64_t out = h.down ? esp_timer_get_time() - h.cur.t0_us : 0;
+    m.printf("# HELP nozzlecam_camera_up 1 while frames arrive (health monitor).\n"
+             "# TYPE nozzlecam_camera_up gauge\nnozzlecam_camera_up %d\n"
+             "# TYPE nozzlecam_camera_outages_total counter\nnozzlecam_camera_outages_total %u\n"
+             "# TYPE nozzlecam_camera_recoveries_total counter\nnozzlecam_camera_recoveries_total %u\n"
+             "# HELP nozzlecam_camera_downtime_seconds_total Time without frames across outages, the current one included.\n"
+             "# TYPE nozzlecam_camera_downtime_seconds_total counter\nnozzlecam_camera_downtime_seconds_total %.3f\n",
+             h.down ? 0 : 1, (unsigned)h.outages, (unsigned)h.attempts, (h.down_us + out) / 1e6);
+  }
+  m.printf("# HELP nozzlecam_camera_xclk_hz Sensor clock in use (XCLK_HZ, calibrated or default).\n"
+           "# TYPE nozzlecam_camera_xclk_hz gauge\nnozzlecam_camera_xclk_hz %d\n"
+           "# TYPE nozzlecam_camera_fb_count gauge\nnozzlecam_camera_fb_count %d\n", XCLK_HZ, FB_COUNT);
+
+  uint64_t txb; uint32_t txf, txd;
+  portENTER_CRITICAL(&streamsMux);
+  txb = m_tx_bytes; txf = m_tx_frames; txd = m_tx_drops;
+  portEXIT_CRITICAL(&streamsMux);
+  m.printf("# TYPE nozzlecam_stream_bytes_total counter\nnozzlecam_stream_bytes_total %llu\n", (unsigned long long)txb);
+  m.printf("# TYPE nozzlecam_stream_frames_total counter\nnozzlecam_stream_frames_total %u\n", (unsigned)txf);
+  m.printf("# HELP nozzlecam_stream_drops_total Published frames a viewer never received.\n"
+           "# TYPE nozzlecam_stream_drops_total counter\nnozzlecam_stream_drops_total %u\n", (unsigned)txd);
+
+  // Snapshot once, then emit each per-client family as one contiguous group.
+  struct { int id; const char* mode; uint64_t v[3]; } cl[MAX_STREAM_CLIENTS];
+  int active = 0;
+  for (int i=0;i<MAX_STREAM_CLIENTS;i++){
+    StreamClient& sc = streams[i];
+    portENTER_CRITICAL(&streamsMux);
+    if (sc.used && sc.task) cl[active++] = { i, stream_mode(sc), { sc.bytes, sc.sent, sc.drops } };
+    portEXIT_CRITICAL(&streamsMux);
+  }
+  m.printf("# TYPE nozzlecam_stream_clients gauge\nnozzlecam_stream_clients %d\n", active);
+  static const char* const CLIENT_FAMILY[3] = { "bytes", "frames", "drops" };
+  for (int k=0;k<3;k++){
+    m.printf("# TYPE nozzlecam_client_%s_total counter\n", CLIENT_FAMILY[k]);
+    for (int j=0;j<active;j++)
+      m.printf("nozzlecam_client_%s_total{client=\"%d\",mode=\"%s\"} %llu\n",
+               CLIENT_FAMILY[k], cl[j].id, cl[j].mode, (unsigned long long)cl[j].v[k]);
+  }
+
+  const uint32_t INT = MALLOC_CAP_8BIT | MALLOC_CAP_INTERNAL;
+  m.printf("# TYPE nozzlecam_heap_free_bytes gauge\n"
+           "nozzlecam_heap_free_bytes{region=\"internal\"} %u\nnozzlecam_heap_free_bytes{region=\"psram\"} %u\n",
+           (unsigned)heap_caps_get_free_size(INT), (unsigned)heap_caps_get_free_size(MALLOC_CAP_SPIRAM));
+  m.printf("# HELP nozzlecam_heap_min_free_bytes Low-water mark of free heap since boot.\n"
+           "# TYPE nozzlecam_heap_min_free_bytes gauge\n"
+           "nozzlecam_heap_min_free_bytes{region=\"internal\"} %u\nnozzlecam_heap_min_free_bytes{region=\"psram\"} %u\n",
+           (unsigned)heap_caps_get_minimum_free_size(INT), (unsigned)heap_caps_get_minimum_free_size(MALLOC_CAP_SPIRAM));
+  m.printf("# TYPE nozzlecam_heap_largest_free_block_bytes gauge\n"
+           "nozzlecam_heap_largest_free_block_bytes{region=\"internal\"} %u\n",
+           (unsigned)heap_caps_get_largest_free_block(INT));
+  ClipRing::Stats cs = clips.stats();
+  m.printf("# HELP nozzlecam_clip_seconds Span of the pre-event buffer.\n"
+           "# TYPE nozzlecam_clip_seconds gauge\nnozzlecam_clip_seconds %.1f\n", (cs.newest_us - cs.oldest_us) / 1e6);
+  m.printf("# TYPE nozzlecam_clip_bytes gauge\nnozzlecam_clip_bytes %u\n", (unsigned)cs.bytes);
+  m.printf("# TYPE nozzlecam_clip_dropped_total counter\nnozzlecam_clip_dropped_total %u\n", (unsigned)cs.dropped);
+  uint32_t mev[3], msc; uint16_t mscore = 0;
+  portENTER_CRITICAL(&motionMux);
+  memcpy(mev, MD.ev_count, sizeof(mev)); msc = MD.scores;
+  if (msc) mscore = MD.hist[(msc - 1) % MOTION_HIST].changed;
+  portEXIT_CRITICAL(&motionMux);
+  m.printf("# HELP nozzlecam_motion_score Pixels changed since the previous analysed frame, per mille.\n"
+           "# TYPE nozzlecam_motion_score gauge\nnozzlecam_motion_score %u\n", mscore);
+  m.printf("# TYPE nozzlecam_motion_frames_total counter\nnozzlecam_motion_frames_total %u\n", (unsigned)msc);
+  m.printf("# TYPE nozzlecam_motion_events_total counter\n");
+  for (int k=0;k<3;k++) m.printf("nozzlecam_motion_events_total{type=\"%s\"} %u\n", MOTION_EVT_NAME[k], (unsigned)mev[k]);
+  uint32_t tls, tlf, tll, tlg;
+  portENTER_CRITICAL(&tlMux);
+  tls = TL.shots; tlf = TL.failed; tll = TL.lat_last; tlg = TL.gap_last;
+  portEXIT_CRITICAL(&tlMux);
+  m.printf("# TYPE nozzlecam_timelapse_shots_total counter\nnozzlecam_timelapse_shots_total %u\n", (unsigned)tls);
+  m.printf("# TYPE nozzlecam_timelapse_failures_total counter\nnozzlecam_timelapse_failures_total %u\n", (unsigned)tlf);
+  m.printf("# HELP nozzlecam_timelapse_latency_seconds Trigger to full-resolution frame captured, last shot.\n"
+           "# TYPE nozzlecam_timelapse_latency_seconds gauge\nnozzlecam_timelapse_latency_seconds %.3f\n", tll / 1e6);
+  m.printf("# HELP nozzlecam_timelapse_stream_gap_seconds Stream frame gap around the last shot.\n"
+           "# TYPE nozzlecam_timelapse_stream_gap_seconds gauge\nnozzlecam_timelapse_stream_gap_seconds %.3f\n", tlg / 1e6);
+  m.printf("# TYPE nozzlecam_jpg_responses_total counter\n"
+           "nozzlecam_jpg_responses_total{code=\"200\"} %u\nnozzlecam_jpg_responses_total{code=\"304\"} %u\n"
+           "nozzlecam_jpg_responses_total{code=\"504\"} %u\n",
+           (unsigned)snap.ok, (unsigned)snap.not_modified, (unsigned)snap.timeouts);
+  m.printf("# HELP nozzlecam_jpg_snapshot_copies_total Ring frames copied into the /jpg snapshot cache.\n"
+           "# TYPE nozzlecam_jpg_snapshot_copies_total counter\nnozzlecam_jpg_snapshot_copies_total %u\n", (unsigned)snap.fills);
+  m.printf("# TYPE nozzlecam_wifi_stations gauge\nnozzlecam_wifi_stations %u\n", (unsigned)WiFi.softAPgetStationNum());
+  m.flush();
+}
+
+// -------------------- HTTP: /trace (Chrome trace_event JSON) --------------------
+// pid = core, tid = task. ?clear=1 empties the ring after the dump.
+static void handleTrace(){
+#if TRACE_ENABLE
+  ChunkedOut o;
+  server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+  server.sendHeader("Content-Disposition", "inline; filename=\"nozzlecam-trace.json\"");
+  server.send(200, "application/json", "");
+
+  o.printf("{\"displayTimeUnit\":\"ms\",\"otherData\":{\"recorded\":%u,\"capacity\":%u},\"traceEvents\":[",
+           (unsigned)tracer.recorded(), (unsigned)tracer.capacity());
+  o.printf("{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%d,\"args\":{\"name\":\"PRO_CPU\"}},"
+           "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%d,\"args\":{\"name\":\"APP_CPU\"}}",
+           PRO_CPU_NUM, APP_CPU_NUM);
+  auto thread_name = [&](TaskHandle_t t, int core, const char* name, int idx){
+    if (t) o.printf(",{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":%u,\"args\":{\"name\":\"%s%.0d\"}}",
+                    core, (unsigned)(uintptr_t)t, name, idx);
+  };
+  thread_name(captureTask, CAPTURE_CORE, "capture", 0);
+  thread_name(healthTask, NET_CORE, "camwd", 0);
+#ifdef USE_ST7789
+  thread_name(previewTask, CAPTURE_CORE, "preview", 0);
+#endif
+  thread_name(xTaskGetCurrentTaskHandle(), xPortGetCoreID(), "http", 0);
+  for (int i=0;i<MAX_STREAM_CLIENTS;i++) thread_name(streams[i].task, NET_CORE, "stream#", i + 1);
+
+  Span sp;
+  for (size_t i = 0, n = tracer.count(); i < n && tracer.get(i, sp); i++){
+    o.printf(",{\"name\":\"%s\",\"ph\":\"X\",\"ts\":%lld,\"dur\":%u,\"pid\":%u,\"tid\":%u,\"args\":{\"v\":%u}}",
+             sp.name, (long long)sp.ts_us, (unsigned)sp.dur_us, (unsigned)sp.core, (unsigned)sp.tid, (unsigned)sp.arg);
+  }
+  o.printf("]}");
+  o.flush();
+  if (server.arg("clear") == "1") tracer.clear();
+#else
+  server.send(501, "text/plain", "tracing compiled out (LOG_LEVEL 0)");
+#endif
+}
+
+// -------------------- HTTP: /motion (scores + events) --------------------
+// /motion?since=ID: state, the last MOTION_HIST per-frame scores (oldest
+// first: [seq, t_ms, changed per mille, mean abs diff]) and the events with
+// id > ID, so a poller passes back the last id it saw.
+static void handleMotion(){
+  uint32_t since = (uint32_t)server.arg("since").toInt();
+  MotionStats m;
+  portENTER_CRITICAL(&motionMux);
+  m = MD;
+  portEXIT_CRITICAL(&motionMux);
+
+  ChunkedOut o;
+  server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+  server.send(200, "application/json", "");
+  const MotionScore* last = m.scores ? &m.hist[(m.scores - 1) % MOTION_HIST] : nullptr;
+  o.printf("{\"enabled\":%s,\"active\":%s,\"state\":\"%s\",\"w\":%u,\"h\":%u,\"kernel\":\"swar\","
+           "\"decode_ms\":%.2f,\"diff_ms\":%.3f,\"score\":%u,\"mad\":%.1f,\"thr\":%u,\"jump\":%u,\"still_s\":%u,"
+           "\"counts\":{\"motion\":%u,\"still\":%u,\"scene\":%u},\"last_id\":%u,\"scores\":[",
+           S.md ? "true" : "false", m.active ? "true" : "false", MOTION_ST_NAME[m.state], m.w, m.h,
+           m.decode_us / 1000.0, m.diff_us / 1000.0, last ? last->changed : 0, last ? last->mad_x10 / 10.0 : 0.0,
+           S.md_thr, S.md_jump, S.md_still_s,
+           (unsigned)m.ev_count[ME_MOTION], (unsigned)m.ev_count[ME_STILL], (unsigned)m.ev_count[ME_SCENE], (unsigned)m.events);
+  uint32_t first = m.scores > MOTION_HIST ? m.scores - MOTION_HIST : 0;
+  for (uint32_t i = first; i < m.scores; i++){
+    const MotionScore& e = m.hist[i % MOTION_HIST];
+    o.printf("%s[%u,%u,%u,%.1f]", i == first ? "" : ",", (unsigned)e.seq, (unsigned)(e.ts_us / 1000), e.changed, e.mad_x10 / 10.0);
+  }
+  o.printf("],\"events\":[");
+  uint32_t from = max<uint32_t>(since, m.events > MOTION_EVENTS ? m.events - MOTION_EVENTS : 0);
+  for (uint32_t id = from + 1; id <= m.events; id++){
+    const MotionEvent& e = m.ev[(id - 1) % MOTION_EVENTS];
+    o.printf("%s{\"id\":%u,\"type\":\"%s\",\"seq\":%u,\"t_ms\":%u,\"score\":%u}", id == from + 1 ? "" : ",",
+             (unsigned)e.id, MOTION_EVT_NAME[e.type], (unsigned)e.seq, (unsigned)(e.ts_us / 1000), e.score);
+  }
+  o.printf("]}");
+  o.flush();
+}
+
+// -------------------- HTTP: /trigger, /timelapse --------------------
+// /trigger queues a full-resolution shot (202); with ?wait=1 it answers once
+// the shot is stored and the stream has resumed, with the measured latency.
+static void handleTrigger(){
+  if (!S.tl_kb){ server.send(503, "text/plain", "timelapse store disabled"); return; }
+  if (!cam_ready){ server.send(503, "text/plain", "cam not ready"); return; }
+  bool merged;
+  uint32_t id = tl_trigger(TL_SRC_HTTP, &merged);
+  char buf[256];
+  if (server.arg("wait") != "1"){
+    snprintf(buf, sizeof(buf), "{\"id\":%u,\"merged\":%s,\"pending\":true}", (unsigned)id, merged ? "true" : "false");
+    server.send(202, "application/json", buf);
+    return;
+  }
+  int64_t until = esp_timer_get_time() + TL_WAIT_MS * 1000LL;
+  while (((int32_t)(TL.done - id) < 0 || TL.gap_open) && esp_timer_get_time() < until) delay(5);
+  if ((int32_t)(TL.done - id) < 0){
+    snprintf(buf, sizeof(buf), "{\"id\":%u,\"merged\":%s,\"pending\":true,\"error\":\"timeout\"}", (unsigned)id, merged ? "true" : "false");
+    server.send(504, "application/json", buf);
+    return;
+  }
+  TlShot r;
+  portENTER_CRITICAL(&tlMux);
+  r = TL.last;
+  portEXIT_CRITICAL(&tlMux);
+  snprintf(buf, sizeof(buf),
+           "{\"id\":%u,\"merged\":%s,\"ok\":%s,\"n\":%u,\"w\":%u,\"h\":%u,\"bytes\":%u,\"latency_ms\":%.1f,\"gap_ms\":%.1f}",
+           (unsigned)id, merged ? "true" : "false", r.ok ? "true" : "false", (unsigned)r.n, r.w, r.h,
+           (unsigned)r.len, r.lat_us / 1000.0, r.gap_us / 1000.0);
+  server.send(r.ok ? 200 : 500, "application/json", buf);
+}
+
+// /timelapse: settings, counters and the shots still in the store, oldest first.
+static void handleTimelapse(){
+  uint32_t shots, failed, merged, full, lat_last, lat_max, gap_last, gap_max;
+  uint64_t lat_sum;
+  bool     pending;
+  portENTER_CRITICAL(&tlMux);
+  shots = TL.shots; failed = TL.failed; merged = TL.coalesced; full = TL.store_full;
+  lat_last = TL.lat_last; lat_max = TL.lat_max; lat_sum = TL.lat_sum; gap_last = TL.gap_last; gap_max = TL.gap_max;
+  pending = TL.req != TL.done;
+  portEXIT_CRITICAL(&tlMux);
+  ClipRing::Stats st = tl_store.stats();
+
+  ChunkedOut o;
+  server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+  server.send(200, "application/json", "");
+  o.printf("{\"interval_s\":%u,\"store_kb\":%u,\"size\":\"%s\",\"pending\":%s,\"shots\":%u,\"failed\":%u,\"merged\":%u,\"store_full\":%u,",
+           S.tl_s, S.tl_kb, framesizeName((framesize_t)cam_fs_cap), pending ? "true" : "false",
+           (unsigned)shots, (unsigned)failed, (unsigned)merged, (unsigned)full);
+  o.printf("\"latency_ms\":{\"last\":%.1f,\"avg\":%.1f,\"max\":%.1f},\"gap_ms\":{\"last\":%.1f,\"max\":%.1f},"
+           "\"store\":{\"frames\":%u,\"used_kb\":%u,\"busy\":%s},\"frames\":[",
+           lat_last / 1000.0, shots ? lat_sum / 1000.0 / shots : 0.0, lat_max / 1000.0, gap_last / 1000.0, gap_max / 1000.0,
+           (unsigned)st.frames, (unsigned)(st.bytes / 1024), st.pinned ? "true" : "false");
+  bool first = true;
+  for (uint32_t k = shots > TL_SHOTS ? shots - TL_SHOTS : 0; k < shots; k++){
+    TlShot e;
+    portENTER_CRITICAL(&tlMux);
+    e = TL.hist[k % TL_SHOTS];
+    portEXIT_CRITICAL(&tlMux);
+    ClipFrame f;
+    if (!tl_store.peek(e.n, &f) || f.ts_us != e.ts_us) continue;     // evicted
+    o.printf("%s{\"n\":%u,\"id\":%u,\"src\":\"%s\",\"t_ms\":%u,\"w\":%u,\"h\":%u,\"bytes\":%u,\"latency_ms\":%.1f,\"gap_ms\":%.1f}",
+             first ? "" : ",", (unsigned)e.n, (unsigned)e.id, TL_SRC_NAMES[e.src], (unsigned)(e.ts_us / 1000),
+             e.w, e.h, (unsigned)e.len, e.lat_us / 1000.0, e.gap_us / 1000.0);
+    first = false;
+  }
+  o.printf("]}");
+  o.flush();
+}
+
+// /timelapse.jpg?n=N: one stored shot (default: the newest).
+static void handleTimelapseJpg(){
+  uint32_t first, end;
+  tl_store.range(&first, &end);
+  uint32_t n = server.hasArg("n") ? (uint32_t)server.arg("n").toInt() : end - 1;
+  ClipFrame e;
+  if (!tl_store.peek(n, &e)){ server.send(404, "text/plain", "no such frame"); return; }
+  uint32_t at;
+  const uint8_t* p;
+  if (!tl_store.pin(e.ts_us, &at)){ server.send(503, "text/plain", "timelapse store busy"); return; }
+  if (at != n || !tl_store.get(n, &p, &e)){ tl_store.unpin(); server.send(404, "text/plain", "no such frame"); return; }
+
+  char ts[24];
+  snprintf(ts, sizeof(ts), "%u.%06u", (unsigned)(e.ts_us / 1000000), (unsigned)(e.ts_us % 1000000));
+  server.sendHeader("X-Timestamp", ts);
+  server.setContentLength(e.len);
+  server.send(200, "image/jpeg", "");
+  server.client().write(p, e.len);
+  tl_store.unpin();
+}
+
+// /timelapse.mjpeg?from=N: every stored shot from N on, as concatenated JPEGs.
+static void handleTimelapseMjpeg(){
+  if (tl_busy){ server.send(503, "text/plain", "timelapse download in progress"); return; }
+  uint32_t first, end;
+  tl_store.range(&first, &end);
+  uint32_t from = server.hasArg("from") ? (uint32_t)server.arg("from").toInt() : first;
+  if ((int32_t)(from - first) < 0) from = first;
+  ClipFrame e;
+  if (!tl_store.peek(from, &e)){ server.send(404, "text/plain", "no timelapse frames"); return; }
+  if (!tl_store.pin(e.ts_us, &tlJob.next)){ server.send(503, "text/plain", "timelapse store busy"); return; }
+  tlJob.t_end = esp_timer_get_time();
+  clip_start(tlJob, "nozzlecam-timelapse.mjpeg");
+}
+
+// -------------------- HTTP: /calibrate (XCLK / FB_COUNT self-benchmark) --------------------
+// GET: the last run, candidate by candidate. POST: start a run (about
+// CAL_N * (CAL_WINDOW_MS + reinit)); ?boot=1|0 also sets whether every boot
+// starts with one.
+static void handleCalibrate(){
+  if (server.method() == HTTP_POST){
+    if (server.hasArg("boot")){
+      CAL.boot = server.arg("boot") == "1";
+      Preferences p;
+      p.begin("cam", false);
+      p.putBool("cal_boot", CAL.boot);
+      p.end();
+    }
+    if (!cam_ready && !CAL.active){ server.send(503, "text/plain", "cam not ready"); return; }
+    bool running = CAL.active || CAL.req;
+    CAL.req = true;
+    char buf[128];
+    snprintf(buf, sizeof(buf), "{\"pending\":true,\"running\":%s,\"boot\":%s,\"candidates\":%d,\"seconds\":%d}",
+             running ? "true" : "false", CAL.boot ? "true" : "false", CAL_N, CAL_N * (CAL_WINDOW_MS + 500) / 1000);
+    server.send(202, "application/json", buf);
+    return;
+  }
+
+  Calib c;
+  portENTER_CRITICAL(&calMux);
+  c = CAL;
+  portEXIT_CRITICAL(&calMux);
+  ChunkedOut o;
+  server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+  server.send(200, "application/json", "");
+  o.printf("{\"active\":%s,\"pending\":%s,\"boot\":%s,\"runs\":%u,\"xclk_mhz\":%g,\"fb_count\":%d,\"stack_free\":%u,",
+           c.active ? "true" : "false", c.req ? "true" : "false", c.boot ? "true" : "false", (unsigned)c.runs,
+           XCLK_HZ / 1e6, FB_COUNT, (unsigned)cap_stack_free);
+  if (c.have_saved)
+    o.printf("\"saved\":{\"fs\":\"%s\",\"xclk_mhz\":%g,\"fb_count\":%u,\"fps\":%.1f,\"in_use\":%s},",
+             framesizeName((framesize_t)c.saved.fs), c.saved.xclk / 1e6, c.saved.fb, c.saved.fps_x10 / 10.0,
+             c.saved.fs == S.fs ? "true" : "false");
+  else o.printf("\"saved\":null,");
+  o.printf("\"fs\":\"%s\",\"seconds\":%.1f,\"results\":[",
+           c.runs || c.active ? framesizeName((framesize_t)c.fs) : "",
+           c.t_start ? ((c.t_done ? c.t_done : esp_timer_get_time()) - c.t_start) / 1e6 : 0.0);
+  for (int i=0;i<c.n;i++){
+    const CalResult& r = c.res[i];
+    o.printf("%s{\"xclk_mhz\":%g,\"fb_count\":%u,\"init\":%s,\"fps\":%.1f,\"jitter_ms\":%.2f,\"max_ms\":%.1f,"
+             "\"frames\":%u,\"fb_fail\":%u,\"best\":%s}",
+             i ? "," : "", r.xclk / 1e6, r.fb, r.init_ok ? "true" : "false", r.fps_x10 / 10.0,
+             r.jitter_us / 1000.0, r.max_us / 1000.0, (unsigned)r.frames, (unsigned)r.fails,
+             i == c.best && !c.active ? "true" : "false");
+  }
+  o.printf("]}");
+  o.flush();
+}
+
+// -------------------- HTTP: /boot (startup timeline) --------------------
+static void handleBoot(){
+  int64_t ff = boot_first_frame_us, fs = boot_first_served_us;
+  ChunkedOut o;
+  server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+  server.send(200, "application/json", "");
+  o.printf("{\"setup_start_ms\":%.1f,\"stages\":[", boot_setup_us / 1000.0);
+  portENTER_CRITICAL(&bootMux);
+  uint8_t cnt = boot_n;
+  portEXIT_CRITICAL(&bootMux);
+  for (uint8_t i=0;i<cnt;i++){
+    const BootStage& b = boot_stages[i];
+    o.printf("%s{\"name\":\"%s\",\"start_ms\":%.1f,\"ms\":%.1f,\"core\":%u}",
+             i ? "," : "", b.name, b.t0_us / 1000.0, (b.t1_us - b.t0_us) / 1000.0, b.core);
+  }
+  o.puts("],\"first_frame_ms\":");
+  if (ff) o.printf("%.1f", ff / 1000.0); else o.puts("null");
+  o.puts(",\"first_served_ms\":");
+  if (fs) o.printf("%.1f", fs / 1000.0); else o.puts("null");
+  o.printf(",\"capture_stack_free\":%u}", (unsigned)cap_stack_free);
+  o.flush();
+}
+
+// -------------------- Setup --------------------
+// Stages that wait on hardware run concurrently: the capture task initialises
+// the camera on APP_CPU and the preview task the TFT, while this core brings up
+// Wi-Fi, the HTTP listener, DNS and mDNS.
+void setup(){
+  boot_setup_us = esp_timer_get_time();
+  boot_id = esp_random();
+#if TRACE_ENABLE
+  if (!tracer.begin(TRACE_SPANS)) LOGW(TAG, "trace ring alloc failed");
+#endif
+  int64_t t = esp_timer_get_time();
+  Serial.begin(115200);
+  delay(150);
+  boot_stage("serial", t);
+
+  t = esp_timer_get_time();
+  if (nvs_flash_init()!=ESP_OK){ nvs_flash_erase(); nvs_flash_init(); }
+  loadSettings(S);
+  cal_load();
+  xTaskCreatePinnedToCore(settings_task, "settings", 4096, nullptr, 1, &settingsTask, NET_CORE);
+  boot_stage("nvs", t);
+
+  camLock = xSemaphoreCreateMutex();
+  xTaskCreatePinnedToCore(capture_task, "capture", CAM_INIT_STACK, nullptr, 3, &captureTask, CAPTURE_CORE);
+#ifdef USE_ST7789
+  xTaskCreatePinnedToCore(preview_task, "preview", 6144, nullptr, 1, &previewTask, CAPTURE_CORE);
+#endif
+  xTaskCreatePinnedToCore(motion_task, "motion", 4096, nullptr, 1, nullptr, CAPTURE_CORE);
+  xTaskCreatePinnedToCore(health_task, "camwd", HW_STACK, nullptr, 1, &healthTask, NET_CORE);
+
+  // Routes
+  t = esp_timer_get_time();
+  for (size_t i=0;i<WEB_ASSET_COUNT;i++){
+    const WebAsset* a = &WEB_ASSETS[i];
+    server.on(a->path, HTTP_GET, [a](){ serveAsset(*a); });
+  }
+  static const char* HDRS[] = { "If-None-Match", "Upgrade", "Sec-WebSocket-Key", "Sec-WebSocket-Version" };
+  server.collectHeaders(HDRS, 4);
+  server.on("/settings",     HTTP_GET,  [](){ handleSettingsGet(); });
+  server.on("/settings",     HTTP_POST, [](){ handleSettingsPost(); });
+  server.on("/api/settings", HTTP_GET,  [](){ handleApiGet(); });
+  server.on("/api/settings", HTTP_POST, [](){ handleApiPost(); });
+  server.on("/health",       HTTP_GET, handleHealth);
+  server.on("/reinit",       HTTP_GET, handleReinit);
+  server.on("/jpg",          HTTP_GET, handleJpg);
+  server.on("/stream",       HTTP_GET, handleStream);
+  server.on("/ws/stream",    HTTP_GET, handleWsStream);
+  server.on("/api/streams",  HTTP_GET, handleStreams);
+  server.on("/metrics",      HTTP_GET, handleMetrics);
+  server.on("/trace",        HTTP_GET, handleTrace);
+  server.on("/clip",         HTTP_GET, handleClip);
+  server.on("/record.avi",   HTTP_GET, handleRecord);
+  server.on("/record/stop",  HTTP_GET, handleRecordStop);
+  server.on("/boot",         HTTP_GET, handleBoot);
+  server.on("/motion",       HTTP_GET, handleMotion);
+  server.on("/trigger",      HTTP_ANY, handleTrigger);
+  server.on("/timelapse",    HTTP_GET, handleTimelapse);
+  server.on("/timelapse.jpg",   HTTP_GET, handleTimelapseJpg);
+  server.on("/timelapse.mjpeg", HTTP_GET, handleTimelapseMjpeg);
+  server.on("/calibrate",     HTTP_ANY, handleCalibrate);
+  boot_stage("routes", t);
+
+  t = esp_timer_get_time();
+  WiFi.mode(WIFI_AP);                              // brings up lwIP: the listener can open now
+  boot_stage("wifi_init", t);
+  t = esp_timer_get_time();
+  server.begin();
+  boot_stage("http_listen", t);
+  xTaskCreatePinnedToCore(rtsp_listen_task, "rtsp", 3072, nullptr, 1, nullptr, NET_CORE);
+
+  t = esp_timer_get_time();
+  bool ap_ok = WiFi.softAP(AP_SSID, AP_PASSWORD, AP_CHANNEL, false, 4);
+  IPAddress ip = WiFi.softAPIP();
+  boot_stage("softap", t);
+#ifdef USE_ST7789
+  xTaskNotifyGive(previewTask);                    // splash shows SSID + IP
+#endif
+
+  Serial.println(ap_ok ? "AP started." : "AP start failed!");
+  Serial.print("SSID: "); Serial.println(AP_SSID);
+  Serial.print("IP:   "); Serial.println(ip);
+
+  t = esp_timer_get_time();
+  dnsServer.start(DNS_PORT, "*", ip);
+  boot_stage("dns", t);
+  Serial.println("DNS server started (wildcard): http://nozzlecam/");
+
+  t = esp_timer_get_time();
+  if (MDNS.begin("nozzcam")) {
+    Serial.println("mDNS: http://nozzcam.local");
+  } else {
+    Serial.println("mDNS setup failed");
+  }
+  boot_stage("mdns", t);
 
   Serial.println("UI:       http://192.168.4.1");
-  Serial.println("Stream:   http://192.168.4.1/stream");
+  Serial.println("Stream:   http://192.168.4.1/stream  (low latency: /stream?mode=live&fps=10)");
   Serial.println("Settings: http://192.168.4.1/settings");
   Serial.println("Also try: http://nozzlecam/  or  http://nozzcam.local/");
+  boot_stage("setup", boot_setup_us);
 }
 
 // -------------------- Loop --------------------
@@ -0,0 +1,65 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+
+// Frame-difference kernels for the motion metric. Both compare two 8-bit
+// grayscale thumbnails of n bytes and return the sum of absolute differences
+// and the number of pixels that changed by more than `noise` (< 128).
+//
+// motion_diff_ref() is the per-byte reference. motion_diff_swar() handles four
+// pixels per 32-bit word with plain ALU ops (SIMD within a register), so it
+// runs on either core without PIE intrinsics; it must match the reference bit
+// for bit (native bench: program --motion). Buffers for the SWAR kernel are
+// 4-byte aligned and n is a multiple of 4.
+
+struct MotionDiff {
+  uint32_t sad;                  // sum of |a - b|
+  uint32_t changed;              // pixels with |a - b| > noise
+};
+
+inline MotionDiff motion_diff_ref(const uint8_t* a, const uint8_t* b, size_t n, uint8_t noise){
+  MotionDiff r = { 0, 0 };
+  for (size_t i = 0; i < n; i++){
+    int d = a[i] > b[i] ? a[i] - b[i] : b[i] - a[i];
+    r.sad += d;
+    r.changed += d > noise;
+  }
+  return r;
+}
+
+namespace motion_detail {
+
+const uint32_t H = 0x80808080u;
+
+// |a - b| in each byte lane.
+inline uint32_t absdiff4(uint32_t a, uint32_t b){
+  uint32_t d  = ((a | H) - (b & ~H)) ^ ((a ^ ~b) & H);    // a - b per lane, mod 256
+  uint32_t lt = ((~a & b) | (~(a ^ b) & d)) & H;         // lanes that borrowed: a < b
+  uint32_t m  = lt >> 7;
+  return (d ^ (m * 0xFF)) + m;                           // negate those lanes (d != 0 there: no carry out)
+}
+
+} // namespace motion_detail
+
+inline MotionDiff motion_diff_swar(const uint8_t* a, const uint8_t* b, size_t n, uint8_t noise){
+  using motion_detail::H;
+  const uint32_t* wa = (const uint32_t*)a;
+  const uint32_t* wb = (const uint32_t*)b;
+  const uint32_t  k  = (0x7Fu - noise) * 0x01010101u;    // lane + k sets bit 7 iff lane > noise (lane < 128)
+  MotionDiff r = { 0, 0 };
+  size_t words = n / 4;
+  while (words){
+    size_t   run = words < 128 ? words : 128;            // 16-bit lanes: 128 * 2 * 255 < 65536
+    uint32_t sad = 0, cnt = 0;
+    for (size_t i = 0; i < run; i++){
+      uint32_t d = motion_detail::absdiff4(wa[i], wb[i]);
+      sad += (d & 0x00FF00FF) + ((d >> 8) & 0x00FF00FF);
+      cnt += ((((d & ~H) + k) | d) & H) >> 7;            // one per changed lane (<= 128 per byte)
+    }
+    r.sad     += (sad & 0xFFFF) + (sad >> 16);
+    cnt        = (cnt & 0x00FF00FF) + ((cnt >> 8) & 0x00FF00FF);
+    r.changed += (cnt & 0xFFFF) + (cnt >> 16);
+    wa += run; wb += run; words -= run;
+  }
+  return r;
+}
@@ -0,0 +1,115 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+// RFC 2435 (RTP payload format for JPEG) for the camera's own baseline JPEGs.
+// rtp_jpeg_parse() finds what the payload format carries: the type (from the
+// luma sampling), the size in 8-pixel blocks, the 8-bit quantisation tables,
+// the restart interval and the entropy-coded scan. rtp_jpeg_fragment() writes
+// the RTP + JPEG headers of one packet. The scan is never copied: a packet is
+// its headers plus a pointer into the frame. Huffman tables are not sent; the
+// format assumes the standard ones (ITU T.81 Annex K), which the OV2640 uses.
+
+#define RTP_JPEG_PT      26                          // static payload type, 90 kHz clock
+#define RTP_HDR          12
+#define RTP_JPEG_MAX_HDR (RTP_HDR + 8 + 4 + 4 + 128) // RTP, JPEG, restart, quant header + 2 tables
+
+struct RtpJpeg {
+  uint8_t        type;                               // 0 = 4:2:2, 1 = 4:2:0; +64 with restart markers
+  uint8_t        w8, h8;                             // size in 8-pixel units
+  uint16_t       dri;                                // restart interval, 0 = none
+  const uint8_t* q[2];                               // luma, chroma tables (zig-zag, as in DQT)
+  const uint8_t* scan;                               // entropy-coded data after SOS, up to EOI
+  uint32_t       scan_len;
+};
+
+// False for anything RFC 2435 types 0/1 cannot describe (progressive, 12-bit,
+// 16-bit tables, odd sampling, larger than 2040 px).
+inline bool rtp_jpeg_parse(const uint8_t* p, size_t len, RtpJpeg* j){
+  memset(j, 0, sizeof(*j));
+  const uint8_t* qt[4] = {};
+  uint8_t        tq[3] = {};
+  bool           sof = false;
+  if (len < 4 || p[0] != 0xFF || p[1] != 0xD8) return false;
+  size_t i = 2;
+  for (;;){
+    if (i + 4 > len || p[i] != 0xFF) return false;
+    uint8_t m = p[i+1];
+    if (m == 0xFF){ i++; continue; }                          // fill byte
+    size_t seg = (size_t)p[i+2] << 8 | p[i+3];
+    const uint8_t* s = p + i + 4;
+    if (seg < 2 || i + 2 + seg > len) return false;
+    if (m == 0xDB){                                           // DQT: one or more tables
+      for (size_t k = 0; k + 65 <= seg - 2; k += 65){
+        if (s[k] >> 4) return false;                          // 16-bit precision
+        qt[s[k] & 3] = s + k + 1;
+      }
+    } else if (m == 0xC0){                                    // baseline SOF
+      if (seg != 17 || s[0] != 8 || s[5] != 3) return false;
+      uint16_t h = s[1] << 8 | s[2], w = s[3] << 8 | s[4];
+      if (!w || !h || w > 2040 || h > 2040) return false;
+      j->w8 = (uint8_t)((w + 7) / 8); j->h8 = (uint8_t)((h + 7) / 8);
+      if      (s[7] == 0x21) j->type = 0;
+      else if (s[7] == 0x22) j->type = 1;
+      else return false;
+      if (s[10] != 0x11 || s[13] != 0x11) return false;
+      tq[0] = s[8] & 3; tq[1] = s[11] & 3; tq[2] = s[14] & 3;
+      if (tq[1] != tq[2]) return false;
+      sof = true;
+    } else if (m >= 0xC1 && m <= 0xCF && m != 0xC4 && m != 0xC8 && m != 0xCC){
+      return false;                                           // extended, progressive, lossless
+    } else if (m == 0xDD){
+      if (seg != 4) return false;
+      j->dri = s[0] << 8 | s[1];
+    } else if (m == 0xDA){
+      i += 2 + seg;
+      break;
+    }
+    i += 2 + seg;
+  }
+  if (!sof || !qt[tq[0]] || !qt[tq[1]]) return false;
+  j->q[0] = qt[tq[0]]; j->q[1] = qt[tq[1]];
+  if (j->dri) j->type += 64;
+  size_t end = len;                                           // the driver may pad after EOI
+  while (end >= i + 2 && !(p[end-2] == 0xFF && p[end-1] == 0xD9)) end--;
+  if (end < i + 2) return false;
+  j->scan = p + i; j->scan_len = (uint32_t)(end - 2 - i);
+  return j->scan_len > 0;
+}
+
+// Headers of the packet carrying scan bytes from `off` into `hdr` (at least
+// RTP_JPEG_MAX_HDR bytes); returns their length. *n = scan bytes that fit an
+// `mtu`-byte packet; the RTP marker is set on the packet that ends the frame.
+// The first packet (off 0) carries the quantisation tables (Q = 255).
+inline size_t rtp_jpeg_fragment(uint8_t* hdr, const RtpJpeg& j, uint32_t off, size_t mtu,
+                                uint16_t seq, uint32_t ts, uint32_t ssrc, size_t* n){
+  size_t hl = RTP_HDR + 8 + (j.type >= 64 ? 4 : 0) + (off == 0 ? 4 + 128 : 0);
+  size_t room = mtu > hl ? mtu - hl : 1;
+  *n = j.scan_len - off < room ? j.scan_len - off : room;
+  bool last = off + *n == j.scan_len;
+
+  uint8_t* p = hdr;
+  *p++ = 0x80;                                                // V=2
+  *p++ = (uint8_t)((last ? 0x80 : 0) | RTP_JPEG_PT);
+  *p++ = (uint8_t)(seq >> 8);  *p++ = (uint8_t)seq;
+  for (int k = 24; k >= 0; k -= 8) *p++ = (uint8_t)(ts >> k);
+  for (int k = 24; k >= 0; k -= 8) *p++ = (uint8_t)(ssrc >> k);
+
+  *p++ = 0;                                                   // type-specific
+  *p++ = (uint8_t)(off >> 16); *p++ = (uint8_t)(off >> 8); *p++ = (uint8_t)off;
+  *p++ = j.type;
+  *p++ = 255;                                                 // Q: tables in-band
+  *p++ = j.w8; *p++ = j.h8;
+  if (j.type >= 64){                                          // packets not aligned to intervals
+    *p++ = (uint8_t)(j.dri >> 8); *p++ = (uint8_t)j.dri;
+    *p++ = 0xFF; *p++ = 0xFF;                                 // F=1, L=1, count 0x3FFF
+  }
+  if (off == 0){
+    *p++ = 0; *p++ = 0;                                       // MBZ, 8-bit precision
+    *p++ = 0; *p++ = 128;
+    memcpy(p, j.q[0], 64); memcpy(p + 64, j.q[1], 64);
+    p += 128;
+  }
+  return (size_t)(p - hdr);
+}
@@ -0,0 +1,70 @@
+#pragma once
+#include <Arduino.h>
+#include "esp_heap_caps.h"
+
+// Fixed-size span recorder (PSRAM). Any task on either core may record; the
+// newest `cap` spans are kept and older ones are overwritten. Export walks
+// the ring oldest -> newest; spans recorded during an export may be torn,
+// which only affects that one dump.
+
+struct Span {
+  const char* name;              // string literal
+  int64_t     ts_us;             // start (esp_timer_get_time)
+  uint32_t    dur_us;
+  uint32_t    arg;               // span-specific (bytes, client, ...)
+  uint32_t    tid;               // task handle bits
+  uint8_t     core;
+};
+
+class SpanTrace {
+public:
+  bool begin(size_t cap){
+    if (ring_) return true;
+    ring_ = (Span*)heap_caps_calloc(cap, sizeof(Span), MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    if (!ring_) return false;
+    cap_ = cap;
+    return true;
+  }
+
+  void record(const char* name, int64_t ts_us, uint32_t dur_us, uint32_t arg){
+    if (!ring_ || !enabled_) return;
+    Span s = { name, ts_us, dur_us, arg,
+               (uint32_t)(uintptr_t)xTaskGetCurrentTaskHandle(), (uint8_t)xPortGetCoreID() };
+    portENTER_CRITICAL(&mux_);
+    ring_[head_ % cap_] = s;
+    head_++;
+    portEXIT_CRITICAL(&mux_);
+  }
+
+  // Spans currently held, oldest first: get(i) for i in [0, count()).
+  size_t count(){
+    portENTER_CRITICAL(&mux_);
+    size_t n = head_ < cap_ ? head_ : cap_;
+    portEXIT_CRITICAL(&mux_);
+    return n;
+  }
+  bool get(size_t i, Span& out){
+    portENTER_CRITICAL(&mux_);
+    size_t n = head_ < cap_ ? head_ : cap_;
+    bool ok = i < n;
+    if (ok) out = ring_[(head_ - n + i) % cap_];
+    portEXIT_CRITICAL(&mux_);
+    return ok;
+  }
+
+  void clear(){
+    portENTER_CRITICAL(&mux_);
+    head_ = 0;
+    portEXIT_CRITICAL(&mux_);
+  }
+  void enable(bool on){ enabled_ = on; }
+  size_t capacity() const { return cap_; }
+  uint32_t recorded() const { return head_; }
+
+private:
+  Span*         ring_    = nullptr;
+  size_t        cap_     = 0;
+  uint32_t      head_    = 0;       // total spans recorded
+  volatile bool enabled_ = true;
+  portMUX_TYPE  mux_     = portMUX_INITIALIZER_UNLOCKED;
+};
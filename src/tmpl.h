@@ -0,0 +1,37 @@
+#pragma once
+#include <Arduino.h>
+
+// Streaming template renderer for PROGMEM pages. Literal text goes straight
+// from flash to `out`; each {{key}} placeholder is handed to `fill`, which
+// writes its value to the same `out`. Nothing is buffered here, so the page
+// size is bounded only by the output (a chunk-sized buffer on the device).
+// Keys are up to TMPL_KEY_MAX - 1 characters without '}'; anything else
+// between braces (CSS, JSON) is literal text.
+//
+//   Out:  void write(const char* p, size_t n)
+//   Fill: void (Out& out, const char* key, size_t klen)
+//
+// PROGMEM is plain memory-mapped flash on the ESP32, so the template is
+// scanned in place.
+
+#define TMPL_KEY_MAX 32
+
+template <class Out, class Fill>
+inline void tmpl_render(Out& out, PGM_P tpl, Fill fill){
+  const char* p = tpl;
+  for (;;){
+    const char* open = strstr(p, "{{");
+    if (!open){ out.write(p, strlen(p)); return; }
+    const char* key = open + 2;
+    size_t      kl  = 0;
+    while (kl < TMPL_KEY_MAX && key[kl] && key[kl] != '}') kl++;
+    if (kl == 0 || kl == TMPL_KEY_MAX || key[kl] != '}' || key[kl+1] != '}'){
+      out.write(p, (size_t)(key - p));                          // not a placeholder: keep "{{"
+      p = key;
+      continue;
+    }
+    out.write(p, (size_t)(open - p));
+    fill(out, key, kl);
+    p = key + kl + 2;
+  }
+}
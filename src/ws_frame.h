@@ -0,0 +1,110 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+// The parts of RFC 6455 that /ws/stream needs: the handshake accept key, the
+// header of an (unmasked, unfragmented) server frame, and an in-place parser
+// for the small masked frames a browser sends. No allocation, no state.
+
+enum : uint8_t { WS_OP_CONT = 0x0, WS_OP_TEXT = 0x1, WS_OP_BINARY = 0x2,
+                 WS_OP_CLOSE = 0x8, WS_OP_PING = 0x9, WS_OP_PONG = 0xA };
+#define WS_MAX_HEADER 10                  // server frames: 2 + 8-byte length
+
+namespace ws_detail {
+
+inline uint32_t rol(uint32_t v, int s){ return (v << s) | (v >> (32 - s)); }
+
+// SHA-1 of a short message (< 120 bytes: the key plus the RFC's GUID), once per handshake.
+inline void sha1(const uint8_t* msg, size_t len, uint8_t out[20]){
+  uint32_t h[5] = { 0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476, 0xC3D2E1F0 };
+  uint8_t  blk[128] = {};
+  size_t   nb = (len + 8) / 64 + 1;         // padded length in 64-byte blocks
+  memcpy(blk, msg, len);
+  blk[len] = 0x80;
+  uint64_t bits = (uint64_t)len * 8;
+  for (int i = 0; i < 8; i++) blk[nb * 64 - 1 - i] = (uint8_t)(bits >> (8 * i));
+  for (size_t b = 0; b < nb; b++){
+    uint32_t w[80];
+    for (int i = 0; i < 16; i++){
+      const uint8_t* p = blk + b * 64 + i * 4;
+      w[i] = (uint32_t)p[0] << 24 | (uint32_t)p[1] << 16 | (uint32_t)p[2] << 8 | p[3];
+    }
+    for (int i = 16; i < 80; i++) w[i] = rol(w[i-3] ^ w[i-8] ^ w[i-14] ^ w[i-16], 1);
+    uint32_t a = h[0], bb = h[1], c = h[2], d = h[3], e = h[4];
+    for (int i = 0; i < 80; i++){
+      uint32_t f, k;
+      if      (i < 20){ f = (bb & c) | (~bb & d);           k = 0x5A827999; }
+      else if (i < 40){ f = bb ^ c ^ d;                     k = 0x6ED9EBA1; }
+      else if (i < 60){ f = (bb & c) | (bb & d) | (c & d);  k = 0x8F1BBCDC; }
+      else            { f = bb ^ c ^ d;                     k = 0xCA62C1D6; }
+      uint32_t t = rol(a, 5) + f + e + k + w[i];
+      e = d; d = c; c = rol(bb, 30); bb = a; a = t;
+    }
+    h[0] += a; h[1] += bb; h[2] += c; h[3] += d; h[4] += e;
+  }
+  for (int i = 0; i < 20; i++) out[i] = (uint8_t)(h[i / 4] >> (24 - 8 * (i % 4)));
+}
+
+} // namespace ws_detail
+
+// Sec-WebSocket-Accept for a client's Sec-WebSocket-Key: base64(SHA-1(key + GUID)).
+// `out` gets 28 characters and a NUL. False if the key is implausibly long.
+inline bool ws_accept_key(const char* key, size_t klen, char out[29]){
+  static const char GUID[] = "258EAFA5-E914-47DA-95CA-C5AB0DC85B11";
+  static const char B64[]  = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+  uint8_t msg[64 + sizeof(GUID)], d[21];
+  if (klen > 64) return false;                // a valid key is 24 characters
+  memcpy(msg, key, klen);
+  memcpy(msg + klen, GUID, sizeof(GUID) - 1);
+  ws_detail::sha1(msg, klen + sizeof(GUID) - 1, d);
+  d[20] = 0;
+  for (int i = 0, o = 0; i < 21; i += 3, o += 4){
+    uint32_t v = (uint32_t)d[i] << 16 | (uint32_t)d[i+1] << 8 | d[i+2];
+    out[o] = B64[v >> 18]; out[o+1] = B64[(v >> 12) & 63]; out[o+2] = B64[(v >> 6) & 63]; out[o+3] = B64[v & 63];
+  }
+  out[27] = '=';                              // 20 bytes: one pad character
+  out[28] = 0;
+  return true;
+}
+
+// Header of a final, unmasked frame carrying `len` payload bytes; returns its size (2, 4 or 10).
+inline size_t ws_header(uint8_t* out, uint8_t opcode, uint64_t len){
+  out[0] = 0x80 | opcode;
+  if (len < 126){ out[1] = (uint8_t)len; return 2; }
+  if (len <= 0xFFFF){ out[1] = 126; out[2] = (uint8_t)(len >> 8); out[3] = (uint8_t)len; return 4; }
+  out[1] = 127;
+  for (int i = 0; i < 8; i++) out[2 + i] = (uint8_t)(len >> (56 - 8 * i));
+  return 10;
+}
+
+struct WsFrame {
+  uint8_t  op;
+  uint8_t* data;                              // unmasked in place
+  size_t   len;
+};
+
+// One client frame from p[0..n). Returns bytes consumed, 0 if incomplete, or
+// -1 on a protocol error (unmasked, fragmented, reserved bits, or a payload
+// over `max_payload`).
+inline long ws_parse(uint8_t* p, size_t n, size_t max_payload, WsFrame* f){
+  if (n < 2) return 0;
+  if ((p[0] & 0x70) || !(p[0] & 0x80) || !(p[1] & 0x80)) return -1;
+  uint64_t len = p[1] & 0x7F;
+  size_t   h   = 2;
+  if (len == 126){ if (n < 4) return 0; len = (uint64_t)p[2] << 8 | p[3]; h = 4; }
+  else if (len == 127){
+    if (n < 10) return 0;
+    len = 0;
+    for (int i = 0; i < 8; i++) len = len << 8 | p[2 + i];
+    h = 10;
+  }
+  if (len > max_payload) return -1;
+  if ((p[0] & 0x0F) >= WS_OP_CLOSE && len > 125) return -1;    // control frames are short
+  if (n < h + 4 + len) return 0;
+  const uint8_t* mask = p + h;
+  uint8_t* d = p + h + 4;
+  for (size_t i = 0; i < len; i++) d[i] ^= mask[i & 3];
+  f->op = p[0] & 0x0F; f->data = d; f->len = (size_t)len;
+  return (long)(h + 4 + len);
+}
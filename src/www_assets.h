@@ -0,0 +1,209 @@
+#pragma once
+// GENERATED by tools/gen_web_assets.py -- do not edit; edit src/www_index.h or web/.
+#include <Arduino.h>
+
+struct WebAsset {
+  const char*    path;
+  const char*    mime;
+  const uint8_t* gz;            // gzip body (PROGMEM)
+  uint32_t       gz_len;
+  uint32_t       raw_len;
+  const char*    etag;          // strong, quoted
+  const char*    cache;         // Cache-Control
+};
+
+static const uint8_t WEB_ASSET_0[] PROGMEM = {
+  0x1f,0x8b,0x08,0x00,0x00,0x00,0x00,0x00,0x02,0xff,0xc5,0x5a,0xeb,0x92,0xdb,0x36,0x96,0xfe,0xef,0xa7,
+  0x80,0xe5,0x89,0x49,0x65,0x44,0x48,0xd4,0xad,0x5b,0x64,0xb3,0x53,0xb6,0x27,0x5e,0x7b,0xca,0x4e,0xb6,
+  0xd2,0x8e,0xe7,0x92,0x4a,0x8d,0x21,0x12,0x14,0x69,0x53,0xa4,0x86,0xa4,0xa4,0x56,0xcb,0x5d,0xb5,0x4f,
+  0xb3,0x0f,0xb6,0x4f,0xb2,0xdf,0x01,0x48,0x8a,0x52,0xcb,0x49,0x66,0xaa,0x66,0xa6,0x2f,0x12,0x08,0x1c,
+  0x1c,0x9c,0xfb,0x05,0xd2,0xa3,0xab,0xc7,0x41,0xe6,0x97,0xbb,0x95,0x64,0x51,0xb9,0x4c,0xae,0xaf,0xaa,
+  0x57,0x29,0x82,0xeb,0x47,0x57,0x4b,0x59,0x0a,0xe6,0x47,0x22,0x2f,0x64,0xe9,0x75,0xd6,0x65,0x68,0x5d,
+  0x76,0xea,0xe9,0x54,0x2c,0xa5,0xd7,0xd9,0xc4,0x72,0xbb,0xca,0xf2,0xb2,0xc3,0xfc,0x2c,0x2d,0x65,0x0a,
+  0xb0,0x6d,0x1c,0x94,0x91,0x17,0xc8,0x4d,0xec,0x4b,0x4b,0x3d,0xf4,0x58,0x9c,0xc6,0x65,0x2c,0x12,0xab,
+  0xf0,0x45,0x22,0x3d,0xbb,0xc7,0xea,0x7d,0x56,0x18,0x97,0x9e,0x9f,0x6d,0x64,0x4e,0x88,0xcb,0xb8,0x4c,
+  0xe4,0xf5,0x77,0xd9,0xdd,0x5d,0x22,0x5f,0x3c,0x7b,0x7b,0xd5,0xd7,0x13,0x8f,0xae,0x8a,0x72,0x47,0xef,
+  0x8c,0x39,0x79,0x96,0x95,0x3d,0x22,0xb2,0x37,0xcf,0x82,0xdd,0x3e,0x92,0xf1,0x22,0x2a,0x1d,0x7b,0x30,
+  0xf8,0xca,0x5d,0x8a,0x7c,0x11,0xa7,0xce,0xe0,0x1e,0x70,0x6a,0x71,0x2e,0xfc,0x4f,0x8b,0x3c,0x5b,0xa7,
+  0x81,0xf3,0x64,0x30,0x18,0xb8,0x7e,0x96,0x64,0xb9,0xf3,0x24,0x0c,0x43,0x37,0x04,0xb5,0x56,0x28,0x96,
+  0x71,0xb2,0x73,0x8a,0x5d,0x51,0xca,0xa5,0xb5,0x8e,0x7b,0xcf,0x72,0x10,0xd9,0x2b,0x44,0x5a,0x58,0x85,
+  0xcc,0xe3,0x90,0x30,0xf1,0xb9,0xc8,0xf7,0x78,0x67,0x6c,0x95,0x15,0xe0,0x22,0x4b,0x9d,0x30,0xbe,0x95,
+  0x81,0x9b,0xc8,0xb0,0x74,0x06,0x6e,0xae,0x08,0x18,0xb8,0x65,0xb6,0xc2,0xeb,0x9d,0x15,0xa7,0x81,0xbc,
+  0x05,0x41,0xae,0xda,0x13,0xc4,0xc5,0x2a,0x11,0x3b,0x27,0x4c,0xe4,0xad,0xbb,0x10,0x2b,0x87,0x4f,0x72,
+  0xb9,0x74,0x45,0x12,0x2f,0x52,0x2b,0xc6,0xb1,0x85,0xe3,0x43,0x6a,0x32,0x77,0x3f,0xae,0x8b,0x32,0x0e,
+  0x77,0x56,0x25,0x47,0xa7,0x58,0x09,0xc8,0x6f,0x2e,0xcb,0xad,0x94,0xa9,0x46,0xb6,0x12,0x41,0x10,0xa7,
+  0x0b,0x8d,0x83,0xf1,0x0b,0x85,0xaa,0xc5,0x64,0xbe,0x98,0x0b,0x73,0xd0,0xa3,0x5f,0x3e,0xee,0xaa,0x95,
+  0x20,0xcf,0x56,0x90,0x71,0x82,0x13,0x9c,0x79,0xb2,0xce,0xcd,0xe9,0xea,0xb6,0x0b,0x64,0x8a,0x33,0xe2,
+  0xa0,0xc7,0x15,0x03,0xfb,0xdf,0x4c,0xa8,0x96,0x49,0x2e,0xd2,0x60,0xdf,0x92,0x67,0x29,0x6f,0x4b,0x2b,
+  0x90,0x7e,0x96,0x0b,0x25,0xa2,0x34,0x4b,0xa5,0x16,0xf2,0x56,0x6b,0x68,0x3a,0x80,0x5e,0xb0,0xb5,0xff,
+  0x35,0x7b,0x2e,0x0a,0xc9,0x62,0xf0,0xc9,0xe6,0xeb,0xb2,0xcc,0xd2,0x82,0x7d,0xdd,0x27,0x95,0xa9,0x07,
+  0x4e,0x0b,0x3d,0x26,0xd4,0xbb,0x96,0xbb,0xb2,0x21,0x67,0x3c,0x5c,0xdd,0xba,0x95,0xba,0xd5,0xb8,0x96,
+  0xc6,0xc0,0xad,0x69,0x8f,0xd3,0x24,0x4e,0x21,0xb3,0x24,0xf3,0x3f,0x69,0x89,0xcd,0xb3,0x3c,0x00,0xe7,
+  0xf6,0xea,0x96,0x15,0x59,0x12,0x07,0xec,0xc9,0x68,0x34,0x72,0xf5,0xac,0x95,0x8b,0x20,0x5e,0x17,0x0e,
+  0x9f,0x9e,0x88,0xf1,0x89,0x6d,0xdb,0x4c,0x33,0xdb,0x1f,0x8e,0xb1,0x55,0xbd,0xa4,0x99,0x95,0xcb,0x95,
+  0x14,0xa5,0xc6,0xec,0xaf,0xf3,0x02,0xcc,0xaf,0xb2,0x58,0x69,0x2f,0x5b,0x97,0x74,0xb6,0xe6,0xfb,0x9c,
+  0x30,0x2a,0x99,0xb7,0x98,0x74,0xc2,0xcc,0x5f,0x17,0xd6,0x26,0x2e,0xe2,0x79,0x22,0x6b,0x96,0x8f,0x67,
+  0xf7,0xf3,0xec,0xd6,0x2a,0x22,0x11,0x64,0x5b,0x67,0xc0,0xe8,0x17,0x9c,0xb3,0x27,0x83,0x59,0x38,0x3d,
+  0xc5,0x16,0x91,0x13,0x35,0x58,0xd4,0x53,0xcb,0x01,0xac,0x4a,0x57,0xf6,0x98,0x7e,0x4f,0xf7,0x0a,0xbf,
+  0x8c,0x37,0x72,0x5f,0x42,0xab,0x45,0x98,0xe5,0x4b,0x47,0x8d,0x12,0x51,0xca,0xbf,0x98,0x90,0x5d,0xf7,
+  0x04,0x9e,0x97,0xd9,0x62,0x91,0x48,0x0e,0x05,0xb5,0xe8,0x8b,0x53,0x44,0x09,0xd6,0xa6,0x52,0x84,0x27,
+  0x1b,0xdb,0x04,0xc5,0x4b,0xb1,0x90,0xce,0x46,0xe4,0xa6,0x85,0xf1,0x42,0x9d,0x21,0x7e,0x03,0x94,0xb6,
+  0xa1,0x9b,0x54,0xac,0x58,0x9f,0xfd,0x40,0x42,0x0e,0x30,0x78,0xb9,0x4e,0x92,0xc2,0xcf,0xe1,0x2a,0xca,
+  0xb2,0x2a,0x93,0x7a,0x52,0x44,0x59,0xb9,0x57,0x3b,0x9d,0x75,0x9e,0x98,0x9d,0x40,0x94,0xc2,0x51,0x38,
+  0xfb,0xc5,0x66,0xf1,0xfb,0xdb,0x65,0xe2,0x22,0xaa,0x5d,0xf6,0xae,0xf0,0xc4,0xf0,0x94,0x16,0x9e,0x11,
+  0x95,0xe5,0xca,0xe9,0xf7,0xb7,0xdb,0x2d,0xdf,0x8e,0x78,0x96,0x2f,0xfa,0x43,0x04,0x0f,0x82,0x37,0x54,
+  0xd8,0x7a,0x9e,0xdd,0x7a,0x86,0x62,0x72,0x8c,0x3f,0xe3,0xfa,0x6a,0x25,0xca,0x88,0xc1,0xc7,0x12,0xcf,
+  0xf8,0x6a,0x38,0x82,0x37,0x18,0x2c,0xf0,0x8c,0xb7,0x33,0x36,0x4e,0x6c,0x3e,0x61,0xc3,0x57,0xf6,0xa5,
+  0x18,0xb2,0x21,0x09,0xc6,0xc6,0xfb,0xe6,0xf0,0x64,0x61,0xf0,0x6a,0xda,0x7a,0xb4,0x86,0xef,0x5b,0xb0,
+  0xd6,0x30,0x1a,0xf2,0xc9,0x1b,0x20,0xba,0x5b,0x8e,0xd8,0x58,0x4c,0xd8,0x04,0x0b,0x88,0x75,0xf8,0x67,
+  0xfa,0x01,0x94,0x59,0xf6,0xe0,0x6e,0x09,0x6a,0xc4,0x88,0x8d,0x68,0x19,0x6b,0x53,0xa6,0xc7,0x03,0x7b,
+  0x60,0x4d,0xef,0x8c,0xfe,0xf5,0x15,0x91,0x7f,0xdd,0x51,0x42,0x7e,0x92,0x4b,0xff,0x5f,0x2e,0x13,0x3f,
+  0xce,0xfd,0x44,0x32,0x1f,0xd3,0xf6,0xd0,0x60,0xfe,0x4e,0xbf,0xe7,0x9e,0x31,0x35,0x0e,0xb2,0x92,0x93,
+  0xd1,0x6c,0x34,0x39,0x43,0x1f,0x99,0xd6,0xbf,0x9a,0x44,0x1c,0x53,0x32,0xcc,0x5d,0x18,0x6c,0xa7,0x5e,
+  0x75,0xe2,0x32,0xec,0x81,0xc1,0x74,0x9c,0xd1,0xe3,0x1c,0x30,0xc3,0x5f,0x25,0x3a,0x2c,0xfe,0x53,0x76,
+  0x36,0x66,0xb3,0xf7,0xe3,0x68,0xb2,0x81,0x25,0x6d,0x46,0xaf,0x60,0x2a,0x50,0xfa,0x04,0xcf,0x93,0x08,
+  0xd6,0x34,0x8d,0xac,0xd1,0xfb,0xf1,0x1d,0x80,0xec,0x49,0x34,0xdc,0x8c,0xa2,0x11,0xe0,0xc6,0x1b,0x6b,
+  0x02,0x30,0xd8,0xc8,0xc6,0x1a,0x61,0x16,0x90,0x93,0x0d,0x8c,0x6d,0x74,0xf7,0x90,0xab,0x7f,0x87,0x26,
+  0xbe,0xe8,0x40,0x17,0xef,0xc7,0x20,0x16,0x84,0xbf,0xbf,0x00,0x71,0xcb,0x19,0x83,0x43,0x80,0x57,0x50,
+  0xab,0x18,0xb9,0x7b,0x7b,0x01,0xb6,0x14,0x04,0xd1,0xff,0xea,0x02,0xec,0x10,0xfb,0x6c,0x04,0xae,0x37,
+  0x43,0x9a,0x24,0x21,0x6c,0x4e,0xf8,0xaa,0x22,0x88,0x2c,0x4b,0xa4,0x8f,0x82,0x2d,0xa4,0xc8,0x1d,0x26,
+  0xd8,0x3c,0x2e,0x59,0xb1,0x14,0x49,0x22,0x73,0x86,0xec,0xc6,0x44,0xc9,0x42,0x91,0x33,0x95,0x1e,0xeb,
+  0x70,0x52,0xed,0xd1,0x79,0xe9,0x3f,0x24,0x16,0x7b,0xc6,0x6d,0xa8,0x73,0xc8,0x67,0x63,0x71,0xc1,0x67,
+  0x17,0x23,0xa6,0x5f,0xab,0x60,0xc0,0x2f,0x2f,0x93,0x21,0x1f,0x8c,0x30,0x9a,0x5c,0x0a,0x3e,0xe1,0x3a,
+  0x4c,0x70,0x84,0x13,0x3e,0x1d,0x27,0x98,0x9e,0x0d,0xad,0x11,0x1f,0x0d,0x0f,0x6b,0x58,0xb0,0xf8,0x70,
+  0x98,0x58,0x43,0x3e,0x9a,0xf1,0xd9,0x94,0xd0,0x5e,0x32,0xf5,0xa2,0x96,0x6d,0x3e,0x1d,0x59,0x7c,0x36,
+  0x49,0x2c,0x3e,0x9a,0x02,0x68,0x32,0x7e,0xd6,0xec,0xb5,0x47,0x7c,0xc6,0x06,0x90,0x37,0xbf,0x6c,0x23,
+  0x9c,0xf0,0xf1,0x50,0x81,0x33,0x02,0xf7,0x31,0x71,0xc1,0x87,0x44,0x93,0x0d,0xb2,0xc6,0x0a,0xa3,0x42,
+  0x48,0x27,0x5a,0x74,0x64,0x9b,0x18,0xd0,0xf2,0x86,0x5f,0x8e,0xd9,0x94,0x0f,0xc6,0x47,0x1c,0x10,0x03,
+  0xc4,0x1b,0x23,0xde,0x80,0x74,0x30,0xe1,0x23,0x1b,0x6f,0x33,0x3e,0x1d,0xaa,0xb7,0xd9,0xb8,0xc0,0x1e,
+  0x42,0xae,0x1e,0xde,0x00,0x33,0x02,0x22,0xbf,0x38,0x62,0x56,0xe3,0x21,0x39,0x30,0x92,0x83,0x0f,0x71,
+  0xf2,0xe1,0x98,0x8f,0xf1,0x80,0xad,0x97,0x24,0x89,0x9a,0x2c,0x9f,0x4f,0x6c,0x3e,0xb6,0x71,0xde,0x60,
+  0xca,0x2f,0xe8,0x5c,0x4d,0x77,0xc3,0x18,0x9d,0x36,0x9c,0xd0,0xdf,0x78,0xa8,0x98,0x8e,0x20,0x08,0x1f,
+  0xcf,0x38,0x8b,0x8f,0x21,0x56,0xfb,0x82,0x4f,0x2c,0x12,0x46,0x2d,0x3a,0xa0,0xbc,0x80,0xb4,0x09,0x97,
+  0x0d,0xda,0x27,0x63,0xd6,0x88,0xb7,0x12,0x3f,0x6d,0xe7,0x24,0x26,0xc2,0x31,0xbd,0x54,0xaa,0x39,0xab,
+  0xb5,0x5a,0xa5,0x8d,0xba,0xef,0xde,0x22,0xc1,0xd8,0x00,0x78,0x36,0x02,0xd0,0x48,0x01,0xa2,0x98,0x19,
+  0xb2,0x4b,0x71,0x98,0x40,0x52,0x80,0x6e,0x27,0x6d,0x9f,0x70,0x5b,0x75,0xd6,0x68,0x7c,0xa8,0xb3,0xd4,
+  0x98,0x1d,0x7e,0xe0,0x36,0xb5,0x87,0x84,0xa8,0xc3,0x57,0x39,0x8a,0x1f,0xed,0x1a,0x48,0xf3,0x87,0xa4,
+  0x5d,0xc4,0x77,0xd2,0x19,0x0e,0xa8,0x72,0x1a,0xb4,0x10,0xb4,0x76,0x2f,0x92,0xdd,0x2a,0x6a,0x76,0x9e,
+  0x2b,0xc7,0xce,0x17,0x6e,0x0f,0xeb,0x19,0xdb,0xd6,0xc4,0xeb,0xe2,0xdf,0x52,0x45,0x39,0xe4,0x47,0x38,
+  0xd8,0xc9,0x0f,0x9d,0x9f,0x28,0x6f,0xa6,0xda,0x1a,0x7e,0xcc,0xc2,0x3c,0x5b,0xb2,0x94,0x78,0xc5,0x79,
+  0x55,0xcd,0xa0,0xe2,0xc3,0x93,0x20,0x69,0x2a,0x62,0xaa,0xde,0x54,0x30,0x2c,0x4a,0xf8,0xf7,0xfe,0xa4,
+  0x0b,0x50,0x55,0x4f,0xab,0x06,0x55,0xf5,0xf3,0x6f,0x28,0xef,0x0f,0xc5,0x34,0xf0,0xe6,0x52,0x2c,0x9b,
+  0xf3,0x74,0xf9,0xaa,0x95,0x81,0x5c,0xbf,0xd9,0xba,0x87,0x26,0x67,0x13,0xb9,0xd9,0xfc,0x23,0x12,0x17,
+  0xf5,0x4d,0x0e,0xe1,0x12,0x71,0xea,0x9e,0xf6,0x39,0x65,0xb6,0xf6,0x23,0x8b,0x8a,0xba,0xaa,0xf8,0xa4,
+  0x63,0x7c,0x91,0x6e,0x44,0x71,0xc2,0x15,0x0c,0x40,0x77,0x56,0x57,0x7d,0xd5,0xf2,0x5d,0x51,0xdf,0x44,
+  0x7d,0xd6,0x55,0x10,0x6f,0x98,0x9f,0x88,0xa2,0xf0,0x3a,0x68,0x80,0x3a,0xd7,0x4a,0xc8,0xed,0x59,0x92,
+  0x74,0x35,0x8d,0x05,0xd1,0x00,0x53,0x67,0xd0,0x61,0x51,0x2e,0x43,0xaf,0xd3,0xef,0xb4,0x9b,0x39,0x51,
+  0x21,0xe9,0x03,0xcb,0x43,0x7c,0x2a,0xce,0xb6,0x11,0xc6,0x81,0xd7,0x09,0x92,0x4e,0x83,0xb8,0x4c,0x3b,
+  0x0c,0x75,0x66,0x9a,0x64,0x20,0xf4,0x46,0x6c,0x24,0xc5,0x46,0xf9,0x7f,0xff,0xf3,0xbf,0x0d,0x66,0x6c,
+  0xd3,0xc5,0xa6,0xda,0x4b,0xb5,0x5f,0xb3,0x9b,0x8a,0xc2,0x0e,0x13,0xe8,0xef,0xac,0x44,0xcc,0x65,0xe2,
+  0x75,0xa8,0x82,0xd4,0x20,0xaa,0xc9,0x6c,0x4d,0xc0,0x2d,0x34,0x9a,0x73,0x58,0x51,0x35,0x1c,0x21,0x65,
+  0xba,0x16,0x3e,0xc6,0xad,0xcb,0xd2,0x06,0x73,0xfd,0xa8,0x40,0x56,0xb9,0x2c,0x0a,0x09,0x4c,0xa1,0x48,
+  0x0a,0xf9,0xcb,0x87,0x85,0x45,0x87,0xfd,0xea,0x61,0x87,0xd2,0xb7,0x39,0xb0,0x3d,0xf5,0xdb,0x0e,0x7d,
+  0x6c,0x59,0xad,0x8c,0x98,0xc9,0x82,0xbd,0x79,0x76,0xf3,0x0e,0xbe,0xc7,0x28,0x2b,0xc6,0x65,0x41,0xe9,
+  0xb0,0x8c,0x64,0x2b,0x25,0xca,0x60,0x21,0x91,0x03,0x4f,0x34,0x56,0xa7,0xc8,0x13,0xc9,0x57,0xf6,0x70,
+  0x58,0x3d,0x52,0x45,0x33,0x5b,0xab,0xa2,0x9e,0xb8,0x7e,0x68,0x35,0xd5,0xa0,0xb6,0x51,0x75,0x26,0x39,
+  0x66,0x6d,0xa2,0xc8,0xc9,0xd5,0x24,0x79,0x15,0x0e,0x4a,0x4a,0xaf,0xf3,0x06,0xed,0x0d,0xab,0x66,0x2a,
+  0x38,0xed,0x0f,0x0a,0xd4,0xdf,0xa8,0x93,0xf4,0x4c,0xfb,0x8c,0x2b,0x08,0x31,0x5e,0x95,0x34,0x45,0x4d,
+  0x45,0xc9,0x80,0xdc,0x0b,0xd0,0xa0,0x2d,0xe1,0xbd,0x7c,0x21,0xcb,0x6f,0x13,0x49,0xc3,0xe7,0xbb,0xd7,
+  0x81,0x69,0x68,0xfc,0x86,0x8a,0xa6,0x1a,0x1c,0x88,0xbf,0x0c,0x8e,0xc5,0x23,0xd8,0xf2,0xd6,0xc3,0x14,
+  0x81,0xbd,0xa0,0x18,0x71,0x5b,0x9a,0xc6,0x30,0x68,0x43,0x04,0xc9,0x97,0x91,0x05,0x49,0x1b,0x12,0xbe,
+  0x72,0x03,0x4b,0xfe,0x05,0x52,0xb1,0x7a,0xb2,0x01,0x46,0xfa,0x65,0x78,0x58,0xfd,0x09,0xf8,0xcb,0x9b,
+  0x2f,0x43,0x87,0x8a,0x31,0x2a,0xb3,0xfa,0x4c,0x49,0x9e,0xca,0x1b,0x46,0x1d,0x29,0xeb,0x6f,0x8b,0xbe,
+  0x96,0x93,0xc3,0x10,0x81,0x50,0x74,0xa5,0x22,0xdf,0xb1,0x25,0xcc,0x13,0x3a,0x64,0x2b,0x80,0xfc,0xf1,
+  0xbf,0xbf,0xfd,0x2f,0x36,0x97,0x51,0x4c,0x35,0x18,0xb3,0xa7,0xd6,0x7c,0x57,0x4a,0x8d,0x8c,0x62,0x14,
+  0x20,0xcc,0x42,0xfe,0xbd,0x87,0x80,0xb6,0x2a,0xd7,0xb9,0x84,0xcd,0x2c,0xd1,0x3d,0x57,0x17,0x4d,0x3a,
+  0x54,0x76,0x39,0xfb,0x56,0xf8,0x11,0xa3,0x1e,0x3c,0x90,0x01,0xe2,0xbc,0x58,0x4a,0x16,0x21,0x32,0x15,
+  0x4c,0xf7,0xe2,0x40,0x06,0xff,0x08,0x60,0xdc,0x14,0x3c,0x7b,0x64,0xe8,0x02,0xd9,0x21,0xdb,0x32,0x7d,
+  0x71,0x85,0xaa,0x10,0x36,0x1f,0xca,0x2d,0xf5,0xd4,0x21,0xbc,0x27,0xa2,0x9c,0x47,0x68,0x60,0x32,0x10,
+  0x01,0x08,0x61,0x59,0xc8,0x84,0x46,0x45,0x38,0x92,0x6c,0xc1,0xd9,0x5b,0x45,0x3c,0x5c,0xa5,0x62,0x92,
+  0xc5,0xa1,0xf2,0x9a,0x02,0x21,0x1d,0xcd,0x71,0x2a,0x49,0x06,0xd9,0x4a,0xa6,0x05,0xc7,0xce,0x04,0x53,
+  0xbe,0x58,0xde,0x94,0xa2,0x2c,0xbc,0x14,0x3e,0x4b,0x12,0x0e,0xd7,0xa9,0x0a,0xdc,0x30,0x57,0x91,0x97,
+  0x37,0x0a,0x8d,0xd9,0xd5,0x15,0x27,0x6d,0xd8,0x16,0x3d,0x42,0x00,0x67,0x56,0xbe,0xdc,0x83,0x2a,0xb7,
+  0xa9,0xda,0xdd,0xc3,0x34,0xdd,0x88,0x34,0xa8,0x18,0x2b,0xf3,0xdd,0x7e,0x0b,0xdc,0x10,0xff,0x9f,0xe4,
+  0xfc,0x46,0x51,0x61,0x7e,0xd8,0x16,0xa8,0x43,0x7f,0xb7,0x47,0x9e,0x51,0xf7,0x13,0x3c,0xca,0x8a,0xf2,
+  0xfe,0xa0,0x99,0x6f,0xb4,0x64,0x0a,0x6f,0xf8,0xa1,0xeb,0xde,0x03,0xc6,0x8f,0x4c,0xd9,0xdd,0xc3,0xf6,
+  0x79,0x91,0xfb,0x9e,0x51,0x81,0x19,0x6e,0x2e,0xa1,0x80,0xd4,0xbd,0xd7,0xd5,0x43,0xc1,0xb5,0x32,0xdf,
+  0xed,0x56,0xd2,0x33,0x44,0x9e,0x8b,0xdd,0x7c,0x1d,0x86,0x32,0x37,0xaa,0x1b,0x13,0x6d,0xe6,0x0a,0xb7,
+  0x67,0x76,0xbd,0xeb,0x7d,0x1c,0x9a,0xd8,0x05,0x5c,0xc1,0x8e,0x64,0x20,0x3d,0xcf,0xb3,0xbb,0x98,0x29,
+  0xc0,0x87,0x69,0xec,0x3b,0x1a,0xb6,0xe3,0xd8,0xf7,0xb0,0xa7,0x7b,0x8d,0x85,0xa8,0xc8,0x54,0x0e,0xf0,
+  0xf4,0x50,0xe6,0x79,0x96,0x37,0xf8,0x1e,0x57,0x32,0xe8,0x56,0xb4,0x61,0x4a,0x09,0xa8,0xfb,0xe3,0x0f,
+  0x6f,0x70,0xd2,0x26,0xfb,0x24,0xbf,0x57,0x09,0x14,0xcf,0xd5,0x8a,0xab,0x25,0x58,0x6d,0x74,0x8f,0x84,
+  0xa8,0x29,0x30,0x9b,0xd3,0xb7,0xd4,0x0f,0x91,0xf8,0xf5,0x81,0x95,0x22,0xca,0x7c,0x2d,0x8f,0x20,0x2a,
+  0x73,0xf6,0x4c,0xb9,0x21,0xb0,0x2a,0x42,0x82,0x16,0xba,0x68,0x85,0xd9,0xc8,0x0d,0xa7,0x8e,0x01,0xfc,
+  0x52,0xd0,0xc0,0x69,0x46,0x77,0xaf,0xc5,0xb3,0xf4,0xfe,0x78,0xf3,0xfd,0x77,0x7c,0x45,0x57,0xae,0x66,
+  0x05,0xd6,0x25,0x2e,0x96,0x9c,0xf6,0xea,0x1d,0x30,0x17,0xa3,0xdb,0x18,0xce,0xf2,0x58,0x0f,0xea,0x9c,
+  0x5a,0x0a,0xfb,0x73,0x6c,0xd7,0x8b,0x2d,0xee,0xaa,0x9d,0x35,0xef,0xb4,0x0b,0x8b,0x50,0xc9,0x61,0x17,
+  0xd9,0xd0,0xf3,0x24,0x9b,0x9b,0x3f,0xd1,0xe8,0x47,0x54,0x7e,0x97,0xcf,0x48,0xc7,0x35,0x95,0x3d,0x7b,
+  0xda,0xfd,0xb9,0xb7,0x27,0x2a,0x1d,0x43,0xb7,0x42,0x1f,0x57,0x72,0x61,0xdc,0x77,0xab,0xf2,0x52,0xeb,
+  0x8e,0x2c,0xa8,0x16,0xb5,0x9a,0x6e,0xcb,0xcd,0x4f,0xb2,0x42,0x6a,0xd1,0x1e,0xfb,0xc5,0x17,0xb4,0xae,
+  0xd7,0x42,0x53,0xeb,0xa1,0x8b,0xec,0xf2,0x0e,0xc1,0x20,0x5b,0x97,0x66,0xcb,0x79,0x7a,0xa8,0x9b,0x06,
+  0x5d,0x57,0x26,0x74,0xeb,0xf8,0xc0,0x86,0xd5,0xf1,0xc4,0xff,0x91,0xbb,0xa9,0xe8,0x75,0xf0,0xc4,0x5d,
+  0xea,0xbf,0xbc,0x79,0xae,0x32,0x66,0xed,0x8a,0x5a,0x5d,0x59,0xea,0x3d,0x7e,0xdc,0xc4,0xc1,0xb0,0x49,
+  0xbb,0x55,0x38,0xac,0x2e,0x21,0x29,0x5a,0x72,0x95,0x0e,0xdf,0xc4,0x45,0x59,0xdd,0x9e,0x99,0x46,0x96,
+  0x1a,0xbd,0x2c,0xed,0xb6,0x81,0xc0,0xc1,0xb3,0x12,0x16,0x81,0xec,0x0c,0x80,0x76,0xea,0x26,0xd0,0x6f,
+  0x0c,0xb2,0x34,0xc3,0x31,0x94,0xe7,0xeb,0x80,0xac,0x6e,0xd8,0xd4,0x5e,0x12,0x5f,0xec,0x7f,0xaa,0xc4,
+  0xa7,0xc8,0x93,0xad,0x8c,0x51,0x0f,0x6a,0xd2,0xc8,0x4c,0xbe,0x4c,0x79,0x97,0x35,0x6b,0xf2,0x36,0x2e,
+  0x0f,0x05,0x05,0x64,0xc3,0xb4,0x28,0x43,0x53,0x26,0xb0,0xad,0xbf,0xaf,0x65,0xd1,0x5a,0xef,0xb2,0x73,
+  0xb3,0xb5,0x07,0x35,0x48,0x45,0x10,0x7c,0xbb,0xc1,0x80,0x04,0x02,0xdd,0xe5,0x48,0x1a,0x0d,0xb0,0x8f,
+  0x40,0xbd,0x90,0x46,0xaf,0x2d,0xf6,0x33,0x1a,0x79,0xa1,0xd2,0xf5,0xbb,0xec,0x35,0xd9,0xda,0xb1,0x5a,
+  0xb6,0xca,0x4a,0x52,0x01,0xb7,0x10,0xc9,0x9f,0x28,0x33,0x7c,0xfe,0x4c,0x33,0x9b,0x38,0x90,0x59,0xeb,
+  0x59,0x25,0x8d,0x76,0x74,0x8a,0xda,0x1b,0x5f,0xa9,0x5c,0xd2,0xda,0xd9,0x9e,0xd0,0x89,0xa6,0x8a,0x49,
+  0x88,0x63,0x4f,0x9f,0x46,0x4f,0x9f,0x9a,0x94,0xc0,0x15,0xd2,0xc7,0x9e,0xb7,0xfd,0xfc,0x99,0x1e,0x35,
+  0x20,0x9e,0xa3,0x2e,0x9c,0xbc,0x5e,0xf7,0xb6,0xee,0x61,0xd1,0x8b,0x94,0x07,0xaa,0xce,0x83,0x42,0x3c,
+  0x2c,0x85,0x5c,0xee,0x4c,0x4a,0x40,0xa4,0x7a,0x89,0x0e,0x8a,0xf2,0xcd,0x9b,0x38,0xfd,0x64,0xae,0xf3,
+  0xa4,0x47,0x55,0x30,0x7d,0x18,0x53,0x49,0x00,0xc4,0x54,0xfb,0x9f,0x3e,0xad,0x06,0x38,0x1c,0x80,0xdd,
+  0x3d,0x65,0x83,0x73,0x01,0xa1,0x02,0x6b,0x07,0xfb,0x7b,0x1d,0x12,0x6a,0x4a,0xb0,0xdd,0x45,0xfd,0xc1,
+  0x55,0x19,0x57,0x3f,0xd4,0xc5,0xb8,0x57,0x53,0xa0,0x66,0x55,0x43,0xc1,0xab,0x36,0xc3,0x33,0xda,0x77,
+  0xf2,0x55,0x22,0x20,0x2e,0xde,0x16,0x0b,0xd3,0x78,0x27,0x56,0xac,0xd3,0xae,0xe4,0x51,0x00,0x66,0x70,
+  0xc4,0x0c,0x59,0x9d,0x92,0x53,0x92,0xec,0x6a,0x23,0xa7,0xcb,0x61,0x52,0x7a,0x4b,0x16,0xd8,0x47,0xf1,
+  0xe8,0x06,0x9d,0x5f,0x69,0x02,0xff,0xbc,0x91,0x44,0x6f,0x19,0x37,0xe2,0xd0,0x7a,0xa5,0x15,0x95,0x05,
+  0x5f,0x62,0x60,0xfe,0x44,0xd0,0x3f,0x1f,0xc0,0x75,0xd0,0xa2,0x4d,0xf7,0xdd,0x43,0xde,0x3c,0x44,0xd3,
+  0x54,0x6c,0xe2,0x85,0x00,0x59,0x1c,0x25,0xe2,0x4d,0x24,0x72,0xf9,0xf4,0xe9,0xc3,0x39,0x73,0x4f,0x08,
+  0x0b,0xe7,0x27,0x7a,0xfb,0x19,0x61,0xaf,0xc6,0x00,0xd2,0xb7,0x02,0x95,0xc6,0x61,0x4b,0xf1,0x10,0xbe,
+  0xa7,0x4a,0x5f,0xc7,0x68,0xfa,0x25,0x04,0x4e,0xf7,0x20,0x2a,0x75,0x02,0x55,0x83,0xac,0x0a,0xf6,0x15,
+  0x6e,0xad,0xa6,0x96,0xde,0x5a,0x4c,0x43,0x4f,0x67,0x23,0x39,0x71,0xff,0x90,0x4f,0xbd,0x47,0x1c,0x02,
+  0x86,0xde,0x56,0xc5,0x03,0x04,0x23,0x3a,0x5c,0xb4,0x2c,0x40,0x9c,0x31,0x80,0x0a,0x57,0x83,0x83,0xda,
+  0x49,0x2e,0x56,0x14,0xf0,0x5f,0x44,0x71,0x12,0x98,0x42,0x21,0x51,0x81,0xca,0x54,0x43,0x34,0xea,0x28,
+  0x0c,0xcd,0x26,0x47,0x1c,0x38,0x86,0x7e,0x03,0xb2,0x87,0x3f,0x54,0xa7,0x50,0x51,0xc9,0x5a,0x21,0x9e,
+  0xe2,0xdc,0x39,0x6b,0x26,0x53,0xef,0x8d,0x54,0xcc,0xd7,0xc2,0x61,0x8d,0x74,0x7e,0xc5,0x81,0x5c,0xd6,
+  0xb8,0x61,0x55,0x41,0x37,0x41,0x55,0x19,0x9f,0xd9,0x24,0xf3,0x96,0xdc,0xce,0x84,0x22,0xf7,0x60,0x3a,
+  0x8f,0x1b,0x8f,0xff,0xfc,0xf9,0xf1,0xc1,0xe3,0xbb,0xfb,0x86,0xcf,0xef,0xb2,0xaa,0x3c,0xdd,0x49,0x2a,
+  0xc9,0x4f,0x72,0x39,0xba,0x02,0x1e,0xe4,0x62,0xab,0x31,0x23,0xf0,0xa8,0x4f,0xf7,0x1a,0xa4,0xbd,0x16,
+  0xca,0xfa,0x54,0x9a,0x2a,0x33,0x95,0xaa,0x35,0xd5,0x4a,0xdf,0x87,0x32,0x44,0xd3,0xa5,0x26,0x0f,0x54,
+  0xd4,0xcd,0x2f,0xfa,0x3b,0x48,0x23,0x78,0x48,0x48,0x6d,0x20,0xa5,0xae,0x26,0xff,0x00,0xd3,0x30,0xbb,
+  0x38,0xe7,0xf5,0xcd,0xf7,0x37,0xaa,0x84,0xc1,0x53,0x2e,0xe1,0xf3,0xbe,0x34,0xfb,0x3f,0x39,0xfc,0xe7,
+  0xfe,0xa2,0x67,0x58,0x46,0x43,0x55,0xed,0x04,0x67,0xdc,0xf6,0x43,0x63,0xf3,0x7f,0xfb,0xdd,0xbe,0x2c,
+  0xee,0xf9,0xc7,0xd5,0xe2,0x43,0xaf,0x5d,0x43,0x34,0x58,0xee,0x8f,0xa6,0x7b,0x03,0x3e,0x9b,0xd4,0x5a,
+  0x6e,0x94,0xfc,0x0b,0x3c,0x29,0xf5,0xd6,0x9d,0x89,0xee,0xca,0xe9,0x1a,0x28,0x5f,0xa7,0xd4,0x17,0xa8,
+  0x4a,0x1d,0x75,0x87,0xcc,0x85,0xc3,0xfa,0xb9,0x5a,0xe6,0xf0,0xd9,0xaa,0x71,0x44,0xe1,0x8f,0x96,0x80,
+  0x0a,0x7c,0x6a,0x01,0x98,0x48,0xd9,0xb3,0xf7,0xaf,0xab,0x56,0x42,0x5f,0xc4,0xa0,0xb6,0x07,0xa8,0x50,
+  0xdd,0x31,0xea,0x23,0x6a,0x29,0xe6,0x79,0xb6,0x2d,0x30,0x5f,0xbb,0x8a,0x4b,0xe1,0x6d,0x85,0x58,0xf6,
+  0x89,0xd0,0x91,0x79,0x87,0x71,0x1a,0x17,0x91,0xee,0xad,0x41,0x66,0xdd,0x17,0xe0,0xf8,0xef,0xd3,0xaa,
+  0xc4,0xc7,0x98,0x8c,0x3e,0x3f,0x93,0x10,0x64,0x09,0x36,0x7e,0x7c,0x6d,0x22,0x43,0xee,0xf5,0x96,0x2c,
+  0x75,0x75,0x37,0xf7,0x0b,0x15,0x47,0x05,0xf0,0x0f,0x56,0x1b,0x55,0xa9,0xf1,0x83,0xfa,0x78,0xe6,0xac,
+  0x5b,0xc0,0xb0,0x14,0x11,0x4d,0xe8,0xf3,0x13,0x29,0xf2,0xda,0x61,0x6b,0x36,0x1a,0x6d,0x92,0x17,0x69,
+  0xab,0x08,0x25,0x29,0xcf,0xa8,0x84,0xde,0x27,0x19,0x19,0xba,0x30,0x57,0x9a,0x3c,0xa8,0x8a,0xcc,0x47,
+  0x69,0xf2,0x8c,0xba,0x49,0xb0,0x47,0xaa,0x56,0xee,0x59,0x4b,0x48,0x71,0xd1,0x98,0xf5,0xa3,0x43,0xf0,
+  0x7c,0x10,0x03,0xe7,0xeb,0x62,0xe7,0xd5,0xf5,0xe7,0x37,0xf5,0x80,0x6b,0xda,0x1c,0x53,0x53,0x6c,0x1e,
+  0x13,0x2e,0x56,0x71,0x55,0x52,0x22,0x4c,0x75,0xf9,0xc7,0x82,0x2a,0xc5,0x6e,0xb5,0xa7,0x15,0x0f,0x08,
+  0x77,0x8b,0xe6,0x03,0x63,0x22,0x51,0x7d,0x10,0xd9,0x62,0xaa,0x1a,0x82,0x63,0x07,0x3c,0x1f,0xe1,0xff,
+  0x39,0x67,0xfc,0x47,0x22,0xbd,0xd1,0xf2,0x83,0x6f,0x0a,0x0c,0xd1,0x42,0x7b,0xa3,0xe9,0x60,0x60,0x1c,
+  0x25,0x80,0x07,0x2e,0x0c,0xf0,0x0f,0xd5,0x37,0x20,0xfe,0xd9,0x5c,0xd0,0x68,0x8e,0xcc,0xb0,0x9a,0x6b,
+  0x3c,0xe1,0x24,0x0f,0x9c,0x68,0xb9,0x47,0x14,0x7e,0x6d,0xd7,0x39,0x40,0xbb,0xfc,0x36,0x4e,0x41,0xef,
+  0x99,0xca,0x33,0xcb,0x63,0x3c,0xab,0x56,0xb8,0x2e,0x3d,0x75,0x3b,0x49,0xcd,0x82,0xaa,0x66,0x9a,0x0f,
+  0xc6,0x3d,0xa3,0xf9,0x64,0xfc,0xaf,0xe6,0xa0,0x6b,0xb8,0x27,0x74,0x9c,0xdd,0x62,0x50,0x07,0x02,0x8b,
+  0x54,0xb4,0x1c,0xf7,0x12,0x2e,0xdd,0xc0,0x56,0x77,0x4c,0x8f,0x9a,0xfb,0xac,0x65,0xb1,0xe8,0x30,0x85,
+  0xc6,0xeb,0x9c,0x5c,0x37,0xcf,0x33,0x6c,0x5c,0x3a,0x36,0xdd,0x6f,0xab,0xbb,0xee,0xc9,0xe0,0x2b,0xf7,
+  0xcc,0xe7,0xf6,0x7f,0x36,0x2d,0xac,0x74,0x4f,0xbf,0xd6,0xd0,0xfe,0x0a,0xcc,0xf1,0xb7,0x49,0xec,0xc3,
+  0xad,0x7b,0x73,0x13,0xaf,0x6e,0xd1,0xd5,0x97,0x38,0xd4,0x8d,0xbe,0x4d,0x9f,0x06,0xb4,0xef,0x8f,0x9b,
+  0x6f,0xbb,0xcc,0x66,0x33,0xba,0x40,0x53,0x97,0x66,0xcd,0x9d,0xd9,0x51,0xd5,0x4a,0xd6,0x4e,0x77,0x5a,
+  0x87,0x3e,0xf7,0x8b,0xb7,0x47,0xe0,0x1e,0x06,0x88,0x7e,0x17,0xe0,0x2f,0xaa,0x2f,0x15,0xd1,0x18,0x53,
+  0x27,0xb5,0x65,0x55,0x54,0x9e,0xe8,0xe0,0x01,0x18,0x91,0x6a,0x54,0x15,0xc1,0x7d,0x4b,0xe0,0x57,0x7d,
+  0x75,0xdb,0x7d,0xd5,0x57,0xdf,0x79,0x7a,0xf4,0xff,0x89,0x36,0x63,0xb2,0x0b,0x25,0x00,0x00,
+};
+
+static const WebAsset WEB_ASSETS[] = {
+  { "/", "text/html", WEB_ASSET_0, 3758, 9483, "\"760d56ac1e12ad68\"", "no-cache" },
+};
+static const size_t WEB_ASSET_COUNT = sizeof(WEB_ASSETS) / sizeof(WEB_ASSETS[0]);
@@ -83,7 +83,27 @@ const char INDEX_HTML[] PROGMEM = R"HTML(
   const btnRec=document.getElementById('rec');
   const btnFS=document.getElementById('fs');
 
-  img.src='/stream';
+  // Live view over /ws/stream: one binary message per JPEG behind a 16-byte
+  // header (seq, capture time, width, height). Each decoded frame hands one
+  // credit back, so a slow device gets fewer, fresher frames instead of a
+  // backlog. MJPEG at /stream if the socket never opens.
+  let camStats=null;
+  function startStream(){
+    let ws,opened=false,shown=null,pending=null;
+    try{ws=new WebSocket(`ws://${location.host}/ws/stream?credits=2`);}catch(e){img.src='/stream';return;}
+    ws.binaryType='arraybuffer';
+    const credit=()=>{if(ws.readyState===1)ws.send('{"credit":1}');};
+    img.onload=img.onerror=()=>{if(!pending)return;if(shown)URL.revokeObjectURL(shown);shown=pending;pending=null;credit();};
+    ws.onopen=()=>{opened=true;};
+    ws.onmessage=(ev)=>{
+      if(typeof ev.data==='string'){const m=JSON.parse(ev.data);if(m.type==='stats')camStats=m;return;}
+      if(pending){URL.revokeObjectURL(pending);credit();}
+      pending=URL.createObjectURL(new Blob([new Uint8Array(ev.data,16)],{type:'image/jpeg'}));
+      img.src=pending;
+    };
+    ws.onclose=()=>{camStats=null;img.onload=img.onerror=null;if(opened)setTimeout(startStream,1000);else img.src='/stream';};
+  }
+  startStream();
 
   function syncFSButton(){
     const on=!!document.fullscreenElement;
@@ -134,39 +154,25 @@ const char INDEX_HTML[] PROGMEM = R"HTML(
     }catch(e){showMsg('Snapshot failed');}
   };
 
-  let rec=null,chunks=[],drawTimer=null;
-  function setRecUI(on){btnRec.classList.toggle('on',on);btnRec.setAttribute('aria-pressed',on?'true':'false');}
-  btnRec.onclick=()=>{
-    if(rec&&rec.state!=='inactive'){clearInterval(drawTimer);drawTimer=null;rec.stop();return;}
-    if(typeof MediaRecorder==='undefined'){showMsg('Recording not supported');return;}
-    syncCanvasToImage();
-    if(!cvs.width||!cvs.height){showMsg('No frame yet');return;}
-    const fps=20;
-    drawTimer=setInterval(()=>{
-      try{
-        if(!img.complete)return;
-        if(img.naturalWidth&&(img.naturalWidth!==cvs.width||img.naturalHeight!==cvs.height)){
-          cvs.width=img.naturalWidth; cvs.height=img.naturalHeight;
-        }
-        ctx.drawImage(img,0,0,cvs.width,cvs.height);
-      }catch(e){}
-    },Math.round(1000/fps));
-    const stream=cvs.captureStream(fps);
-    chunks=[];
-    let mime='video/webm;codecs=vp9';
-    if(!MediaRecorder.isTypeSupported(mime)) mime='video/webm;codecs=vp8';
-    if(!MediaRecorder.isTypeSupported(mime)) mime='video/webm';
-    try{rec=new MediaRecorder(stream,{mimeType:mime,videoBitsPerSecond:5_000_000});}
-    catch(e){showMsg('Recording not supported');clearInterval(drawTimer);return;}
-    rec.ondataavailable=(ev)=>{if(ev.data&&ev.data.size)chunks.push(ev.data);};
-    rec.onstop=async()=>{
-      const type=chunks[0]?.type||'video/webm';
-      const blob=new Blob(chunks,{type});
-      const ts=new Date().toISOString().replace(/[:.]/g,'-');
-      await saveBlobSmart(blob,`NozzleCAM_${ts}.webm`,type);
-      setRecUI(false);
-    };
-    rec.start(1000); setRecUI(true);
+  // Recording runs on the camera: /record.avi streams its JPEGs in an AVI
+  // container straight into a browser download; stop asks it to finish the file.
+  let recOn=false,recTimer=null;
+  function setRecUI(on){recOn=on;btnRec.classList.toggle('on',on);btnRec.setAttribute('aria-pressed',on?'true':'false');}
+  btnRec.onclick=async()=>{
+    if(recOn){
+      clearTimeout(recTimer);
+      try{await fetch('/record/stop');showMsg('Recording saved');}catch(e){showMsg('Stop failed');}
+      setRecUI(false);return;
+    }
+    try{
+      const busy=camStats?camStats.record:(await (await fetch('/api/streams')).json()).record;
+      if(busy){showMsg('Recording already running');return;}
+    }catch(e){}
+    const ts=new Date().toISOString().replace(/[:.]/g,'-');
+    const a=document.createElement('a'); a.href='/record.avi?seconds=3600'; a.download=`NozzleCAM_${ts}.avi`;
+    document.body.appendChild(a); a.click(); a.remove();
+    setRecUI(true);
+    recTimer=setTimeout(()=>setRecUI(false),3600*1000);
   };
 
   window.addEventListener('orientationchange',()=>{img.style.transform='translateZ(0)';setTimeout(()=>img.style.transform='',100);});
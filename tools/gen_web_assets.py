@@ -0,0 +1,119 @@
+"""Build step: gzip the web UI into src/www_assets.h.
+
+Each asset is stored gzipped in flash together with a strong ETag (a hash
+of the uncompressed bytes) and a Cache-Control policy. The firmware serves
+them with Content-Encoding: gzip and answers 304 to If-None-Match.
+
+Sources:
+  - src/www_index.h  (INDEX_HTML raw string, served at "/")
+  - web/*            (any further asset, served at "/<file name>")
+
+Runs as a PlatformIO pre-script (extra_scripts = pre:tools/gen_web_assets.py)
+or by hand: python tools/gen_web_assets.py. The output is only rewritten when
+its content changes, so incremental builds stay incremental.
+"""
+import gzip
+import hashlib
+import io
+import os
+import re
+import sys
+
+MIME = {
+    ".html": "text/html",
+    ".htm": "text/html",
+    ".js": "application/javascript",
+    ".css": "text/css",
+    ".svg": "image/svg+xml",
+    ".png": "image/png",
+    ".ico": "image/x-icon",
+    ".json": "application/json",
+}
+
+# HTML is revalidated on every load (cheap 304); everything else may be
+# reused for a day before the browser asks again.
+CACHE_HTML = "no-cache"
+CACHE_STATIC = "public, max-age=86400"
+
+
+def project_dir():
+    try:
+        Import("env")  # noqa: F821  (PlatformIO SCons context)
+        return env.subst("$PROJECT_DIR")  # noqa: F821
+    except NameError:
+        return os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+
+
+def read_index_html(path):
+    src = open(path, encoding="utf-8").read()
+    m = re.search(r'INDEX_HTML\[\]\s*PROGMEM\s*=\s*R"HTML\((.*)\)HTML"', src, re.S)
+    if not m:
+        sys.exit("gen_web_assets: INDEX_HTML raw string not found in " + path)
+    return m.group(1).encode("utf-8")
+
+
+def collect(root):
+    assets = [("/", "text/html", read_index_html(os.path.join(root, "src", "www_index.h")))]
+    web = os.path.join(root, "web")
+    if os.path.isdir(web):
+        for name in sorted(os.listdir(web)):
+            ext = os.path.splitext(name)[1].lower()
+            if ext not in MIME:
+                continue
+            with open(os.path.join(web, name), "rb") as f:
+                assets.append(("/" + name, MIME[ext], f.read()))
+    return assets
+
+
+def gz(data):
+    buf = io.BytesIO()
+    with gzip.GzipFile(fileobj=buf, mode="wb", compresslevel=9, mtime=0) as g:
+        g.write(data)
+    return buf.getvalue()
+
+
+def render(assets):
+    out = [
+        "#pragma once",
+        "// GENERATED by tools/gen_web_assets.py -- do not edit; edit src/www_index.h or web/.",
+        "#include <Arduino.h>",
+        "",
+        "struct WebAsset {",
+        "  const char*    path;",
+        "  const char*    mime;",
+        "  const uint8_t* gz;            // gzip body (PROGMEM)",
+        "  uint32_t       gz_len;",
+        "  uint32_t       raw_len;",
+        "  const char*    etag;          // strong, quoted",
+        "  const char*    cache;         // Cache-Control",
+        "};",
+        "",
+    ]
+    rows = []
+    for i, (path, mime, raw) in enumerate(assets):
+        z = gz(raw)
+        tag = hashlib.sha1(raw).hexdigest()[:16]
+        cache = CACHE_HTML if mime == "text/html" else CACHE_STATIC
+        out.append("static const uint8_t WEB_ASSET_%d[] PROGMEM = {" % i)
+        for o in range(0, len(z), 20):
+            out.append("  " + ",".join("0x%02x" % b for b in z[o:o + 20]) + ",")
+        out.append("};")
+        rows.append('  { "%s", "%s", WEB_ASSET_%d, %d, %d, "\\"%s\\"", "%s" },'
+                    % (path, mime, i, len(z), len(raw), tag, cache))
+        print("gen_web_assets: %-12s %6d -> %5d bytes gz, etag %s" % (path, len(raw), len(z), tag))
+    out += ["", "static const WebAsset WEB_ASSETS[] = {"] + rows + ["};",
+            "static const size_t WEB_ASSET_COUNT = sizeof(WEB_ASSETS) / sizeof(WEB_ASSETS[0]);", ""]
+    return "\n".join(out)
+
+
+def main():
+    root = project_dir()
+    dst = os.path.join(root, "src", "www_assets.h")
+    text = render(collect(root))
+    old = open(dst, encoding="utf-8").read() if os.path.exists(dst) else None
+    if text != old:
+        with open(dst, "w", encoding="utf-8", newline="\n") as f:
+            f.write(text)
+
+
+main()